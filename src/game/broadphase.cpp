@@ -0,0 +1,95 @@
+#include "game/broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace game {
+
+Broadphase::Broadphase(float world_w, float world_h, float cell_size)
+    : inv_cell_(1.0f / cell_size),
+      cols_(std::max(1, static_cast<int>(std::ceil(world_w / cell_size)))),
+      rows_(std::max(1, static_cast<int>(std::ceil(world_h / cell_size)))) {
+    cell_start_.resize(static_cast<std::size_t>(cols_) * rows_ + 1);
+}
+
+int Broadphase::cell_x(float x) const {
+    return std::clamp(static_cast<int>(x * inv_cell_), 0, cols_ - 1);
+}
+
+int Broadphase::cell_y(float y) const {
+    return std::clamp(static_cast<int>(y * inv_cell_), 0, rows_ - 1);
+}
+
+const std::vector<CollisionPair>& Broadphase::run(const std::vector<Collider>& colliders) {
+    pairs_.clear();
+    std::fill(cell_start_.begin(), cell_start_.end(), 0);
+
+    // Pass 1: count entries per cell (shifted by one for the prefix sum)
+    for (const auto& c : colliders) {
+        int x0 = cell_x(c.min_x), x1 = cell_x(c.max_x);
+        int y0 = cell_y(c.min_y), y1 = cell_y(c.max_y);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                cell_start_[cy * cols_ + cx + 1]++;
+            }
+        }
+    }
+    for (std::size_t i = 1; i < cell_start_.size(); ++i) {
+        cell_start_[i] += cell_start_[i - 1];
+    }
+
+    // Pass 2: scatter, using each cell's start offset as its write cursor
+    cell_items_.resize(cell_start_.back());
+    for (uint32_t i = 0; i < colliders.size(); ++i) {
+        const auto& c = colliders[i];
+        int x0 = cell_x(c.min_x), x1 = cell_x(c.max_x);
+        int y0 = cell_y(c.min_y), y1 = cell_y(c.max_y);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                cell_items_[cell_start_[cy * cols_ + cx]++] = i;
+            }
+        }
+    }
+    // The scatter advanced every start to its cell's end; shift back
+    for (std::size_t i = cell_start_.size() - 1; i > 0; --i) {
+        cell_start_[i] = cell_start_[i - 1];
+    }
+    cell_start_[0] = 0;
+
+    // Narrow test within each cell. A pair spanning several cells is only
+    // reported from the cell holding the top-left corner of the overlap.
+    for (int cy = 0; cy < rows_; ++cy) {
+        for (int cx = 0; cx < cols_; ++cx) {
+            int cell = cy * cols_ + cx;
+            uint32_t begin = cell_start_[cell], end = cell_start_[cell + 1];
+
+            for (uint32_t i = begin; i < end; ++i) {
+                const Collider& a = colliders[cell_items_[i]];
+                uint8_t mask = masks_[a.layer];
+                if (!mask) continue;
+
+                for (uint32_t j = i + 1; j < end; ++j) {
+                    const Collider& b = colliders[cell_items_[j]];
+                    if (!(mask & (1u << b.layer))) continue;
+                    if (a.max_x < b.min_x || b.max_x < a.min_x) continue;
+                    if (a.max_y < b.min_y || b.max_y < a.min_y) continue;
+
+                    if (cell_x(std::max(a.min_x, b.min_x)) != cx
+                        || cell_y(std::max(a.min_y, b.min_y)) != cy) {
+                        continue;
+                    }
+
+                    if (a.layer <= b.layer) {
+                        pairs_.push_back({a.id, b.id, a.layer, b.layer});
+                    } else {
+                        pairs_.push_back({b.id, a.id, b.layer, a.layer});
+                    }
+                }
+            }
+        }
+    }
+
+    return pairs_;
+}
+
+} // namespace game
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/memory_stats.h"
+
+namespace game {
+
+// Axis-aligned box fed to the broadphase. `id` is opaque to it; `layer`
+// selects which other layers the box may collide with.
+struct Collider {
+    float min_x, min_y, max_x, max_y;
+    uint32_t id;
+    uint8_t layer;
+};
+
+struct CollisionPair {
+    uint32_t a;  // Collider::id of the lower layer
+    uint32_t b;
+    uint8_t layer_a;
+    uint8_t layer_b;
+};
+
+// Uniform grid over the map. Each tick the colliders are bucketed into cells
+// with a counting sort (two linear passes into one flat array), then only
+// boxes sharing a cell are tested. Cost is linear in the collider count for
+// a given density; boxes outside the map are clamped into the border cells.
+class Broadphase {
+public:
+    Broadphase(float world_w, float world_h, float cell_size);
+
+    // Bit m of `mask` set means `layer` collides with layer m (keep symmetric)
+    void set_layer_mask(uint8_t layer, uint8_t mask) { masks_[layer] = mask; }
+
+    // Each overlapping pair is reported once. Valid until the next run().
+    const std::vector<CollisionPair>& run(const std::vector<Collider>& colliders);
+
+    std::size_t memory_bytes() const {
+        return memory::heap_bytes(cell_start_) + memory::heap_bytes(cell_items_) + memory::heap_bytes(pairs_);
+    }
+
+private:
+    int cell_x(float x) const;
+    int cell_y(float y) const;
+
+    float inv_cell_;
+    int cols_, rows_;
+    uint8_t masks_[8] = {};
+
+    std::vector<uint32_t> cell_start_;   // cols_*rows_ + 1 offsets into cell_items_
+    std::vector<uint32_t> cell_items_;   // collider indices, grouped by cell
+    std::vector<CollisionPair> pairs_;
+};
+
+} // namespace game
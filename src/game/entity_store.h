@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/memory_stats.h"
+
+namespace game {
+
+enum class EntityKind : uint8_t { ENEMY, ITEM, PROJECTILE };
+
+// Stable reference to an entity. The generation makes handles to destroyed
+// (and possibly recycled) slots detectably stale.
+struct EntityHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const EntityHandle&) const = default;
+
+    // Compact wire id: 16 bits of generation, 16 bits of slot
+    uint32_t wire_id() const { return (generation << 16) | (slot & 0xFFFF); }
+};
+
+// Enemies, items and projectiles for one room, stored as parallel component
+// arrays (structure of arrays) packed densely so per-tick passes walk
+// contiguous memory. Handles map through a sparse slot table; destroyed
+// slots are recycled through a free list and the dense arrays stay packed
+// by swap-removal.
+class EntityStore {
+public:
+    // ── Components (dense, index 0..size()-1) ───────
+    std::vector<EntityKind> kind;
+    std::vector<float> x, y;             // center
+    std::vector<float> vx, vy;
+    std::vector<float> half_w, half_h;   // AABB half extents
+    std::vector<int32_t> health;         // enemies
+    std::vector<int32_t> value;          // item gold / contact or projectile damage
+    std::vector<float> cooldown;         // seconds until the next contact hit / projectile lifetime
+    std::vector<uint32_t> owner;         // projectile shooter, or NO_OWNER if enemy-fired
+
+    static constexpr uint32_t NO_OWNER = UINT32_MAX;
+
+    std::size_t size() const { return kind.size(); }
+    bool empty() const { return kind.empty(); }
+
+    // Heap behind the component arrays and slot table (capacity, not size)
+    std::size_t memory_bytes() const {
+        using memory::heap_bytes;
+        return heap_bytes(kind) + heap_bytes(x) + heap_bytes(y) + heap_bytes(vx) + heap_bytes(vy)
+             + heap_bytes(half_w) + heap_bytes(half_h) + heap_bytes(health) + heap_bytes(value)
+             + heap_bytes(cooldown) + heap_bytes(owner)
+             + heap_bytes(slots_) + heap_bytes(dense_to_slot_) + heap_bytes(free_slots_);
+    }
+
+    EntityHandle create(EntityKind k, float px, float py, float hw, float hh) {
+        uint32_t slot;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slots_.size());
+            slots_.push_back({});
+        }
+
+        auto dense = static_cast<uint32_t>(size());
+        slots_[slot].dense = dense;
+        dense_to_slot_.push_back(slot);
+
+        kind.push_back(k);
+        x.push_back(px);
+        y.push_back(py);
+        vx.push_back(0.0f);
+        vy.push_back(0.0f);
+        half_w.push_back(hw);
+        half_h.push_back(hh);
+        health.push_back(0);
+        value.push_back(0);
+        cooldown.push_back(0.0f);
+        owner.push_back(NO_OWNER);
+
+        return {slot, slots_[slot].generation};
+    }
+
+    bool alive(EntityHandle h) const {
+        return h.slot < slots_.size() && slots_[h.slot].generation == h.generation
+               && slots_[h.slot].dense != DEAD;
+    }
+
+    // Dense index of a live handle (check alive() first)
+    uint32_t index_of(EntityHandle h) const { return slots_[h.slot].dense; }
+
+    EntityHandle handle_at(uint32_t dense) const {
+        uint32_t slot = dense_to_slot_[dense];
+        return {slot, slots_[slot].generation};
+    }
+
+    void destroy(EntityHandle h) {
+        if (!alive(h)) return;
+        destroy_at(slots_[h.slot].dense);
+    }
+
+    // Swap-remove by dense index. The last entity moves into `dense`, so
+    // callers iterating densely must revisit that index.
+    void destroy_at(uint32_t dense) {
+        uint32_t last = static_cast<uint32_t>(size()) - 1;
+        uint32_t slot = dense_to_slot_[dense];
+
+        if (dense != last) {
+            move_component(dense, last);
+            uint32_t moved_slot = dense_to_slot_[last];
+            dense_to_slot_[dense] = moved_slot;
+            slots_[moved_slot].dense = dense;
+        }
+        pop_components();
+        dense_to_slot_.pop_back();
+
+        slots_[slot].dense = DEAD;
+        slots_[slot].generation++;
+        free_slots_.push_back(slot);
+    }
+
+    void clear() {
+        while (!empty()) destroy_at(static_cast<uint32_t>(size()) - 1);
+    }
+
+private:
+    static constexpr uint32_t DEAD = UINT32_MAX;
+
+    struct Slot {
+        uint32_t dense = DEAD;
+        uint32_t generation = 0;
+    };
+
+    void move_component(uint32_t to, uint32_t from) {
+        kind[to] = kind[from];
+        x[to] = x[from];
+        y[to] = y[from];
+        vx[to] = vx[from];
+        vy[to] = vy[from];
+        half_w[to] = half_w[from];
+        half_h[to] = half_h[from];
+        health[to] = health[from];
+        value[to] = value[from];
+        cooldown[to] = cooldown[from];
+        owner[to] = owner[from];
+    }
+
+    void pop_components() {
+        kind.pop_back();
+        x.pop_back();
+        y.pop_back();
+        vx.pop_back();
+        vy.pop_back();
+        half_w.pop_back();
+        half_h.pop_back();
+        health.pop_back();
+        value.pop_back();
+        cooldown.pop_back();
+        owner.pop_back();
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> dense_to_slot_;
+    std::vector<uint32_t> free_slots_;
+};
+
+} // namespace game
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+
+namespace game {
+
+// Q16.16 fixed point. Every operation is integer arithmetic, so the same
+// inputs produce the same bits on any compiler, CPU or client language,
+// which lockstep rooms depend on. Range is ±32768 px with 1/65536 px steps.
+//
+// Products and quotients go through 64 bits and round toward -inf (an
+// arithmetic shift), never toward zero: ports must do the same.
+struct Fixed {
+    static constexpr int FRAC_BITS = 16;
+    static constexpr int32_t ONE = 1 << FRAC_BITS;
+
+    int32_t raw = 0;
+
+    static constexpr Fixed from_raw(int32_t r) { return Fixed{r}; }
+    static constexpr Fixed from_int(int32_t v) { return Fixed{v * ONE}; }
+
+    // Rounds to nearest. Only for constants and state crossing in from the
+    // float world (spawns, reconnects); nothing on the step path converts.
+    static constexpr Fixed from_float(float f) {
+        return Fixed{static_cast<int32_t>(f * ONE + (f >= 0.0f ? 0.5f : -0.5f))};
+    }
+
+    constexpr float to_float() const { return static_cast<float>(raw) / ONE; }
+
+    // Largest integer ≤ value
+    constexpr int32_t floor_int() const { return raw >> FRAC_BITS; }
+
+    constexpr Fixed operator-() const { return Fixed{-raw}; }
+    constexpr Fixed operator+(Fixed o) const { return Fixed{raw + o.raw}; }
+    constexpr Fixed operator-(Fixed o) const { return Fixed{raw - o.raw}; }
+    constexpr Fixed operator*(Fixed o) const {
+        return Fixed{static_cast<int32_t>((static_cast<int64_t>(raw) * o.raw) >> FRAC_BITS)};
+    }
+    constexpr Fixed& operator+=(Fixed o) { raw += o.raw; return *this; }
+    constexpr Fixed& operator-=(Fixed o) { raw -= o.raw; return *this; }
+
+    constexpr auto operator<=>(const Fixed&) const = default;
+};
+
+constexpr Fixed min(Fixed a, Fixed b) { return a < b ? a : b; }
+constexpr Fixed max(Fixed a, Fixed b) { return a < b ? b : a; }
+
+// Floor division for tile lookups (C++ `/` truncates toward zero)
+constexpr int32_t floor_div(int32_t a, int32_t b) {
+    int32_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+} // namespace game
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace game {
+
+// Axis-aligned hitbox, min/max corners in px
+struct Hitbox {
+    float min_x, min_y, max_x, max_y;
+
+    bool overlaps(const Hitbox& o) const {
+        return min_x <= o.max_x && o.min_x <= max_x && min_y <= o.max_y && o.min_y <= max_y;
+    }
+};
+
+// Recent player positions per room, so hits can be judged against what the
+// attacker was seeing. Players are addressed by room slot (Player::slot).
+//
+// Fixed ring of frames, no allocation after construction: recording a tick
+// writes one frame in place, and a query touches at most two frames.
+class LagCompensation {
+public:
+    static constexpr int MAX_SLOTS = 16;
+    static constexpr int CAPACITY = 32;             // frames; ≥ 250 ms up to 120 Hz
+    static constexpr float MAX_REWIND_MS = 250.0f;
+
+    using SlotMask = uint16_t;
+    static_assert(sizeof(SlotMask) * 8 >= MAX_SLOTS);
+
+    struct Frame {
+        int tick = -1;
+        SlotMask present = 0;                       // slot held a live player this tick
+        std::array<float, MAX_SLOTS> x{};
+        std::array<float, MAX_SLOTS> y{};
+
+        void set(int slot, float px, float py) {
+            x[slot] = px;
+            y[slot] = py;
+            present |= static_cast<SlotMask>(1u << slot);
+        }
+    };
+
+    // Start recording `tick`; fill the returned frame with set(). Ticks are
+    // expected in increasing order.
+    Frame& begin_frame(int tick, float tick_seconds) {
+        tick_ms_ = tick_seconds * 1000.0f;
+        head_ = (head_ + 1) % CAPACITY;
+        Frame& f = frames_[head_];
+        f.tick = tick;
+        f.present = 0;
+        if (count_ < CAPACITY) ++count_;
+        return f;
+    }
+
+    // A slot changed hands — forget its past so the new player isn't hit
+    // where the old one stood
+    void forget_slot(int slot) {
+        auto keep = static_cast<SlotMask>(~(1u << slot));
+        for (auto& f : frames_) f.present &= keep;
+    }
+
+    void clear() {
+        count_ = 0;
+        for (auto& f : frames_) f = Frame{};
+    }
+
+    int latest_tick() const { return count_ ? frames_[head_].tick : -1; }
+    int oldest_tick() const { return count_ ? frames_[index_back(count_ - 1)].tick : -1; }
+
+    // Tick (fractional) the attacker was looking at when they acted: half
+    // the round trip ago, plus however far the client renders behind.
+    // Clamped to the rewind window and to what's recorded.
+    float view_tick(float rtt_ms, float interp_delay_ms = 0.0f) const {
+        if (!count_ || tick_ms_ <= 0.0f) return static_cast<float>(latest_tick());
+        float back_ms = std::min(rtt_ms * 0.5f + interp_delay_ms, MAX_REWIND_MS);
+        float t = static_cast<float>(latest_tick()) - back_ms / tick_ms_;
+        return std::max(t, static_cast<float>(oldest_tick()));
+    }
+
+    // Player position at a (fractional) past tick, interpolated between the
+    // two recorded frames around it. False if the slot wasn't present.
+    bool position_at(int slot, float tick, float& out_x, float& out_y) const {
+        const Frame* a;
+        const Frame* b;
+        float t;
+        if (!bracket(tick, a, b, t)) return false;
+
+        SlotMask bit = static_cast<SlotMask>(1u << slot);
+        if (!(a->present & bit) && !(b->present & bit)) return false;
+        if (!(a->present & bit)) a = b;             // joined in between: no interpolation
+        if (!(b->present & bit)) b = a;
+
+        out_x = a->x[slot] + (b->x[slot] - a->x[slot]) * t;
+        out_y = a->y[slot] + (b->y[slot] - a->y[slot]) * t;
+        return true;
+    }
+
+    // Slots whose rewound hitbox (half extents hw, hh) overlaps `area`
+    SlotMask overlap(const Hitbox& area, float tick, float hw, float hh,
+                     SlotMask exclude = 0) const {
+        const Frame* a;
+        const Frame* b;
+        float t;
+        if (!bracket(tick, a, b, t)) return 0;
+
+        SlotMask hits = 0;
+        SlotMask candidates = static_cast<SlotMask>((a->present | b->present) & ~exclude);
+        while (candidates) {
+            int slot = std::countr_zero(static_cast<unsigned>(candidates));
+            candidates &= static_cast<SlotMask>(candidates - 1);
+
+            const Frame* fa = (a->present >> slot) & 1 ? a : b;
+            const Frame* fb = (b->present >> slot) & 1 ? b : a;
+            float x = fa->x[slot] + (fb->x[slot] - fa->x[slot]) * t;
+            float y = fa->y[slot] + (fb->y[slot] - fa->y[slot]) * t;
+            if (area.overlaps({x - hw, y - hh, x + hw, y + hh})) {
+                hits |= static_cast<SlotMask>(1u << slot);
+            }
+        }
+        return hits;
+    }
+
+private:
+    // i frames back from the newest
+    int index_back(int i) const { return (head_ - i + CAPACITY) % CAPACITY; }
+
+    // Frames a (older) and b (newer) around `tick`, t in [0,1] between them.
+    // Ticks are consecutive, so this is arithmetic, not a search.
+    bool bracket(float tick, const Frame*& a, const Frame*& b, float& t) const {
+        if (!count_) return false;
+        int latest = latest_tick();
+        int oldest = oldest_tick();
+        tick = std::clamp(tick, static_cast<float>(oldest), static_cast<float>(latest));
+
+        int lo = static_cast<int>(std::floor(tick));
+        int back_lo = std::min(latest - lo, count_ - 1);
+        int back_hi = std::max(back_lo - 1, 0);
+        a = &frames_[index_back(back_lo)];
+        b = &frames_[index_back(back_hi)];
+        t = back_lo == back_hi ? 0.0f : std::clamp(tick - static_cast<float>(a->tick), 0.0f, 1.0f);
+        return a->tick >= 0;
+    }
+
+    std::array<Frame, CAPACITY> frames_{};
+    int head_ = CAPACITY - 1;
+    int count_ = 0;
+    float tick_ms_ = 0.0f;
+};
+
+} // namespace game
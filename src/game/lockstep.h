@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "game/fixed.h"
+#include "game/lag_compensation.h"
+#include "game/player.h"
+#include "game/tilemap.h"
+
+namespace game {
+
+// Player movement for lockstep rooms, in fixed point. Clients run this same
+// step on the same input frames, so the server only ships inputs; the
+// checksum lets either side notice a divergence. Any change here is a
+// protocol change: clients must match it bit for bit.
+//
+// Indexed by the player's room slot. Movement only, like Motion::step:
+// entities, damage and gold stay in snapshot rooms.
+class LockstepSim {
+public:
+    static constexpr int MAX_PLAYERS = LagCompensation::MAX_SLOTS;
+    static_assert(MAX_PLAYERS <= 16, "active_ is a 16-bit mask");
+
+    struct Body {
+        Fixed x, y, vx, vy;
+        uint8_t grounded = 0;
+        uint8_t facing = static_cast<uint8_t>(Facing::RIGHT);
+    };
+
+    // The float physics constants, converted once
+    static constexpr Fixed MOVE_SPEED    = Fixed::from_float(physics::MOVE_SPEED);
+    static constexpr Fixed JUMP_VELOCITY = Fixed::from_float(physics::JUMP_VELOCITY);
+    static constexpr Fixed GRAVITY       = Fixed::from_float(physics::GRAVITY);
+    static constexpr Fixed HALF_W        = Fixed::from_float(physics::PLAYER_HALF_W);
+    static constexpr Fixed HALF_H        = Fixed::from_float(physics::PLAYER_HALF_H);
+    static constexpr Fixed GROUND_PROBE  = Fixed::from_float(physics::GROUND_PROBE);
+
+    void clear() {
+        bodies_ = {};
+        active_ = 0;
+    }
+
+    void place(int slot, const Body& body) {
+        bodies_[slot] = body;
+        active_ |= static_cast<uint16_t>(1u << slot);
+    }
+    void remove(int slot) { active_ &= static_cast<uint16_t>(~(1u << slot)); }
+
+    bool active(int slot) const { return active_ >> slot & 1; }
+    uint16_t active_mask() const { return active_; }
+    const Body& body(int slot) const { return bodies_[slot]; }
+
+    // One tick for every active slot; actions are game::input bits
+    void step(const std::array<uint8_t, MAX_PLAYERS>& actions, Fixed dt, const Tilemap& map) {
+        for (int s = 0; s < MAX_PLAYERS; ++s) {
+            if (active(s)) step_body(bodies_[s], actions[s], dt, map);
+        }
+    }
+
+    // FNV-1a over the active mask, then each active body's fields as
+    // little-endian bytes in declaration order
+    uint64_t checksum() const {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&](uint32_t v, int bytes) {
+            for (int i = 0; i < bytes; ++i) {
+                h ^= (v >> (8 * i)) & 0xFF;
+                h *= 1099511628211ull;
+            }
+        };
+        mix(active_, 2);
+        for (int s = 0; s < MAX_PLAYERS; ++s) {
+            if (!active(s)) continue;
+            const Body& b = bodies_[s];
+            mix(static_cast<uint32_t>(b.x.raw), 4);
+            mix(static_cast<uint32_t>(b.y.raw), 4);
+            mix(static_cast<uint32_t>(b.vx.raw), 4);
+            mix(static_cast<uint32_t>(b.vy.raw), 4);
+            mix(b.grounded, 1);
+            mix(b.facing, 1);
+        }
+        return h;
+    }
+
+    // Motion::step, step for step
+    static void step_body(Body& b, uint8_t actions, Fixed dt, const Tilemap& map) {
+        b.vx = Fixed{};
+        if (actions & input::LEFT) {
+            b.vx = -MOVE_SPEED;
+            b.facing = static_cast<uint8_t>(Facing::LEFT);
+        }
+        if (actions & input::RIGHT) {
+            b.vx = MOVE_SPEED;
+            b.facing = static_cast<uint8_t>(Facing::RIGHT);
+        }
+        if ((actions & input::JUMP) && b.grounded) {
+            b.vy = JUMP_VELOCITY;
+        }
+
+        b.vy += GRAVITY * dt;
+
+        b.x += map.sweep_x(b.x, b.y, HALF_W, HALF_H, b.vx * dt);
+
+        Fixed dy = b.vy * dt;
+        Fixed moved = map.sweep_y(b.x, b.y, HALF_W, HALF_H, dy);
+        b.y += moved;
+        if (moved != dy) b.vy = Fixed{};
+
+        b.grounded = map.sweep_y(b.x, b.y, HALF_W, HALF_H, GROUND_PROBE) < GROUND_PROBE;
+    }
+
+private:
+    std::array<Body, MAX_PLAYERS> bodies_{};
+    uint16_t active_ = 0;
+};
+
+} // namespace game
@@ -1,16 +1,22 @@
 #pragma once
 
 #include <string>
-#include <vector>
+#include <string_view>
+#include <cstdint>
 #include <cmath>
 #include <algorithm>
 #include <nlohmann/json.hpp>
 
+#include "game/tilemap.h"
+#include "network/rtt.h"
+#include "utils/json_writer.h"
+
 namespace game {
 
 // Simple 2D physics constants — must match the client's Phaser config
 // Client ground: tiles at y=704 (center), top surface at y=688
 // Player body: 32px tall, origin 0.5 → sprite.y when on ground = 688 - 16 = 672
+// MAP_* / GROUND_Y describe the built-in map; loaded maps bring their own.
 namespace physics {
     constexpr float MOVE_SPEED    = 220.0f;   // px/s — matches client PLAYER_SPEED
     constexpr float JUMP_VELOCITY = -420.0f;  // px/s — matches client PLAYER_JUMP
@@ -18,88 +24,176 @@ namespace physics {
     constexpr float GROUND_Y      = 672.0f;   // sprite center Y when standing on ground
     constexpr float MAP_WIDTH     = 1280.0f;
     constexpr float MAP_HEIGHT    = 720.0f;
+    constexpr float PLAYER_HALF_W = 16.0f;    // 32×32 body
+    constexpr float PLAYER_HALF_H = 16.0f;
+    constexpr float GROUND_PROBE  = 0.1f;     // px below the feet that still counts as standing
 }
 
-struct Player {
-    std::string id;
-    std::string name;
-    std::string display_name;
-    bool ready = false;
+// Visual/animation state. Kept as an enum so per-tick updates never touch
+// the heap; the wire strings are interned below.
+enum class PlayerState : uint8_t { IDLE, RUNNING, JUMPING, FALLING, DEAD };
+enum class Facing : uint8_t { LEFT, RIGHT };
 
-    // Position & velocity
+inline const char* player_state_str(PlayerState s) {
+    switch (s) {
+        case PlayerState::IDLE:    return "idle";
+        case PlayerState::RUNNING: return "running";
+        case PlayerState::JUMPING: return "jumping";
+        case PlayerState::FALLING: return "falling";
+        case PlayerState::DEAD:    return "dead";
+    }
+    return "idle";
+}
+
+inline const char* facing_str(Facing f) {
+    return f == Facing::LEFT ? "left" : "right";
+}
+
+// Input actions as a bitmask — one byte per player instead of a vector of strings
+namespace input {
+    constexpr uint8_t LEFT  = 1 << 0;
+    constexpr uint8_t RIGHT = 1 << 1;
+    constexpr uint8_t JUMP  = 1 << 2;
+    constexpr uint8_t ALL   = LEFT | RIGHT | JUMP;
+
+    // Map a client action name to its bit. Unknown actions map to 0.
+    inline uint8_t parse_action(std::string_view action) {
+        if (action == "left")  return LEFT;
+        if (action == "right") return RIGHT;
+        if (action == "jump")  return JUMP;
+        return 0;
+    }
+
+    // Fold one action of an "actions" list into a mask. The list is read in
+    // order and the last direction wins, as it did when each action set vx
+    // in turn: ["left", "right"] moves right, ["right", "left"] moves left.
+    inline uint8_t add_action(uint8_t mask, std::string_view action) {
+        uint8_t bit = parse_action(action);
+        if (bit & (LEFT | RIGHT)) mask &= static_cast<uint8_t>(~(LEFT | RIGHT));
+        return static_cast<uint8_t>(mask | bit);
+    }
+}
+
+// What one movement step reads and writes, as plain data: rooms save it
+// every tick to replay late inputs (game/rollback.h)
+struct Motion {
     float x = 100.0f;
     float y = physics::GROUND_Y;
     float vx = 0.0f;
     float vy = 0.0f;
+    PlayerState state = PlayerState::IDLE;
+    Facing facing = Facing::RIGHT;
+    bool grounded = false;
+    bool alive = true;
 
-    // Stats
-    int health = 100;
-    int max_health = 100;
-    int gold = 0;
-
-    // State
-    std::string state = "idle";     // idle, running, jumping, falling, dead
-    std::string facing = "right";   // left, right
-
-    // Input queue — set each tick from the latest player_input message
-    std::vector<std::string> pending_actions;
-    int last_input_tick = 0;
-
-    // ── Physics update ──────────────────────────────
-    void process_input(float dt) {
-        if (health <= 0) {
-            state = "dead";
+    void step(uint8_t actions, float dt, const Tilemap& map) {
+        if (!alive) {
+            state = PlayerState::DEAD;
             vx = 0;
             return;
         }
 
         vx = 0;
 
-        for (const auto& action : pending_actions) {
-            if (action == "left") {
-                vx = -physics::MOVE_SPEED;
-                facing = "left";
-            }
-            if (action == "right") {
-                vx = physics::MOVE_SPEED;
-                facing = "right";
-            }
-            if (action == "jump" && on_ground()) {
-                vy = physics::JUMP_VELOCITY;
-            }
+        // Masks parsed from JSON hold one direction (input::add_action);
+        // binary inputs with both bits set move right
+        if (actions & input::LEFT) {
+            vx = -physics::MOVE_SPEED;
+            facing = Facing::LEFT;
+        }
+        if (actions & input::RIGHT) {
+            vx = physics::MOVE_SPEED;
+            facing = Facing::RIGHT;
+        }
+        if ((actions & input::JUMP) && grounded) {
+            vy = physics::JUMP_VELOCITY;
         }
 
         // Gravity
         vy += physics::GRAVITY * dt;
 
-        // Integrate position
-        x += vx * dt;
-        y += vy * dt;
+        // Integrate against the tilemap, one axis at a time
+        x += map.sweep_x(x, y, physics::PLAYER_HALF_W, physics::PLAYER_HALF_H, vx * dt);
 
-        // Ground collision
-        if (y >= physics::GROUND_Y) {
-            y = physics::GROUND_Y;
-            vy = 0;
-        }
+        float dy = vy * dt;
+        float moved = map.sweep_y(x, y, physics::PLAYER_HALF_W, physics::PLAYER_HALF_H, dy);
+        y += moved;
+        if (moved != dy) vy = 0;
 
-        // Clamp to map bounds
-        x = std::clamp(x, 0.0f, physics::MAP_WIDTH);
+        // Standing if there's no room to drop a hair further
+        grounded = map.sweep_y(x, y, physics::PLAYER_HALF_W, physics::PLAYER_HALF_H,
+                               physics::GROUND_PROBE) < physics::GROUND_PROBE;
 
         // Update visual state
-        if (!on_ground()) {
-            state = vy < 0 ? "jumping" : "falling";
+        if (!grounded) {
+            state = vy < 0 ? PlayerState::JUMPING : PlayerState::FALLING;
         } else if (std::abs(vx) > 0.1f) {
-            state = "running";
+            state = PlayerState::RUNNING;
         } else {
-            state = "idle";
+            state = PlayerState::IDLE;
         }
+    }
+};
+
+struct Player {
+    std::string id;
+    std::string name;           // also sent as display_name; the protocol has both
+    bool ready = false;
+
+    // Position & velocity
+    float x = 100.0f;
+    float y = physics::GROUND_Y;
+    float vx = 0.0f;
+    float vy = 0.0f;
+
+    // Stats
+    int health = 100;
+    int max_health = 100;
+    int gold = 0;
+
+    // State
+    PlayerState state = PlayerState::IDLE;
+    Facing facing = Facing::RIGHT;
+
+    // Input — set each tick from the latest player_input message (input::* bits)
+    uint8_t pending_actions = 0;
+    int last_input_tick = 0;
+
+    // Set by the last tile collision pass
+    bool grounded = false;
+
+    // Index in the room while connected (lag-compensation history), else NO_SLOT
+    static constexpr uint8_t NO_SLOT = 0xFF;
+    uint8_t slot = NO_SLOT;
+
+    // Round trip to this client, from acked snapshot probes (per connection)
+    network::RttEstimator rtt;
+    int64_t last_probe_acked = 0;
+
+    // ── Physics update ──────────────────────────────
+    Motion motion() const { return {x, y, vx, vy, state, facing, grounded, health > 0}; }
+
+    void set_motion(const Motion& m) {
+        x = m.x;
+        y = m.y;
+        vx = m.vx;
+        vy = m.vy;
+        state = m.state;
+        facing = m.facing;
+        grounded = m.grounded;
+    }
+
+    void process_input(float dt, const Tilemap& map) {
+        Motion m = motion();
+        m.step(pending_actions, dt, map);
+        set_motion(m);
 
         // Clear inputs after processing
-        pending_actions.clear();
+        pending_actions = 0;
     }
 
     bool on_ground() const {
-        return y >= physics::GROUND_Y - 0.1f;
+        return grounded;
     }
 
     // ── Spawn at a given position ───────────────────
@@ -108,20 +202,12 @@ struct Player {
         y = spawn_y;
         vx = 0;
         vy = 0;
+        grounded = true;  // spawn points sit on a floor
         health = max_health;
-        state = "idle";
+        state = PlayerState::IDLE;
     }
 
     // ── Serialization ───────────────────────────────
-    nlohmann::json to_lobby_json() const {
-        return {
-            {"id", id},
-            {"name", name},
-            {"display_name", display_name},
-            {"ready", ready}
-        };
-    }
-
     nlohmann::json to_game_json() const {
         return {
             {"id", id},
@@ -130,10 +216,58 @@ struct Player {
             {"vx", std::round(vx * 10.0f) / 10.0f},
             {"vy", std::round(vy * 10.0f) / 10.0f},
             {"health", health},
-            {"state", state},
-            {"facing", facing}
+            {"state", player_state_str(state)},
+            {"facing", facing_str(facing)}
+        };
+    }
+
+    // Full state, for handing a live match over to a restarted process
+    nlohmann::json to_state_json() const {
+        return {
+            {"id", id},
+            {"name", name},
+            {"ready", ready},
+            {"x", x}, {"y", y}, {"vx", vx}, {"vy", vy},
+            {"health", health},
+            {"max_health", max_health},
+            {"gold", gold},
+            {"state", static_cast<int>(state)},
+            {"facing", static_cast<int>(facing)},
+            {"last_input_tick", last_input_tick}
         };
     }
+
+    static Player from_state_json(const nlohmann::json& j) {
+        Player p;
+        p.id = j.value("id", "");
+        p.name = j.value("name", "");
+        p.ready = j.value("ready", false);
+        p.x = j.value("x", p.x);
+        p.y = j.value("y", p.y);
+        p.vx = j.value("vx", 0.0f);
+        p.vy = j.value("vy", 0.0f);
+        p.health = j.value("health", p.health);
+        p.max_health = j.value("max_health", p.max_health);
+        p.gold = j.value("gold", 0);
+        p.state = static_cast<PlayerState>(j.value("state", 0));
+        p.facing = static_cast<Facing>(j.value("facing", static_cast<int>(Facing::RIGHT)));
+        p.last_input_tick = j.value("last_input_tick", 0);
+        return p;
+    }
+
+    // Same bytes as to_game_json().dump(), written without building a DOM.
+    // Keys are in nlohmann's (sorted) order.
+    void write_game_json(utils::JsonWriter& w) const {
+        w.raw(R"({"facing":")").raw(facing_str(facing))
+         .raw(R"(","health":)").integer(health)
+         .raw(R"(,"id":)").string(id)
+         .raw(R"(,"state":")").raw(player_state_str(state))
+         .raw(R"(","vx":)").rounded(vx)
+         .raw(R"(,"vy":)").rounded(vy)
+         .raw(R"(,"x":)").rounded(x)
+         .raw(R"(,"y":)").rounded(y)
+         .raw('}');
+    }
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+#include <nlohmann/json.hpp>
+
+#include "game/lag_compensation.h"
+#include "game/player.h"
+#include "game/tilemap.h"
+
+namespace game {
+
+struct RollbackStats {
+    uint64_t late_inputs = 0;      // amended into a past tick
+    uint64_t too_late = 0;         // stamped before the window, applied at the next tick
+    uint64_t replays = 0;
+    uint64_t replayed_ticks = 0;
+
+    void merge(const RollbackStats& o) {
+        late_inputs += o.late_inputs;
+        too_late += o.too_late;
+        replays += o.replays;
+        replayed_ticks += o.replayed_ticks;
+    }
+
+    nlohmann::json to_json() const {
+        return {
+            {"late_inputs", late_inputs},
+            {"too_late", too_late},
+            {"replays", replays},
+            {"replayed_ticks", replayed_ticks}
+        };
+    }
+};
+
+// The last few ticks of a room's player movement, each saved before it ran
+// together with the actions it applied. A late input rewrites its tick's
+// actions; replay() then starts over from that tick's saved state and steps
+// forward to the present. Indexed by room slot (Player::slot).
+//
+// State is plain data, so saving or restoring a tick is one memcpy of
+// ~330 bytes instead of a copy of the player map and its strings.
+class Rollback {
+public:
+    static constexpr int MAX_SLOTS = LagCompensation::MAX_SLOTS;
+    static constexpr int CAPACITY = 16;    // saved ticks; the window is at most CAPACITY - 1
+
+    using Actions = std::array<uint8_t, MAX_SLOTS>;
+
+    struct State {
+        std::array<Motion, MAX_SLOTS> bodies;
+        uint16_t active = 0;               // slot bitmask
+    };
+    static_assert(std::is_trivially_copyable_v<State>, "ticks are saved with memcpy");
+
+    struct Frame {
+        int tick = NONE;
+        float dt = 0.0f;
+        State state;                       // before the tick ran
+        Actions actions{};
+    };
+
+    // How far back (in ticks, ≥ 1) a late input may land
+    explicit Rollback(int window) : window_(std::clamp(window, 1, CAPACITY - 1)) {}
+
+    int window() const { return window_; }
+    int newest_tick() const { return newest_; }
+
+    void clear() {
+        for (auto& f : frames_) f.tick = NONE;
+        newest_ = NONE;
+        dirty_from_ = NONE;
+    }
+
+    // Slot to save `tick` into, before simulating it; the caller fills
+    // state and actions
+    Frame& begin_tick(int tick, float dt) {
+        Frame& f = frames_[index(tick)];
+        f.tick = tick;
+        f.dt = dt;
+        newest_ = tick;
+        return f;
+    }
+
+    // An input for `tick`, already simulated: false if it is outside the
+    // window or the slot wasn't in play then
+    bool amend(int tick, int slot, uint8_t actions) {
+        if (newest_ == NONE || tick > newest_ || tick <= newest_ - window_) return false;
+        Frame& f = frames_[index(tick)];
+        if (f.tick != tick || !(f.state.active >> slot & 1)) return false;
+        f.actions[slot] = actions;
+        dirty_from_ = std::min(dirty_from_, tick);
+        return true;
+    }
+
+    bool pending() const { return dirty_from_ != NONE; }
+
+    // Re-simulates from the earliest amended tick through the newest one;
+    // `out` gets the state after it. Returns the ticks replayed (0 = none
+    // pending). Later saves are rewritten along the way, so another late
+    // input can start from them.
+    int replay(const Tilemap& map, State& out) {
+        if (!pending()) return 0;
+        int from = dirty_from_;
+        dirty_from_ = NONE;
+
+        out = frames_[index(from)].state;
+        for (int t = from; t <= newest_; ++t) {
+            Frame& f = frames_[index(t)];
+            if (t != from) f.state = out;
+            step(out, f.actions, f.dt, map);
+        }
+        return newest_ - from + 1;
+    }
+
+    static void step(State& s, const Actions& actions, float dt, const Tilemap& map) {
+        for (int i = 0; i < MAX_SLOTS; ++i) {
+            if (s.active >> i & 1) s.bodies[i].step(actions[i], dt, map);
+        }
+    }
+
+private:
+    static constexpr int NONE = INT_MAX;
+
+    static std::size_t index(int tick) { return static_cast<std::size_t>(tick) % CAPACITY; }
+
+    std::array<Frame, CAPACITY> frames_{};
+    int window_;
+    int newest_ = NONE;
+    int dirty_from_ = NONE;
+};
+
+} // namespace game
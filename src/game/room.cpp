@@ -1,10 +1,23 @@
 #include "game/room.h"
+#include "network/input_frames.h"
+#include "network/messages.h"
+#include "storage/stats_writer.h"
 #include "utils/logger.h"
+#include "utils/memory_stats.h"
+#include "utils/trace.h"
 
 namespace game {
 
-Room::Room(std::string id, int max_players)
-    : id_(std::move(id)), max_players_(max_players) {}
+Room::Room(std::string id, int max_players, std::shared_ptr<const Tilemap> map)
+    : id_(std::move(id)), max_players_(max_players), map_(std::move(map)) {
+    players_.reserve(max_players_);
+    disconnected_players_.reserve(max_players_);
+
+    broadphase_.set_layer_mask(LAYER_PLAYER, 1 << LAYER_ENEMY | 1 << LAYER_ITEM | 1 << LAYER_PROJECTILE);
+    broadphase_.set_layer_mask(LAYER_ENEMY, 1 << LAYER_PLAYER | 1 << LAYER_PROJECTILE);
+    broadphase_.set_layer_mask(LAYER_ITEM, 1 << LAYER_PLAYER);
+    broadphase_.set_layer_mask(LAYER_PROJECTILE, 1 << LAYER_PLAYER | 1 << LAYER_ENEMY);
+}
 
 // ── Player management ───────────────────────────────
 
@@ -19,7 +32,8 @@ bool Room::add_player(const Player& player) {
         // Restore their state from before disconnect
         p = disc_it->second;
         p.name = player.name;  // Update name in case it changed
-        p.display_name = player.display_name;
+        p.rtt = {};            // new connection, new path
+        p.last_probe_acked = 0;
         disconnected_players_.erase(disc_it);
         logger::info("player " + p.id + " (" + p.name + ") reconnected to room " + id_
                      + " at (" + std::to_string((int)p.x) + "," + std::to_string((int)p.y) + ")");
@@ -29,19 +43,20 @@ bool Room::add_player(const Player& player) {
         if (state_ == RoomState::FINISHED) return false;
 
         if (state_ == RoomState::PLAYING) {
-            int idx = next_spawn_ % 4;
-            p.spawn(spawn_positions_[idx][0], spawn_positions_[idx][1]);
-            next_spawn_++;
+            spawn_player(p);
         }
 
         logger::info("player " + p.id + " (" + p.name + ") joined room " + id_);
     }
 
-    players_.emplace(p.id, p);
+    auto [slot_it, _] = players_.emplace(p.id, p);
+    assign_slot(slot_it->second);
+    if (state_ == RoomState::PLAYING) place_body(slot_it->second);
 
     // Room is no longer empty
     empty_since_.reset();
 
+    notify_changed();
     return true;
 }
 
@@ -49,6 +64,8 @@ void Room::remove_player(const std::string& player_id) {
     auto it = players_.find(player_id);
     if (it == players_.end()) return;
 
+    release_slot(it->second);
+
     // If game is in progress, save player state for reconnection
     if (state_ == RoomState::PLAYING) {
         disconnected_players_[player_id] = it->second;
@@ -70,6 +87,8 @@ void Room::remove_player(const std::string& player_id) {
             logger::info("room " + id_ + " is now empty, marked finished");
         }
     }
+
+    notify_changed();
 }
 
 bool Room::has_player(const std::string& player_id) const {
@@ -94,6 +113,10 @@ int Room::player_count() const {
     return static_cast<int>(players_.size());
 }
 
+void Room::start_grace_period() {
+    if (players_.empty()) empty_since_ = Clock::now();
+}
+
 bool Room::should_cleanup() const {
     if (state_ == RoomState::FINISHED && players_.empty()) return true;
 
@@ -117,11 +140,7 @@ void Room::set_player_ready(const std::string& player_id, bool ready) {
 
     it->second.ready = ready;
 
-    broadcast({
-        {"type", "player_ready_state"},
-        {"player_id", player_id},
-        {"ready", ready}
-    });
+    broadcast(network::schema::serialize(network::msg::PlayerReadyState{player_id, ready}));
 
     logger::debug("player " + player_id + " ready=" + (ready ? "true" : "false")
                   + " in room " + id_);
@@ -144,16 +163,12 @@ bool Room::all_ready() const {
 
 // ── Chat ────────────────────────────────────────────
 
-void Room::handle_chat(const std::string& sender_id, const std::string& message) {
-    auto player = get_player(sender_id);
-    if (!player) return;
+void Room::handle_chat(const std::string& sender_id, std::string_view message) {
+    auto it = players_.find(sender_id);
+    if (it == players_.end()) return;
 
-    broadcast({
-        {"type", "chat_message"},
-        {"player_id", sender_id},
-        {"player_name", player->name},
-        {"message", message}
-    });
+    broadcast(network::schema::serialize(
+        network::msg::ChatBroadcast{sender_id, it->second.name, message}));
 }
 
 // ── Gameplay ────────────────────────────────────────
@@ -164,50 +179,58 @@ void Room::start_game() {
     state_ = RoomState::PLAYING;
     tick_ = 0;
     next_spawn_ = 0;
+    entities_.clear();
+    if (history_) history_->clear();
+    if (rollback_) rollback_->clear();
 
     // Spawn all players at different positions
+    if (lockstep_) lockstep_->sim.clear();
     for (auto& [pid, player] : players_) {
-        int idx = next_spawn_ % 4;
-        player.spawn(spawn_positions_[idx][0], spawn_positions_[idx][1]);
-        next_spawn_++;
+        spawn_player(player);
+        place_body(player);
     }
 
-    // Build spawn points array for the client
-    nlohmann::json spawn_points = nlohmann::json::array();
+    // Notify all clients — map_data is serialized once per map
+    network::msg::GameStart start;
+    start.map_data = {map_->map_data_json()};
+    start.spawn_points.reserve(players_.size());
     for (const auto& [pid, player] : players_) {
-        spawn_points.push_back({
-            {"player_id", pid},
-            {"x", player.x},
-            {"y", player.y}
-        });
+        start.spawn_points.push_back({pid, player.x, player.y});
     }
+    broadcast(network::schema::serialize(start));
+    if (lockstep_) broadcast(lockstep_state());
 
-    // Notify all clients
-    broadcast({
-        {"type", "game_start"},
-        {"round", 1},
-        {"map_data", {
-            {"width", physics::MAP_WIDTH},
-            {"height", physics::MAP_HEIGHT},
-            {"ground_y", physics::GROUND_Y}
-        }},
-        {"spawn_points", spawn_points}
-    });
+    // Spectators get the map through the (delayed) stream, ahead of the snapshots
+    spectator_stream_.clear();
+    if (spectators_ > 0) {
+        spectator_stream_.push_event(tick_, game_rejoin_message());
+    }
 
     logger::info("game started in room " + id_ + " with " + std::to_string(player_count()) + " players");
+    notify_changed();
 }
 
 void Room::update(float dt) {
+    simulate(dt);
+    publish();
+}
+
+void Room::simulate(float dt) {
+    ticked_ = false;
     if (state_ != RoomState::PLAYING) return;
+    TRACE_SCOPE_ARG("room", "room.simulate", players_.size());
 
     // Check grace period expiry
     if (empty_since_) {
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
             Clock::now() - *empty_since_).count();
         if (elapsed >= GRACE_SECONDS) {
-            logger::info("room " + id_ + " grace period expired, marking finished");
+            record_match_results();
             state_ = RoomState::FINISHED;
             disconnected_players_.clear();
+            // The directory and the logger's lock belong on the loop thread: publish() does both
+            changed_pending_ = true;
+            expired_pending_ = true;
             return;
         }
     }
@@ -216,24 +239,511 @@ void Room::update(float dt) {
     if (players_.empty()) return;
 
     tick_++;
+    ticked_ = true;
+    if (lockstep_) dt = lockstep_->dt.to_float();
+    tick_ms_ = dt * 1000.0f;
+    auto started = Clock::now();
+
+    if (lockstep_) {
+        // Movement only, in fixed point; clients step the same inputs
+        TRACE_SCOPE("room", "room.step_lockstep");
+        step_lockstep();
+    } else {
+        if (rollback_window_ > 0) {
+            TRACE_SCOPE("room", "room.rollback");
+            step_rollback(dt);
+        }
 
-    // Process pending inputs for each player
-    for (auto& [pid, player] : players_) {
-        player.process_input(dt);
+        // Process pending inputs for each player
+        {
+            TRACE_SCOPE("room", "room.process_input");
+            for (auto& [pid, player] : players_) {
+                player.process_input(dt, *map_);
+            }
+        }
+
+        {
+            TRACE_SCOPE_ARG("room", "room.step_entities", entities_.size());
+            step_entities(dt);
+        }
+    }
+
+    // Final positions for this tick, for rewinding hits later
+    if (!history_) history_ = std::make_unique<LagCompensation>();
+    auto& frame = history_->begin_frame(tick_, dt);
+    for (const auto& [_, player] : players_) {
+        if (player.slot != Player::NO_SLOT && player.health > 0) {
+            frame.set(player.slot, player.x, player.y);
+        }
     }
 
-    // Broadcast game state every tick to connected players
-    broadcast(game_state());
+    auto simulated = Clock::now();
+
+    // Serialize game state for publish() — every tick unless the server is
+    // shedding load. Lockstep players don't get snapshots; spectators do.
+    snapshot_ready_ = lockstep_ ? spectators_ > 0 && spectator_stream_.due(tick_)
+                                : tick_ % snapshot_stride_ == 0;
+    if (snapshot_ready_) {
+        TRACE_SCOPE("room", "room.write_game_state");
+
+        // RTT probe, piggybacked on this snapshot
+        int64_t now_us = network::server_time_us();
+        probe_us_ = 0;
+        if (!lockstep_ && now_us - last_probe_us_ >= PROBE_INTERVAL_US) {
+            probe_us_ = last_probe_us_ = now_us;
+            recent_probes_[next_probe_++ % recent_probes_.size()] = now_us;
+        }
+
+        write_game_state();
+    }
+
+    auto us = [](Clock::duration d) { return std::chrono::duration<float, std::micro>(d).count(); };
+    sim_us_ = us(simulated - started);
+    serialize_us_ = us(Clock::now() - simulated);
+}
+
+void Room::publish() {
+    TRACE_SCOPE("room", "room.publish");
+    if (expired_pending_) {
+        expired_pending_ = false;
+        logger::info("room " + id_ + " grace period expired, marking finished");
+    }
+    if (changed_pending_) {
+        changed_pending_ = false;
+        notify_changed();
+    }
+    if (!ticked_) return;
+    ticked_ = false;
+
+    float send_us = 0.0f;
+    auto started = Clock::now();
+    if (lockstep_) {
+        std::string_view frames = lockstep_->frames;
+        broadcast_binary(frames.substr(0, lockstep_->tick_frame_size));
+        if (frames.size() > lockstep_->tick_frame_size) {
+            broadcast_binary(frames.substr(lockstep_->tick_frame_size));
+        }
+    }
+    if (snapshot_ready_) {
+        snapshot_ready_ = false;
+        if (!lockstep_) broadcast_as(snapshot_buf_, Payload::SNAPSHOT);
+        if (spectators_ > 0 && spectator_stream_.due(tick_)) {
+            spectator_stream_.capture(tick_, snapshot_buf_);
+        }
+    }
+    send_us = std::chrono::duration<float, std::micro>(Clock::now() - started).count();
+    if (spectators_ > 0 && spectator_fn_) {
+        spectator_stream_.release(tick_, [this](std::string_view frame) { spectator_fn_(*this, frame); });
+    }
+
+    cost_.update_us += COST_SMOOTHING * (sim_us_ - cost_.update_us);
+    cost_.publish_us += COST_SMOOTHING * (serialize_us_ + send_us - cost_.publish_us);
+}
+
+void Room::spawn_player(Player& p) {
+    if (map_->spawn_count() == 0) {
+        p.spawn(map_->width_px() / 2, physics::PLAYER_HALF_H);
+        p.grounded = false;
+        return;
+    }
+    auto sp = map_->spawn(static_cast<std::size_t>(next_spawn_) % map_->spawn_count());
+    p.spawn(sp.x, sp.y);
+    next_spawn_++;
+}
+
+// ── Lag compensation ────────────────────────────────
+
+void Room::assign_slot(Player& p) {
+    for (int i = 0; i < LagCompensation::MAX_SLOTS; ++i) {
+        if (!slot_players_[i]) {
+            slot_players_[i] = &p;
+            p.slot = static_cast<uint8_t>(i);
+            if (history_) history_->forget_slot(i);
+            if (rollback_) rollback_->clear();  // saved ticks had someone else here
+            return;
+        }
+    }
+    p.slot = Player::NO_SLOT;  // rooms beyond MAX_SLOTS players go uncompensated
+}
+
+void Room::release_slot(Player& p) {
+    if (p.slot != Player::NO_SLOT) {
+        slot_players_[p.slot] = nullptr;
+        if (lockstep_) lockstep_->sim.remove(p.slot);
+        if (rollback_) rollback_->clear();
+    }
+    p.slot = Player::NO_SLOT;
+}
+
+const Player* Room::player_in_slot(int slot) const {
+    if (slot < 0 || slot >= LagCompensation::MAX_SLOTS) return nullptr;
+    return slot_players_[slot];
+}
+
+LagCompensation::SlotMask Room::rewind_overlap(const Hitbox& area, float rtt_ms,
+                                               uint8_t exclude_slot) const {
+    if (!history_) return 0;
+    LagCompensation::SlotMask exclude = 0;
+    if (exclude_slot != Player::NO_SLOT) {
+        exclude = static_cast<LagCompensation::SlotMask>(1u << exclude_slot);
+    }
+    return history_->overlap(area, history_->view_tick(rtt_ms),
+                            physics::PLAYER_HALF_W, physics::PLAYER_HALF_H, exclude);
 }
 
-void Room::queue_input(const std::string& player_id,
-                       int tick,
-                       const std::vector<std::string>& actions) {
+LagCompensation::SlotMask Room::rewind_overlap_for(uint8_t attacker_slot, const Hitbox& area) const {
+    const Player* attacker = player_in_slot(attacker_slot);
+    if (!attacker || !history_) return 0;
+    auto exclude = static_cast<LagCompensation::SlotMask>(1u << attacker_slot);
+    float view = history_->view_tick(attacker->rtt.srtt_ms(), interp_delay_ms(*attacker));
+    return history_->overlap(area, view, physics::PLAYER_HALF_W, physics::PLAYER_HALF_H, exclude);
+}
+
+// ── Latency ─────────────────────────────────────────
+
+bool Room::record_probe_ack(const std::string& player_id, int64_t probe_us, float hold_ms, int64_t now_us) {
+    auto it = players_.find(player_id);
+    if (it == players_.end()) return false;
+    Player& p = it->second;
+
+    // Only probes this room sent, each counted once
+    if (probe_us <= p.last_probe_acked
+        || std::find(recent_probes_.begin(), recent_probes_.end(), probe_us) == recent_probes_.end()) {
+        return false;
+    }
+    float rtt_ms = static_cast<float>(now_us - probe_us) / 1000.0f;
+    if (rtt_ms > MAX_RTT_MS) return false;
+    rtt_ms -= std::clamp(hold_ms, 0.0f, rtt_ms);
+
+    p.last_probe_acked = probe_us;
+    p.rtt.add_sample(rtt_ms);
+    rtt_hist_.add(rtt_ms);
+    return true;
+}
+
+void Room::handle_time_sync(const std::string& player_id, double client_time, int64_t recv_us) {
     auto it = players_.find(player_id);
     if (it == players_.end()) return;
+    const Player& p = it->second;
+
+    network::msg::TimeSync reply;
+    reply.client_time = client_time;
+    reply.server_recv_us = recv_us;
+    reply.server_tick = tick_;
+    reply.tick_ms = network::wire_ms(tick_ms_);
+    reply.snapshot_ms = network::wire_ms(snapshot_interval_ms());
+    reply.interp_ms = network::wire_ms(interp_delay_ms(p));
+    reply.rtt_ms = network::wire_ms(p.rtt.srtt_ms());
+    reply.jitter_ms = network::wire_ms(p.rtt.jitter_ms());
+    reply.server_send_us = network::server_time_us();
+    send_to(player_id, network::schema::serialize(reply));
+}
+
+float Room::interp_delay_ms(const Player& p) const {
+    return 2.0f * snapshot_interval_ms() + 2.0f * p.rtt.jitter_ms();
+}
+
+nlohmann::json Room::rtt_json() const {
+    nlohmann::json players = nlohmann::json::array();
+    for (const auto& [pid, p] : players_) {
+        players.push_back({
+            {"id", pid},
+            {"srtt_ms", network::wire_ms(p.rtt.srtt_ms())},
+            {"jitter_ms", network::wire_ms(p.rtt.jitter_ms())},
+            {"min_ms", network::wire_ms(p.rtt.min_ms())},
+            {"samples", p.rtt.samples()}
+        });
+    }
+    return {
+        {"room_id", id_},
+        {"histogram", rtt_hist_.to_json()},
+        {"players", std::move(players)}
+    };
+}
+
+void Room::queue_input(const std::string& player_id, int tick, uint8_t actions) {
+    auto it = players_.find(player_id);
+    if (it == players_.end()) return;
+    Player& p = it->second;
+
+    // Already simulated: rewrite that tick, replayed by the next simulate()
+    if (rollback_ && tick <= tick_ && p.slot != Player::NO_SLOT) {
+        if (rollback_->amend(tick, p.slot, actions)) {
+            rollback_stats_.late_inputs++;
+            p.last_input_tick = std::max(p.last_input_tick, tick);
+            return;
+        }
+        rollback_stats_.too_late++;
+    }
 
-    it->second.pending_actions = actions;
-    it->second.last_input_tick = tick;
+    p.pending_actions = actions;
+    p.last_input_tick = tick;
+}
+
+// ── Rollback ────────────────────────────────────────
+
+void Room::step_rollback(float dt) {
+    if (!rollback_) rollback_ = std::make_unique<Rollback>(rollback_window_);
+
+    Rollback::State corrected;
+    if (int replayed = rollback_->replay(*map_, corrected)) {
+        rollback_stats_.replays++;
+        rollback_stats_.replayed_ticks += static_cast<uint64_t>(replayed);
+        for (auto& [_, p] : players_) {
+            if (p.slot != Player::NO_SLOT && (corrected.active >> p.slot & 1)) {
+                p.set_motion(corrected.bodies[p.slot]);
+            }
+        }
+    }
+
+    auto& saved = rollback_->begin_tick(tick_, dt);
+    saved.state.active = 0;
+    saved.actions = {};
+    for (const auto& [_, p] : players_) {
+        if (p.slot == Player::NO_SLOT) continue;
+        saved.state.bodies[p.slot] = p.motion();
+        saved.state.active |= static_cast<uint16_t>(1u << p.slot);
+        saved.actions[p.slot] = p.pending_actions;
+    }
+}
+
+// ── Lockstep ────────────────────────────────────────
+
+bool Room::enable_lockstep(float tick_dt, int checksum_interval) {
+    if (state_ != RoomState::WAITING || max_players_ > LockstepSim::MAX_PLAYERS) return false;
+    if (!lockstep_) lockstep_ = std::make_unique<Lockstep>();
+    lockstep_->dt = Fixed::from_float(tick_dt);
+    lockstep_->checksum_interval = std::max(1, checksum_interval);
+    return true;
+}
+
+void Room::place_body(const Player& p) {
+    if (!lockstep_ || p.slot == Player::NO_SLOT) return;
+    // Rounded from the float state: whoever joins triggers a lockstep_state,
+    // so clients take these values rather than computing them
+    LockstepSim::Body b;
+    b.x = Fixed::from_float(p.x);
+    b.y = Fixed::from_float(p.y);
+    b.vx = Fixed::from_float(p.vx);
+    b.vy = Fixed::from_float(p.vy);
+    b.grounded = p.grounded;
+    b.facing = static_cast<uint8_t>(p.facing);
+    lockstep_->sim.place(p.slot, b);
+}
+
+void Room::step_lockstep() {
+    auto& ls = *lockstep_;
+
+    // Actions hold until the player sends new ones
+    std::array<uint8_t, LockstepSim::MAX_PLAYERS> actions{};
+    for (const auto& [_, p] : players_) {
+        if (p.slot != Player::NO_SLOT) actions[p.slot] = p.pending_actions & input::ALL;
+    }
+    ls.sim.step(actions, ls.dt, *map_);
+
+    // TICK lists slots up to the highest occupied one
+    std::array<uint8_t, LockstepSim::MAX_PLAYERS> slots{};
+    std::size_t count = 0;
+    for (int s = 0; s < LockstepSim::MAX_PLAYERS; ++s) {
+        if (!ls.sim.active(s)) continue;
+        slots[s] = network::frames::PRESENT | actions[s];
+        count = static_cast<std::size_t>(s) + 1;
+    }
+    ls.frames.clear();
+    network::frames::write_tick(ls.frames, static_cast<uint32_t>(tick_), slots.data(), count);
+    ls.tick_frame_size = ls.frames.size();
+    if (tick_ % ls.checksum_interval == 0) {
+        network::frames::write_checksum(ls.frames, static_cast<uint32_t>(tick_), ls.sim.checksum());
+    }
+
+    // Mirrored into the players for spectators, lag compensation and handoff
+    for (auto& [_, p] : players_) {
+        if (p.slot == Player::NO_SLOT || !ls.sim.active(p.slot)) continue;
+        const auto& b = ls.sim.body(p.slot);
+        p.x = b.x.to_float();
+        p.y = b.y.to_float();
+        p.vx = b.vx.to_float();
+        p.vy = b.vy.to_float();
+        p.grounded = b.grounded;
+        p.facing = static_cast<Facing>(b.facing);
+        if (!p.grounded) {
+            p.state = p.vy < 0 ? PlayerState::JUMPING : PlayerState::FALLING;
+        } else {
+            p.state = b.vx.raw != 0 ? PlayerState::RUNNING : PlayerState::IDLE;
+        }
+    }
+}
+
+std::string Room::lockstep_state() const {
+    if (!lockstep_) return {};
+    const auto& ls = *lockstep_;
+    network::msg::LockstepState msg{tick_, ls.dt.raw, ls.checksum_interval, {}};
+    msg.players.reserve(players_.size());
+    for (const auto& [_, p] : players_) {
+        if (p.slot == Player::NO_SLOT || !ls.sim.active(p.slot)) continue;
+        const auto& b = ls.sim.body(p.slot);
+        msg.players.push_back({p.id, p.slot, b.x.raw, b.y.raw, b.vx.raw, b.vy.raw,
+                               b.grounded != 0, b.facing});
+    }
+    return network::schema::serialize(msg);
+}
+
+void Room::request_resync(const std::string& player_id, int tick) {
+    if (!lockstep_ || !has_player(player_id)) return;
+    lockstep_->resyncs++;
+    logger::warn("lockstep: player " + player_id + " in room " + id_ + " diverged at tick "
+                 + std::to_string(tick) + " (now " + std::to_string(tick_) + "), resyncing");
+    send_to(player_id, lockstep_state());
+}
+
+// ── Memory ──────────────────────────────────────────
+
+Room::MemoryUse Room::memory_use() const {
+    MemoryUse m;
+    m.room = sizeof(Room) + entities_.memory_bytes() + broadphase_.memory_bytes()
+           + memory::heap_bytes(colliders_) + memory::heap_bytes(collider_players_)
+           + memory::heap_bytes(entity_dead_) + (history_ ? sizeof(LagCompensation) : 0)
+           + (lockstep_ ? sizeof(Lockstep) + memory::heap_bytes(lockstep_->frames) : 0)
+           + (rollback_ ? sizeof(Rollback) : 0);
+
+    for (const auto* players : {&players_, &disconnected_players_}) {
+        m.players += memory::hash_map_bytes(*players);
+        for (const auto& [id, p] : *players) {
+            m.players += memory::heap_bytes(id) + memory::heap_bytes(p.id) + memory::heap_bytes(p.name);
+        }
+    }
+
+    m.buffers = memory::heap_bytes(snapshot_buf_) + spectator_stream_.memory_bytes();
+    return m;
+}
+
+// ── Entities ────────────────────────────────────────
+
+EntityHandle Room::spawn_enemy(float x, float y, int health, int contact_damage) {
+    auto h = entities_.create(EntityKind::ENEMY, x, y, 16.0f, 16.0f);
+    auto i = entities_.index_of(h);
+    entities_.health[i] = health;
+    entities_.value[i] = contact_damage;
+    return h;
+}
+
+EntityHandle Room::spawn_item(float x, float y, int gold) {
+    auto h = entities_.create(EntityKind::ITEM, x, y, 8.0f, 8.0f);
+    entities_.value[entities_.index_of(h)] = gold;
+    return h;
+}
+
+EntityHandle Room::spawn_projectile(float x, float y, float vx, float vy, int damage, uint32_t owner) {
+    auto h = entities_.create(EntityKind::PROJECTILE, x, y, 4.0f, 4.0f);
+    auto i = entities_.index_of(h);
+    entities_.vx[i] = vx;
+    entities_.vy[i] = vy;
+    entities_.value[i] = damage;
+    entities_.cooldown[i] = PROJECTILE_LIFETIME;
+    entities_.owner[i] = owner;
+    return h;
+}
+
+void Room::step_entities(float dt) {
+    auto& e = entities_;
+    auto n = static_cast<uint32_t>(e.size());
+    if (n == 0) return;
+
+    entity_dead_.assign(n, 0);
+    colliders_.clear();
+    collider_players_.clear();
+
+    // Integrate — straight passes over the component arrays
+    for (uint32_t i = 0; i < n; ++i) {
+        e.x[i] += e.vx[i] * dt;
+        e.y[i] += e.vy[i] * dt;
+        e.cooldown[i] -= dt;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        switch (e.kind[i]) {
+            case EntityKind::ENEMY:
+                // Walk back and forth inside the map
+                if ((e.x[i] < 0.0f && e.vx[i] < 0.0f)
+                    || (e.x[i] > map_->width_px() && e.vx[i] > 0.0f)) {
+                    e.vx[i] = -e.vx[i];
+                }
+                break;
+            case EntityKind::PROJECTILE:
+                if (e.cooldown[i] <= 0.0f || e.x[i] < 0.0f || e.x[i] > map_->width_px()
+                    || e.y[i] < 0.0f || e.y[i] > map_->height_px()) {
+                    entity_dead_[i] = 1;
+                }
+                break;
+            case EntityKind::ITEM:
+                break;
+        }
+    }
+
+    // Broadphase input: live players, then every live entity
+    for (auto& [_, p] : players_) {
+        if (p.health <= 0) continue;
+        colliders_.push_back({p.x - physics::PLAYER_HALF_W, p.y - physics::PLAYER_HALF_H,
+                              p.x + physics::PLAYER_HALF_W, p.y + physics::PLAYER_HALF_H,
+                              static_cast<uint32_t>(collider_players_.size()), LAYER_PLAYER});
+        collider_players_.push_back(&p);
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        if (entity_dead_[i]) continue;
+        uint8_t layer = e.kind[i] == EntityKind::ENEMY ? LAYER_ENEMY
+                      : e.kind[i] == EntityKind::ITEM  ? LAYER_ITEM
+                                                       : LAYER_PROJECTILE;
+        colliders_.push_back({e.x[i] - e.half_w[i], e.y[i] - e.half_h[i],
+                              e.x[i] + e.half_w[i], e.y[i] + e.half_h[i], i, layer});
+    }
+
+    // Pairs come ordered by layer: (player, *) and (enemy, projectile)
+    for (const auto& pair : broadphase_.run(colliders_)) {
+        uint32_t b = pair.b;
+        if (entity_dead_[b]) continue;
+
+        if (pair.layer_a == LAYER_PLAYER) {
+            Player& p = *collider_players_[pair.a];
+            if (p.health <= 0) continue;
+
+            switch (pair.layer_b) {
+                case LAYER_ENEMY:
+                    if (e.cooldown[b] > 0.0f) break;
+                    record_stat(p, storage::Stat::DAMAGE_TAKEN, std::min(p.health, e.value[b]));
+                    p.health = std::max(0, p.health - e.value[b]);
+                    e.cooldown[b] = CONTACT_COOLDOWN;
+                    if (p.health == 0) record_stat(p, storage::Stat::DEATHS, 1);
+                    break;
+                case LAYER_ITEM:
+                    p.gold += e.value[b];
+                    record_stat(p, storage::Stat::GOLD_EARNED, e.value[b]);
+                    entity_dead_[b] = 1;
+                    break;
+                case LAYER_PROJECTILE:
+                    if (e.owner[b] != EntityStore::NO_OWNER) break;
+                    record_stat(p, storage::Stat::DAMAGE_TAKEN, std::min(p.health, e.value[b]));
+                    p.health = std::max(0, p.health - e.value[b]);
+                    entity_dead_[b] = 1;
+                    if (p.health == 0) record_stat(p, storage::Stat::DEATHS, 1);
+                    break;
+            }
+        } else if (pair.layer_a == LAYER_ENEMY && pair.layer_b == LAYER_PROJECTILE) {
+            uint32_t a = pair.a;
+            if (entity_dead_[a] || e.owner[b] == EntityStore::NO_OWNER) continue;
+            e.health[a] -= e.value[b];
+            entity_dead_[b] = 1;
+            if (e.health[a] <= 0) {
+                entity_dead_[a] = 1;
+                if (const Player* shooter = player_in_slot(static_cast<int>(e.owner[b]))) {
+                    record_stat(*shooter, storage::Stat::ENEMIES_KILLED, 1);
+                }
+            }
+        }
+    }
+
+    // Highest index first, so swap-removal only ever moves survivors
+    for (uint32_t i = n; i-- > 0;) {
+        if (entity_dead_[i]) entities_.destroy_at(i);
+    }
 }
 
 // ── Broadcasting ────────────────────────────────────
@@ -242,43 +752,171 @@ void Room::set_broadcast_fn(BroadcastFn fn) {
     broadcast_fn_ = std::move(fn);
 }
 
-void Room::broadcast(const nlohmann::json& msg) {
+void Room::broadcast(std::string_view serialized) {
+    broadcast_as(serialized, Payload::TEXT);
+}
+
+void Room::broadcast_binary(std::string_view frame) {
+    broadcast_as(frame, Payload::BINARY);
+}
+
+void Room::broadcast_as(std::string_view message, Payload kind) {
     if (!broadcast_fn_) return;
-    std::string serialized = msg.dump();
     for (const auto& [pid, _] : players_) {
-        broadcast_fn_(pid, serialized);
+        broadcast_fn_(pid, message, kind);
     }
 }
 
-void Room::broadcast_except(const std::string& exclude_id, const nlohmann::json& msg) {
+void Room::broadcast_except(const std::string& exclude_id, std::string_view serialized) {
     if (!broadcast_fn_) return;
-    std::string serialized = msg.dump();
     for (const auto& [pid, _] : players_) {
         if (pid != exclude_id) {
-            broadcast_fn_(pid, serialized);
+            broadcast_fn_(pid, serialized, Payload::TEXT);
         }
     }
 }
 
-void Room::send_to(const std::string& player_id, const nlohmann::json& msg) {
+void Room::send_to(const std::string& player_id, std::string_view serialized) {
     if (!broadcast_fn_) return;
-    broadcast_fn_(player_id, msg.dump());
+    broadcast_fn_(player_id, serialized, Payload::TEXT);
 }
 
-// ── State snapshots ─────────────────────────────────
+void Room::set_change_fn(ChangeFn fn) {
+    change_fn_ = std::move(fn);
+}
 
-nlohmann::json Room::lobby_state() const {
-    nlohmann::json players_arr = nlohmann::json::array();
-    for (const auto& [_, p] : players_) {
-        players_arr.push_back(p.to_lobby_json());
+// ── Player stats ────────────────────────────────────
+
+void Room::record_stat(const Player& p, storage::Stat stat, int64_t value) const {
+    if (stats_) stats_->record(p.id, stat, value);
+}
+
+// Everyone who took part has left by now (grace expiry), so their final
+// state is in disconnected_players_
+void Room::record_match_results() {
+    for (const auto& [pid, player] : disconnected_players_) {
+        record_stat(player, storage::Stat::MATCHES_PLAYED, 1);
+        record_stat(player, storage::Stat::BEST_MATCH_GOLD, player.gold);
     }
-    return {
-        {"type", "lobby_state"},
-        {"room_id", id_},
-        {"state", room_state_str(state_)},
+}
+
+// ── Spectators ──────────────────────────────────────
+
+void Room::set_spectator_fn(SpectatorFn fn) {
+    spectator_fn_ = std::move(fn);
+}
+
+void Room::configure_spectators(int interval_ticks, int delay_ticks) {
+    spectator_stream_.configure(interval_ticks, delay_ticks);
+}
+
+void Room::add_spectator() {
+    spectators_++;
+}
+
+void Room::remove_spectator() {
+    if (spectators_ > 0 && --spectators_ == 0) {
+        spectator_stream_.clear();
+    }
+}
+
+void Room::notify_changed() {
+    if (change_fn_) change_fn_(*this);
+}
+
+// ── Hot restart handoff ─────────────────────────────
+
+nlohmann::json Room::to_handoff_json() const {
+    nlohmann::json players = nlohmann::json::array();
+    for (const auto& [_, p] : players_) players.push_back(p.to_state_json());
+    for (const auto& [_, p] : disconnected_players_) players.push_back(p.to_state_json());
+
+    const auto& e = entities_;
+    nlohmann::json entities = nlohmann::json::array();
+    for (std::size_t i = 0; i < e.size(); ++i) {
+        entities.push_back({
+            {"kind", static_cast<int>(e.kind[i])},
+            {"x", e.x[i]}, {"y", e.y[i]}, {"vx", e.vx[i]}, {"vy", e.vy[i]},
+            {"half_w", e.half_w[i]}, {"half_h", e.half_h[i]},
+            {"health", e.health[i]},
+            {"value", e.value[i]},
+            {"cooldown", e.cooldown[i]},
+            {"owner", e.owner[i]}
+        });
+    }
+
+    nlohmann::json out = {
+        {"id", id_},
         {"max_players", max_players_},
-        {"players", players_arr}
+        {"state", static_cast<int>(state_)},
+        {"tick", tick_},
+        {"next_spawn", next_spawn_},
+        {"players", players},
+        {"entities", entities}
     };
+    if (lockstep_) {
+        out["lockstep"] = {{"dt", lockstep_->dt.raw}, {"checksum_interval", lockstep_->checksum_interval}};
+    }
+    return out;
+}
+
+void Room::restore_handoff(const nlohmann::json& j) {
+    state_ = static_cast<RoomState>(j.value("state", 0));
+    tick_ = j.value("tick", 0);
+    next_spawn_ = j.value("next_spawn", 0);
+
+    players_.clear();
+    disconnected_players_.clear();
+    slot_players_.fill(nullptr);
+    history_.reset();
+    rollback_.reset();
+
+    // Bodies come back as players rejoin, rounded from their float state
+    lockstep_.reset();
+    if (auto ls = j.find("lockstep"); ls != j.end()) {
+        lockstep_ = std::make_unique<Lockstep>();
+        lockstep_->dt = Fixed::from_raw(ls->value("dt", Fixed::from_float(0.05f).raw));
+        lockstep_->checksum_interval = std::max(1, ls->value("checksum_interval", 20));
+    }
+
+    // Lobby players simply join again; only matches in progress keep state
+    if (state_ == RoomState::PLAYING) {
+        for (const auto& pj : j.value("players", nlohmann::json::array())) {
+            auto p = Player::from_state_json(pj);
+            if (!p.id.empty()) disconnected_players_.emplace(p.id, std::move(p));
+        }
+
+        // Handles are not preserved across the restart, only the entities
+        entities_.clear();
+        for (const auto& ej : j.value("entities", nlohmann::json::array())) {
+            auto h = entities_.create(static_cast<EntityKind>(ej.value("kind", 0)),
+                                      ej.value("x", 0.0f), ej.value("y", 0.0f),
+                                      ej.value("half_w", 8.0f), ej.value("half_h", 8.0f));
+            auto i = entities_.index_of(h);
+            entities_.vx[i] = ej.value("vx", 0.0f);
+            entities_.vy[i] = ej.value("vy", 0.0f);
+            entities_.health[i] = ej.value("health", 0);
+            entities_.value[i] = ej.value("value", 0);
+            entities_.cooldown[i] = ej.value("cooldown", 0.0f);
+            entities_.owner[i] = ej.value("owner", EntityStore::NO_OWNER);
+        }
+    }
+
+    // Nobody is connected yet — the usual grace period applies
+    empty_since_ = Clock::now();
+    notify_changed();
+}
+
+// ── State snapshots ─────────────────────────────────
+
+std::string Room::lobby_state() const {
+    auto state = room_state_str(state_);
+    network::msg::LobbyState msg{id_, state, max_players_, {}};
+    msg.players.reserve(players_.size());
+    for (const auto& [_, p] : players_) {
+        msg.players.push_back({p.id, p.name, p.name, p.ready});
+    }
+    return network::schema::serialize(msg);
 }
 
 nlohmann::json Room::game_state() const {
@@ -287,15 +925,93 @@ nlohmann::json Room::game_state() const {
         players_arr.push_back(p.to_game_json());
     }
 
-    return {
+    const auto& e = entities_;
+    nlohmann::json enemies_arr = nlohmann::json::array();
+    nlohmann::json items_arr = nlohmann::json::array();
+    for (std::size_t i = 0; i < e.size(); ++i) {
+        auto id = e.handle_at(static_cast<uint32_t>(i)).wire_id();
+        if (e.kind[i] == EntityKind::ENEMY) {
+            enemies_arr.push_back({
+                {"id", id},
+                {"x", std::round(e.x[i] * 10.0f) / 10.0f},
+                {"y", std::round(e.y[i] * 10.0f) / 10.0f},
+                {"health", e.health[i]}
+            });
+        } else if (e.kind[i] == EntityKind::ITEM) {
+            items_arr.push_back({
+                {"id", id},
+                {"x", std::round(e.x[i] * 10.0f) / 10.0f},
+                {"y", std::round(e.y[i] * 10.0f) / 10.0f},
+                {"value", e.value[i]}
+            });
+        }
+    }
+
+    nlohmann::json state = {
         {"type", "game_state"},
         {"tick", tick_},
         {"time_left", 60.0f},    // Phase 3: actual round timer
         {"round", 1},             // Phase 3: round tracking
         {"players", players_arr},
-        {"enemies", nlohmann::json::array()},
-        {"items", nlohmann::json::array()}
+        {"enemies", enemies_arr},
+        {"items", items_arr}
     };
+    if (probe_us_) {
+        state["probe"] = probe_us_;
+    }
+    return state;
+}
+
+std::string Room::game_rejoin_message() const {
+    return network::schema::serialize(
+        network::msg::GameRejoin{tick_, 1, {map_->map_data_json()}});
+}
+
+std::string_view Room::write_game_state() {
+    snapshot_buf_.clear();
+    utils::JsonWriter w(snapshot_buf_);
+
+    // Keys in nlohmann's sorted order: enemies, items, players, ...
+    const auto& e = entities_;
+    w.raw(R"({"enemies":[)");
+    bool first = true;
+    for (std::size_t i = 0; i < e.size(); ++i) {
+        if (e.kind[i] != EntityKind::ENEMY) continue;
+        if (!first) w.raw(',');
+        first = false;
+        w.raw(R"({"health":)").integer(e.health[i])
+         .raw(R"(,"id":)").integer(e.handle_at(static_cast<uint32_t>(i)).wire_id())
+         .raw(R"(,"x":)").rounded(e.x[i])
+         .raw(R"(,"y":)").rounded(e.y[i])
+         .raw('}');
+    }
+    w.raw(R"(],"items":[)");
+    first = true;
+    for (std::size_t i = 0; i < e.size(); ++i) {
+        if (e.kind[i] != EntityKind::ITEM) continue;
+        if (!first) w.raw(',');
+        first = false;
+        w.raw(R"({"id":)").integer(e.handle_at(static_cast<uint32_t>(i)).wire_id())
+         .raw(R"(,"value":)").integer(e.value[i])
+         .raw(R"(,"x":)").rounded(e.x[i])
+         .raw(R"(,"y":)").rounded(e.y[i])
+         .raw('}');
+    }
+    w.raw(R"(],"players":[)");
+    first = true;
+    for (const auto& [_, p] : players_) {
+        if (!first) w.raw(',');
+        first = false;
+        p.write_game_json(w);
+    }
+    w.raw(']');
+    if (probe_us_) {
+        w.raw(R"(,"probe":)").integer(probe_us_);
+    }
+    w.raw(R"(,"round":1,"tick":)").integer(tick_)
+     .raw(R"(,"time_left":60.0,"type":"game_state"})");
+
+    return snapshot_buf_;
 }
 
 } // namespace game
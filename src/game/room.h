@@ -1,14 +1,32 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <vector>
+#include <memory_resource>
 #include <functional>
 #include <optional>
+#include <memory>
 #include <chrono>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <nlohmann/json.hpp>
 
 #include "game/player.h"
+#include "game/entity_store.h"
+#include "game/broadphase.h"
+#include "game/tilemap.h"
+#include "game/lag_compensation.h"
+#include "game/lockstep.h"
+#include "game/rollback.h"
+#include "game/spectator_stream.h"
+#include "network/rtt.h"
+
+namespace storage {
+class StatsWriter;
+enum class Stat : uint8_t;
+} // namespace storage
 
 namespace game {
 
@@ -23,12 +41,35 @@ inline std::string room_state_str(RoomState s) {
     return "unknown";
 }
 
+// SNAPSHOT: the server simulates and streams game_state (the default).
+// LOCKSTEP: it relays inputs and clients simulate movement (lockstep.h).
+enum class RoomMode : uint8_t { SNAPSHOT, LOCKSTEP };
+
+inline const char* room_mode_str(RoomMode m) {
+    return m == RoomMode::LOCKSTEP ? "lockstep" : "snapshot";
+}
+
+inline std::optional<RoomMode> parse_room_mode(std::string_view s) {
+    if (s == "snapshot") return RoomMode::SNAPSHOT;
+    if (s == "lockstep") return RoomMode::LOCKSTEP;
+    return std::nullopt;
+}
+
 class Room {
 public:
-    using BroadcastFn = std::function<void(const std::string& player_id, const std::string& message)>;
+    // TEXT is JSON, BINARY a lockstep frame (network/input_frames.h) and
+    // SNAPSHOT a game_state the next one supersedes, so it may go unreliably
+    enum class Payload : uint8_t { TEXT, BINARY, SNAPSHOT };
+    using BroadcastFn = std::function<void(const std::string& player_id, std::string_view message, Payload kind)>;
+    using ChangeFn = std::function<void(const Room& room)>;
+    using SpectatorFn = std::function<void(const Room& room, std::string_view frame)>;
     using Clock = std::chrono::steady_clock;
 
-    explicit Room(std::string id, int max_players = 4);
+    explicit Room(std::string id, int max_players = 4,
+                  std::shared_ptr<const Tilemap> map = Tilemap::builtin());
+
+    Room(const Room&) = delete;
+    Room& operator=(const Room&) = delete;
 
     // ── Player management ───────────────────────────
     bool add_player(const Player& player);
@@ -44,57 +85,278 @@ public:
     bool all_ready() const;
 
     // ── Chat ────────────────────────────────────────
-    void handle_chat(const std::string& sender_id, const std::string& message);
+    void handle_chat(const std::string& sender_id, std::string_view message);
 
     // ── Gameplay (Phase 2) ──────────────────────────
     void start_game();
+
+    // One tick = simulate() then publish(). simulate() touches only this
+    // room (the server runs rooms' simulate() in parallel) and leaves the
+    // serialized snapshot in the room; publish() sends it and reports
+    // changes, on the loop thread.
     void update(float dt);
-    void queue_input(const std::string& player_id,
-                     int tick,
-                     const std::vector<std::string>& actions);
+    void simulate(float dt);
+    void publish();
+    void queue_input(const std::string& player_id, int tick, uint8_t actions);
+
+    // ── Entities ────────────────────────────────────
+    // Phase 3 content (waves, drops, weapons) spawns through these.
+    // `owner` marks a player-fired projectile; NO_OWNER ones hit players.
+    EntityHandle spawn_enemy(float x, float y, int health, int contact_damage);
+    EntityHandle spawn_item(float x, float y, int gold);
+    EntityHandle spawn_projectile(float x, float y, float vx, float vy, int damage,
+                                  uint32_t owner = EntityStore::NO_OWNER);
+    const EntityStore& entities() const { return entities_; }
+
+    // ── Lag compensation ────────────────────────────
+    // For hit checks: which players `area` touched as seen by a client with
+    // the given round-trip time (positions rewound up to 250 ms).
+    LagCompensation::SlotMask rewind_overlap(const Hitbox& area, float rtt_ms,
+                                             uint8_t exclude_slot = Player::NO_SLOT) const;
+    // Same, rewound by the attacker's measured RTT and render delay
+    LagCompensation::SlotMask rewind_overlap_for(uint8_t attacker_slot, const Hitbox& area) const;
+    const Player* player_in_slot(int slot) const;
+    const LagCompensation* history() const { return history_.get(); }  // null until the first tick
+
+    // ── Latency ─────────────────────────────────────
+    // Every PROBE_INTERVAL a snapshot carries "probe" (server µs); clients
+    // echo it in probe_ack and the round trip feeds the player's estimator.
+    // False if the ack doesn't match a recent probe.
+    bool record_probe_ack(const std::string& player_id, int64_t probe_us, float hold_ms, int64_t now_us);
+    void handle_time_sync(const std::string& player_id, double client_time, int64_t recv_us);
+
+    float tick_ms() const { return tick_ms_; }
+    float snapshot_interval_ms() const { return tick_ms_ * static_cast<float>(snapshot_stride_); }
+    // Render delay suggested to a client: two snapshot intervals plus twice its jitter
+    float interp_delay_ms(const Player& p) const;
+
+    // All RTT samples taken in this room
+    const network::RttHistogram& rtt_histogram() const { return rtt_hist_; }
+    // Histogram plus each connected player's smoothed RTT and jitter
+    nlohmann::json rtt_json() const;
+
+    // ── Tick cost ───────────────────────────────────
+    // Smoothed wall time of update(): simulation vs building and queueing
+    // the snapshot. The server sheds load from the most expensive rooms.
+    struct TickCost {
+        float update_us = 0.0f;
+        float publish_us = 0.0f;
+        float total_us() const { return update_us + publish_us; }
+    };
+    const TickCost& tick_cost() const { return cost_; }
+
+    // ── Lockstep ────────────────────────────────────
+    // Only before the match starts. Ticks then advance by a fixed `tick_dt`
+    // whatever simulate() is passed, players receive TICK frames instead of
+    // game_state, and a CHECKSUM frame every `checksum_interval` ticks.
+    // Spectators still get (server-simulated) snapshots.
+    bool enable_lockstep(float tick_dt, int checksum_interval);
+    RoomMode mode() const { return lockstep_ ? RoomMode::LOCKSTEP : RoomMode::SNAPSHOT; }
+
+    // Serialized lockstep_state: the authoritative bodies after the current
+    // tick. Sent on start, rejoin and resync.
+    std::string lockstep_state() const;
+    // A client whose checksum diverged at `tick` asks for lockstep_state
+    void request_resync(const std::string& player_id, int tick);
+    uint64_t lockstep_resyncs() const { return lockstep_ ? lockstep_->resyncs : 0; }
+
+    // ── Rollback ────────────────────────────────────
+    // player_input stamped with a tick this room already simulated, at most
+    // `ticks` back, is applied at that tick: the next simulate() rewinds
+    // player movement there and replays it to the present. Hits, pickups
+    // and damage stay as they were resolved. 0 (default) = late inputs
+    // apply at the next tick. Snapshot rooms only; lockstep relays inputs
+    // in arrival order by design.
+    void set_rollback_window(int ticks) { rollback_window_ = std::max(0, ticks); }
+    const RollbackStats& rollback_stats() const { return rollback_stats_; }
+
+    // Broadcast game_state every `stride` ticks instead of every tick (≥ 1)
+    void set_snapshot_stride(int stride) { snapshot_stride_ = std::max(1, stride); }
+    int snapshot_stride() const { return snapshot_stride_; }
+
+    // ── Memory ──────────────────────────────────────
+    // Live bytes behind this room, estimated for /memory
+    struct MemoryUse {
+        std::size_t room = 0;      // the Room itself, entities, collision scratch
+        std::size_t players = 0;   // Player records, connected and awaiting reconnect
+        std::size_t buffers = 0;   // snapshot buffer and the spectator delay ring
+    };
+    MemoryUse memory_use() const;
 
     // ── Broadcasting ────────────────────────────────
+    // Messages arrive already serialized (network/messages.h schemas)
     void set_broadcast_fn(BroadcastFn fn);
-    void broadcast(const nlohmann::json& msg);
-    void broadcast_except(const std::string& exclude_id, const nlohmann::json& msg);
-    void send_to(const std::string& player_id, const nlohmann::json& msg);
+    void broadcast(std::string_view serialized);
+    void broadcast_except(const std::string& exclude_id, std::string_view serialized);
+    void send_to(const std::string& player_id, std::string_view serialized);
+    void broadcast_binary(std::string_view frame);
+    void broadcast_as(std::string_view message, Payload kind);
+
+    // Called after joins, leaves and state transitions (directory updates)
+    void set_change_fn(ChangeFn fn);
+
+    // ── Player stats ────────────────────────────────
+    // Gold, damage, kills and deaths go to the write-behind stats pipeline
+    // as they happen (from simulate(), so any thread); match results when
+    // the match ends. Null = not recorded.
+    void set_stats(storage::StatsWriter* stats) { stats_ = stats; }
+
+    // ── Spectators ──────────────────────────────────
+    // Viewers aren't players: they don't count towards max_players and send
+    // nothing. While any are watching, publish() hands the SpectatorFn a
+    // delayed copy of every `interval`-th snapshot, once per room — the
+    // server fans it out.
+    void set_spectator_fn(SpectatorFn fn);
+    void configure_spectators(int interval_ticks, int delay_ticks);
+    void add_spectator();
+    void remove_spectator();
+    int spectator_count() const { return spectators_; }
+    const SpectatorStream& spectator_stream() const { return spectator_stream_; }
 
     // ── Accessors ───────────────────────────────────
     const std::string& id() const { return id_; }
     RoomState state() const { return state_; }
     int max_players() const { return max_players_; }
     int current_tick() const { return tick_; }
+    const Tilemap& map() const { return *map_; }
 
     // ── Grace period for reconnection ───────────────
     bool should_cleanup() const;
 
+    // For a room created ahead of its first player (quick-match): cleaned up
+    // after the grace period unless someone joins. Rooms created by a join
+    // don't need it.
+    void start_grace_period();
+
+    // ── Hot restart handoff ─────────────────────────
+    // Connected players are exported too; on restore everyone lands in the
+    // reconnect list, so they resume through the normal rejoin path.
+    nlohmann::json to_handoff_json() const;
+    void restore_handoff(const nlohmann::json& j);
+
     // ── State snapshots ─────────────────────────────
-    nlohmann::json lobby_state() const;
+    std::string lobby_state() const;
     nlohmann::json game_state() const;
 
+    // game_rejoin for a player reconnecting mid-match (cached map_data spliced in)
+    std::string game_rejoin_message() const;
+
+    // Serializes game_state() straight into a reusable buffer (byte-identical
+    // to game_state().dump(), see tests/snapshot_golden). The view is valid
+    // until the next call.
+    std::string_view write_game_state();
+
 private:
     std::string id_;
     int max_players_;
     RoomState state_ = RoomState::WAITING;
     int tick_ = 0;
 
-    std::unordered_map<std::string, Player> players_;
+    // Shared, read-only; collision for players and bounds for entities
+    std::shared_ptr<const Tilemap> map_;
+
+    // Map nodes for players_ / disconnected_players_ are recycled through this
+    // pool. Only the nodes: the std::string keys and each Player's id and name
+    // still allocate on join unless they fit in the small-string buffer.
+    std::pmr::unsynchronized_pool_resource player_pool_;
+
+    std::pmr::unordered_map<std::string, Player> players_{&player_pool_};
     BroadcastFn broadcast_fn_;
+    ChangeFn change_fn_;
+    SpectatorFn spectator_fn_;
+
+    void notify_changed();
 
     // Track disconnected players for reconnection during PLAYING
-    std::unordered_map<std::string, Player> disconnected_players_;
+    std::pmr::unordered_map<std::string, Player> disconnected_players_{&player_pool_};
 
     // Grace period: keep room alive for 30s after last player leaves
+    // (or after start_grace_period(), if nobody joins)
     static constexpr int GRACE_SECONDS = 30;
     std::optional<Clock::time_point> empty_since_;
 
-    // Spawn positions for up to 4 players
-    static constexpr float spawn_positions_[][2] = {
-        {200.0f, physics::GROUND_Y},
-        {400.0f, physics::GROUND_Y},
-        {600.0f, physics::GROUND_Y},
-        {800.0f, physics::GROUND_Y}
+    // Reused across ticks so steady-state snapshots don't allocate
+    std::string snapshot_buf_;
+    int snapshot_stride_ = 1;
+
+    int spectators_ = 0;
+    SpectatorStream spectator_stream_;
+
+    storage::StatsWriter* stats_ = nullptr;
+    void record_stat(const Player& p, storage::Stat stat, int64_t value) const;
+    void record_match_results();
+
+    // ── Latency ─────────────────────────────────────
+    static constexpr int64_t PROBE_INTERVAL_US = 500'000;
+    static constexpr float MAX_RTT_MS = 10'000.0f;     // older acks are stale, not slow
+
+    float tick_ms_ = 50.0f;                          // from the last simulate()
+    int64_t probe_us_ = 0;                           // in the current snapshot, 0 = none
+    int64_t last_probe_us_ = INT64_MIN / 2;
+    std::array<int64_t, 8> recent_probes_{};         // acks must match one of these
+    std::size_t next_probe_ = 0;
+    network::RttHistogram rtt_hist_;
+
+    // Handed from simulate() to publish()
+    bool ticked_ = false;
+    bool snapshot_ready_ = false;
+    bool changed_pending_ = false;
+    bool expired_pending_ = false;   // grace period ran out; logged on the loop thread
+    float sim_us_ = 0.0f;
+    float serialize_us_ = 0.0f;
+
+    static constexpr float COST_SMOOTHING = 0.1f;  // EWMA weight of the newest tick
+    TickCost cost_;
+
+    // ── Entities and collision ──────────────────────
+    enum Layer : uint8_t { LAYER_PLAYER, LAYER_ENEMY, LAYER_ITEM, LAYER_PROJECTILE };
+
+    static constexpr float CONTACT_COOLDOWN = 0.5f;    // seconds between enemy contact hits
+    static constexpr float PROJECTILE_LIFETIME = 3.0f;
+    static constexpr float BROADPHASE_CELL = 64.0f;    // px, a couple of bodies wide
+
+    // Moves entities, runs the broadphase once and resolves hits
+    void step_entities(float dt);
+
+    EntityStore entities_;
+    Broadphase broadphase_{map_->width_px(), map_->height_px(), BROADPHASE_CELL};
+    std::vector<Collider> colliders_;        // rebuilt each tick, capacity kept
+    std::vector<Player*> collider_players_;  // LAYER_PLAYER collider id → player
+    std::vector<uint8_t> entity_dead_;       // per dense index, this tick
+
+    // ── Lag compensation ────────────────────────────
+    void assign_slot(Player& p);
+    void release_slot(Player& p);
+
+    // ~4.3 KB of frames; lobbies never need it, so it comes with the first tick
+    std::unique_ptr<LagCompensation> history_;
+    std::array<Player*, LagCompensation::MAX_SLOTS> slot_players_{};  // map nodes are stable
+
+    // ── Lockstep ────────────────────────────────────
+    // Snapshot rooms never allocate this
+    struct Lockstep {
+        LockstepSim sim;
+        Fixed dt;
+        int checksum_interval = 20;
+        std::string frames;              // this tick's TICK (+ CHECKSUM), for publish()
+        std::size_t tick_frame_size = 0;
+        uint64_t resyncs = 0;
     };
+    std::unique_ptr<Lockstep> lockstep_;
+
+    void step_lockstep();
+    void place_body(const Player& p);
+
+    // ── Rollback ────────────────────────────────────
+    // Replays amended ticks, then saves the one about to run
+    void step_rollback(float dt);
+
+    int rollback_window_ = 0;
+    std::unique_ptr<Rollback> rollback_;   // ~5.7 KB, with the first tick
+    RollbackStats rollback_stats_;
+
+    // Round-robin over the map's spawn points
+    void spawn_player(Player& p);
     int next_spawn_ = 0;
 };
 
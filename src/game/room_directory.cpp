@@ -0,0 +1,110 @@
+#include "game/room_directory.h"
+#include "utils/json_writer.h"
+#include "utils/memory_stats.h"
+
+#include <algorithm>
+
+namespace game {
+
+void RoomDirectory::upsert(const Room& room) {
+    auto [it, inserted] = entries_.try_emplace(room.id());
+    auto& e = it->second;
+
+    if (!inserted && e.state == room.state() && e.players == room.player_count()
+        && e.max_players == room.max_players()) {
+        return;
+    }
+
+    e.state = room.state();
+    e.players = room.player_count();
+    e.max_players = room.max_players();
+
+    e.fragment.clear();
+    utils::JsonWriter w(e.fragment);
+    w.raw(R"({"id":)").string(room.id())
+     .raw(R"(,"max_players":)").integer(e.max_players)
+     .raw(R"(,"players":)").integer(e.players)
+     .raw(R"(,"state":")").raw(room_state_str(e.state))
+     .raw(R"("})");
+
+    set_open(*it, is_open(e));
+    cache_.clear();
+}
+
+void RoomDirectory::remove(const std::string& room_id) {
+    auto it = entries_.find(room_id);
+    if (it == entries_.end()) return;
+    set_open(*it, false);
+    entries_.erase(it);
+    cache_.clear();
+}
+
+void RoomDirectory::set_open(Node& node, bool open) {
+    auto& e = node.second;
+    if (open == (e.open_pos != NOT_OPEN)) return;
+
+    if (open) {
+        e.open_pos = open_.size();
+        open_.push_back(&node);
+        return;
+    }
+
+    // Swap-remove
+    Node* last = open_.back();
+    open_[e.open_pos] = last;
+    last->second.open_pos = e.open_pos;
+    open_.pop_back();
+    e.open_pos = NOT_OPEN;
+}
+
+const std::string* RoomDirectory::quick_match() const {
+    if (open_.empty()) return nullptr;
+    return &open_.back()->first;
+}
+
+const std::string& RoomDirectory::listing(const RoomQuery& query) {
+    int limit = std::clamp(query.limit, 1, RoomQuery::MAX_LIMIT);
+    int offset = std::max(query.offset, 0);
+
+    std::string key;
+    key += query.state ? room_state_str(*query.state) : "any";
+    key += query.open_only ? "|open|" : "|all|";
+    key += std::to_string(offset) + "|" + std::to_string(limit);
+
+    auto cached = cache_.find(key);
+    if (cached != cache_.end()) return cached->second;
+
+    // Arbitrary offsets could grow the cache without bound between changes
+    if (cache_.size() >= MAX_CACHED_QUERIES) cache_.clear();
+
+    std::string out;
+    utils::JsonWriter w(out);
+    w.raw(R"({"rooms":[)");
+
+    int matched = 0;
+    int written = 0;
+    for (const auto& [id, e] : entries_) {
+        if (query.state && e.state != *query.state) continue;
+        if (query.open_only && !is_open(e)) continue;
+        if (matched++ < offset || written >= limit) continue;
+        if (written++ > 0) w.raw(',');
+        w.raw(e.fragment);
+    }
+
+    w.raw(R"(],"total":)").integer(matched)
+     .raw(R"(,"offset":)").integer(offset)
+     .raw(R"(,"limit":)").integer(limit)
+     .raw('}');
+
+    return cache_.emplace(std::move(key), std::move(out)).first->second;
+}
+
+std::size_t RoomDirectory::memory_bytes() const {
+    std::size_t n = memory::tree_map_bytes(entries_) + memory::heap_bytes(open_)
+                  + memory::hash_map_bytes(cache_);
+    for (const auto& [id, e] : entries_) n += memory::heap_bytes(id) + memory::heap_bytes(e.fragment);
+    for (const auto& [key, listing] : cache_) n += memory::heap_bytes(key) + memory::heap_bytes(listing);
+    return n;
+}
+
+} // namespace game
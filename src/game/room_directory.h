@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include "game/room.h"
+
+namespace game {
+
+// Listing filters for the /rooms endpoint
+struct RoomQuery {
+    std::optional<RoomState> state;   // nullopt = any state
+    bool open_only = false;           // only rooms with a free slot
+    int offset = 0;
+    int limit = 50;
+
+    static constexpr int MAX_LIMIT = 100;
+};
+
+// Indexed view of every room on this node, kept up to date incrementally
+// through Room::set_change_fn(). Each entry carries its pre-serialized JSON
+// fragment, and full listings are cached per query until the next change,
+// so polling the endpoint costs a hash lookup.
+class RoomDirectory {
+public:
+    // Insert or refresh a room's entry (join, leave, state change)
+    void upsert(const Room& room);
+    void remove(const std::string& room_id);
+
+    // O(1): a WAITING room with a free slot, or nullptr if there is none
+    const std::string* quick_match() const;
+
+    // Serialized listing for the query; valid until the next upsert/remove
+    const std::string& listing(const RoomQuery& query);
+
+    std::size_t size() const { return entries_.size(); }
+    std::size_t open_count() const { return open_.size(); }
+
+    // Entries with their fragments, the open list and cached listings
+    std::size_t memory_bytes() const;
+
+private:
+    static constexpr std::size_t NOT_OPEN = static_cast<std::size_t>(-1);
+    static constexpr std::size_t MAX_CACHED_QUERIES = 64;
+
+    struct Entry {
+        RoomState state = RoomState::WAITING;
+        int players = 0;
+        int max_players = 0;
+        std::string fragment;            // {"id":...,"state":...,...}
+        std::size_t open_pos = NOT_OPEN; // index into open_
+    };
+
+    static bool is_open(const Entry& e) {
+        return e.state == RoomState::WAITING && e.players < e.max_players;
+    }
+
+    using Node = std::pair<const std::string, Entry>;
+
+    void set_open(Node& node, bool open);
+
+    // Ordered by room id so pagination is stable between polls
+    std::map<std::string, Entry, std::less<>> entries_;
+
+    // Joinable rooms — swap-remove keeps insert/erase/pick O(1).
+    // Points into entries_ nodes, which stay put until erased.
+    std::vector<Node*> open_;
+
+    std::unordered_map<std::string, std::string> cache_;
+};
+
+} // namespace game
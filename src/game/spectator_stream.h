@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include "utils/memory_stats.h"
+
+namespace game {
+
+// What a room's spectators see: a copy of every `interval`-th snapshot the
+// players got, held back `delay` ticks (no live ghosting off a stream), plus
+// the odd event frame (game_rejoin at match start) in the same order.
+//
+// Frames are copies of bytes the room already serialized for its players;
+// nothing here serializes per viewer. They sit in a ring whose slots keep
+// their buffers, so a steady stream doesn't allocate once the ring holds a
+// delay's worth of frames.
+class SpectatorStream {
+public:
+    void configure(int interval_ticks, int delay_ticks) {
+        interval_ = std::max(1, interval_ticks);
+        delay_ = std::max(0, delay_ticks);
+    }
+
+    int interval_ticks() const { return interval_; }
+    int delay_ticks() const { return delay_; }
+
+    // Whether the snapshot of `tick` should go to spectators
+    bool due(int tick) const { return tick - last_capture_ >= interval_; }
+
+    void capture(int tick, std::string_view snapshot) {
+        last_capture_ = tick;
+        push(tick, snapshot);
+    }
+
+    // Frame that isn't a snapshot; always kept
+    void push_event(int tick, std::string_view frame) { push(tick, frame); }
+
+    // Hands every frame at least `delay` ticks old to send(frame), oldest first
+    template <typename Send>
+    void release(int now, Send&& send) {
+        while (count_ > 0 && now - ring_[head_].tick >= delay_) {
+            send(std::string_view(ring_[head_].bytes));
+            head_ = (head_ + 1) % ring_.size();
+            count_--;
+        }
+    }
+
+    // Last spectator left — nothing to keep
+    void clear() {
+        head_ = 0;
+        count_ = 0;
+        last_capture_ = NEVER;
+    }
+
+    std::size_t pending() const { return count_; }
+
+    // The ring and every slot's buffer, in use or not
+    std::size_t memory_bytes() const {
+        std::size_t n = memory::heap_bytes(ring_);
+        for (const auto& f : ring_) n += memory::heap_bytes(f.bytes);
+        return n;
+    }
+
+private:
+    static constexpr int NEVER = -(1 << 30);
+
+    struct Frame {
+        int tick = 0;
+        std::string bytes;
+    };
+
+    void push(int tick, std::string_view bytes) {
+        if (count_ == ring_.size()) grow();
+        Frame& f = ring_[(head_ + count_) % ring_.size()];
+        f.tick = tick;
+        f.bytes.assign(bytes);
+        count_++;
+    }
+
+    // Doubles the ring, oldest frame first; only while the delay fills up
+    void grow() {
+        std::vector<Frame> bigger(std::max<std::size_t>(8, 2 * ring_.size()));
+        for (std::size_t i = 0; i < count_; ++i) {
+            bigger[i] = std::move(ring_[(head_ + i) % ring_.size()]);
+        }
+        ring_ = std::move(bigger);
+        head_ = 0;
+    }
+
+    int interval_ = 1;
+    int delay_ = 0;
+    int last_capture_ = NEVER;
+    std::vector<Frame> ring_;
+    std::size_t head_ = 0;   // oldest frame
+    std::size_t count_ = 0;  // frames waiting for their delay
+};
+
+} // namespace game
@@ -0,0 +1,329 @@
+#include "game/tilemap.h"
+#include "game/player.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+namespace game {
+
+namespace {
+    constexpr float SWEEP_EPS = 1e-4f;
+}
+
+// ── Loading ─────────────────────────────────────────
+
+std::shared_ptr<const Tilemap> Tilemap::open(const std::string& path, std::string name) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        logger::warn("map " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(TilemapHeader))) {
+        logger::error("map " + path + ": file too small");
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto size = static_cast<std::size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // the mapping keeps the file referenced
+    if (addr == MAP_FAILED) {
+        logger::error("map " + path + ": mmap failed: " + std::strerror(errno));
+        return nullptr;
+    }
+
+    std::shared_ptr<Tilemap> map(new Tilemap);
+    map->mapping_ = addr;
+    map->mapping_size_ = size;
+    map->name_ = std::move(name);
+    if (!map->bind(static_cast<const uint8_t*>(addr), size)) {
+        logger::error("map " + path + ": invalid or unsupported format");
+        return nullptr;
+    }
+
+    map->build_map_data();
+    logger::info("loaded map " + map->name_ + " (" + std::to_string(map->columns_) + "x"
+                 + std::to_string(map->rows_) + " tiles, " + std::to_string(size) + " bytes)");
+    return map;
+}
+
+std::shared_ptr<const Tilemap> Tilemap::builtin() {
+    static const std::shared_ptr<const Tilemap> instance = [] {
+        constexpr int TILE = 16;
+        constexpr int COLS = static_cast<int>(physics::MAP_WIDTH) / TILE;
+        constexpr int ROWS = static_cast<int>(physics::MAP_HEIGHT) / TILE;
+        constexpr int GROUND_ROW = static_cast<int>(physics::GROUND_Y + physics::PLAYER_HALF_H) / TILE;
+
+        std::vector<uint8_t> solid(COLS * ROWS, 0);
+        std::fill(solid.begin() + GROUND_ROW * COLS, solid.end(), 1);
+
+        std::vector<SpawnPoint> spawns = {
+            {200.0f, physics::GROUND_Y},
+            {400.0f, physics::GROUND_Y},
+            {600.0f, physics::GROUND_Y},
+            {800.0f, physics::GROUND_Y}
+        };
+
+        std::shared_ptr<Tilemap> map(new Tilemap);
+        map->name_ = "default";
+        map->owned_ = encode(TILE, COLS, ROWS, solid, spawns);
+        map->bind(map->owned_.data(), map->owned_.size());
+        map->build_map_data();
+        return map;
+    }();
+    return instance;
+}
+
+Tilemap::~Tilemap() {
+    if (mapping_) ::munmap(mapping_, mapping_size_);
+}
+
+bool Tilemap::bind(const uint8_t* data, std::size_t size) {
+    if (size < sizeof(TilemapHeader)) return false;
+
+    TilemapHeader h;
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION) return false;
+    if (h.tile_size == 0 || h.columns == 0 || h.rows == 0) return false;
+
+    std::size_t stride = (h.columns + 7) / 8;
+    std::size_t bitmap_bytes = stride * h.rows;
+    std::size_t spawn_bytes = static_cast<std::size_t>(h.spawn_count) * sizeof(SpawnPoint);
+    if (h.bitmap_offset > size || bitmap_bytes > size - h.bitmap_offset) return false;
+    if (h.spawn_offset > size || spawn_bytes > size - h.spawn_offset) return false;
+
+    tile_size_ = h.tile_size;
+    columns_ = h.columns;
+    rows_ = h.rows;
+    stride_ = static_cast<int>(stride);
+    bitmap_ = data + h.bitmap_offset;
+    spawns_ = data + h.spawn_offset;
+    spawn_count_ = h.spawn_count;
+    return true;
+}
+
+std::vector<uint8_t> Tilemap::encode(int tile_size, int columns, int rows,
+                                     const std::vector<uint8_t>& solid,
+                                     const std::vector<SpawnPoint>& spawns) {
+    std::size_t stride = (columns + 7) / 8;
+
+    TilemapHeader h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.tile_size = static_cast<uint16_t>(tile_size);
+    h.columns = static_cast<uint16_t>(columns);
+    h.rows = static_cast<uint16_t>(rows);
+    h.spawn_count = static_cast<uint16_t>(spawns.size());
+    h.bitmap_offset = sizeof(TilemapHeader);
+    // Keep the float array 4-byte aligned in the mapping
+    h.spawn_offset = static_cast<uint32_t>((h.bitmap_offset + stride * rows + 3) & ~std::size_t{3});
+
+    std::vector<uint8_t> out(h.spawn_offset + spawns.size() * sizeof(SpawnPoint), 0);
+    std::memcpy(out.data(), &h, sizeof(h));
+
+    for (int ty = 0; ty < rows; ++ty) {
+        for (int tx = 0; tx < columns; ++tx) {
+            if (solid[ty * columns + tx]) {
+                out[h.bitmap_offset + ty * stride + (tx >> 3)] |= static_cast<uint8_t>(1u << (tx & 7));
+            }
+        }
+    }
+    if (!spawns.empty()) {
+        std::memcpy(out.data() + h.spawn_offset, spawns.data(), spawns.size() * sizeof(SpawnPoint));
+    }
+    return out;
+}
+
+// ── Queries ─────────────────────────────────────────
+
+SpawnPoint Tilemap::spawn(std::size_t i) const {
+    SpawnPoint p;
+    std::memcpy(&p, spawns_ + i * sizeof(SpawnPoint), sizeof(p));
+    return p;
+}
+
+int Tilemap::tile_of(float px) const {
+    return static_cast<int>(std::floor(px / static_cast<float>(tile_size_)));
+}
+
+float Tilemap::sweep_x(float x, float y, float half_w, float half_h, float dx) const {
+    if (dx == 0.0f) return 0.0f;
+
+    int ty0 = tile_of(y - half_h);
+    int ty1 = tile_of(y + half_h - SWEEP_EPS);
+    auto blocked = [&](int tx) {
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            if (solid(tx, ty)) return true;
+        }
+        return false;
+    };
+
+    // Out-of-range columns are solid, so the walk always stops at the edge
+    if (dx > 0.0f) {
+        float lead = x + half_w;
+        int last = tile_of(lead + dx - SWEEP_EPS);
+        for (int tx = tile_of(lead); tx <= last; ++tx) {
+            if (blocked(tx)) return std::max(0.0f, static_cast<float>(tx * tile_size_) - lead);
+        }
+    } else {
+        float lead = x - half_w;
+        int last = tile_of(lead + dx);
+        for (int tx = tile_of(lead - SWEEP_EPS); tx >= last; --tx) {
+            if (blocked(tx)) return std::min(0.0f, static_cast<float>((tx + 1) * tile_size_) - lead);
+        }
+    }
+    return dx;
+}
+
+float Tilemap::sweep_y(float x, float y, float half_w, float half_h, float dy) const {
+    if (dy == 0.0f) return 0.0f;
+
+    int tx0 = tile_of(x - half_w);
+    int tx1 = tile_of(x + half_w - SWEEP_EPS);
+    auto blocked = [&](int ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            if (solid(tx, ty)) return true;
+        }
+        return false;
+    };
+
+    if (dy > 0.0f) {
+        float lead = y + half_h;
+        int last = std::min(tile_of(lead + dy - SWEEP_EPS), rows_);
+        for (int ty = tile_of(lead); ty <= last; ++ty) {
+            if (blocked(ty)) return std::max(0.0f, static_cast<float>(ty * tile_size_) - lead);
+        }
+    } else {
+        float lead = y - half_h;
+        int last = std::max(tile_of(lead + dy), -1);  // the sky above row 0 is open
+        for (int ty = tile_of(lead - SWEEP_EPS); ty >= last; --ty) {
+            if (blocked(ty)) return std::min(0.0f, static_cast<float>((ty + 1) * tile_size_) - lead);
+        }
+    }
+    return dy;
+}
+
+// Fixed-point twins of the sweeps above: same walk, one raw unit as epsilon
+
+Fixed Tilemap::sweep_x(Fixed x, Fixed y, Fixed half_w, Fixed half_h, Fixed dx) const {
+    constexpr Fixed EPS = Fixed::from_raw(1);
+    constexpr Fixed ZERO{};
+    if (dx == ZERO) return ZERO;
+
+    int ty0 = tile_of(y - half_h);
+    int ty1 = tile_of(y + half_h - EPS);
+    auto blocked = [&](int tx) {
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            if (solid(tx, ty)) return true;
+        }
+        return false;
+    };
+
+    if (dx > ZERO) {
+        Fixed lead = x + half_w;
+        int last = tile_of(lead + dx - EPS);
+        for (int tx = tile_of(lead); tx <= last; ++tx) {
+            if (blocked(tx)) return max(ZERO, Fixed::from_int(tx * tile_size_) - lead);
+        }
+    } else {
+        Fixed lead = x - half_w;
+        int last = tile_of(lead + dx);
+        for (int tx = tile_of(lead - EPS); tx >= last; --tx) {
+            if (blocked(tx)) return min(ZERO, Fixed::from_int((tx + 1) * tile_size_) - lead);
+        }
+    }
+    return dx;
+}
+
+Fixed Tilemap::sweep_y(Fixed x, Fixed y, Fixed half_w, Fixed half_h, Fixed dy) const {
+    constexpr Fixed EPS = Fixed::from_raw(1);
+    constexpr Fixed ZERO{};
+    if (dy == ZERO) return ZERO;
+
+    int tx0 = tile_of(x - half_w);
+    int tx1 = tile_of(x + half_w - EPS);
+    auto blocked = [&](int ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            if (solid(tx, ty)) return true;
+        }
+        return false;
+    };
+
+    if (dy > ZERO) {
+        Fixed lead = y + half_h;
+        int last = std::min(tile_of(lead + dy - EPS), rows_);
+        for (int ty = tile_of(lead); ty <= last; ++ty) {
+            if (blocked(ty)) return max(ZERO, Fixed::from_int(ty * tile_size_) - lead);
+        }
+    } else {
+        Fixed lead = y - half_h;
+        int last = std::max(tile_of(lead + dy), -1);  // the sky above row 0 is open
+        for (int ty = tile_of(lead - EPS); ty >= last; --ty) {
+            if (blocked(ty)) return min(ZERO, Fixed::from_int((ty + 1) * tile_size_) - lead);
+        }
+    }
+    return dy;
+}
+
+// ── map_data ────────────────────────────────────────
+
+void Tilemap::build_map_data() {
+    // ground_y (kept for older clients): body center when standing on the
+    // lowest full-width floor
+    int floor_row = rows_;
+    for (int ty = rows_ - 1; ty >= 0; --ty) {
+        bool full = true;
+        for (int tx = 0; tx < columns_ && full; ++tx) full = solid(tx, ty);
+        if (!full) break;
+        floor_row = ty;
+    }
+
+    nlohmann::json rows = nlohmann::json::array();
+    std::string row(columns_, '.');
+    for (int ty = 0; ty < rows_; ++ty) {
+        for (int tx = 0; tx < columns_; ++tx) row[tx] = solid(tx, ty) ? '#' : '.';
+        rows.push_back(row);
+    }
+
+    map_data_json_ = nlohmann::json{
+        {"name", name_},
+        {"width", width_px()},
+        {"height", height_px()},
+        {"ground_y", static_cast<float>(floor_row * tile_size_) - physics::PLAYER_HALF_H},
+        {"tile_size", tile_size_},
+        {"columns", columns_},
+        {"rows", rows_},
+        {"tiles", rows}
+    }.dump();
+}
+
+// ── Registry ────────────────────────────────────────
+
+std::shared_ptr<const Tilemap> MapRegistry::get(const std::string& name) {
+    if (name.empty() || name == "default") return Tilemap::builtin();
+
+    auto it = maps_.find(name);
+    if (it != maps_.end()) return it->second;
+
+    // Names come from config/room options; keep them inside maps_dir
+    bool valid = name.find('/') == std::string::npos && name.find("..") == std::string::npos;
+    auto map = valid ? Tilemap::open(dir_ + "/" + name + ".wmap", name) : nullptr;
+    if (!map) {
+        logger::warn("map " + name + " unavailable, using the built-in map");
+        map = Tilemap::builtin();
+    }
+    maps_.emplace(name, map);
+    return map;
+}
+
+} // namespace game
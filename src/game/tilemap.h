@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "game/fixed.h"
+#include "utils/memory_stats.h"
+
+namespace game {
+
+// ── On-disk format ──────────────────────────────────
+// Produced offline by tools/mapc, little-endian:
+//   TilemapHeader
+//   collision bitmap: rows × stride bytes, bit (x & 7) of byte x / 8 set = solid
+//   spawn points:     spawn_count × {float x, float y}, body centers in px
+struct TilemapHeader {
+    char magic[4];           // "WMAP"
+    uint16_t version;
+    uint16_t tile_size;      // px
+    uint16_t columns;
+    uint16_t rows;
+    uint16_t spawn_count;
+    uint16_t reserved;
+    uint32_t bitmap_offset;
+    uint32_t spawn_offset;
+};
+static_assert(sizeof(TilemapHeader) == 24);
+
+struct SpawnPoint {
+    float x, y;
+};
+
+// Read-only collision map. Files are mmap'ed and shared by every room playing
+// the map; nothing is copied out of the mapping except the client-facing
+// map_data, which is serialized once at load.
+class Tilemap {
+public:
+    static constexpr char MAGIC[4] = {'W', 'M', 'A', 'P'};
+    static constexpr uint16_t VERSION = 1;
+
+    // nullptr (and a log line) if the file is missing or malformed
+    static std::shared_ptr<const Tilemap> open(const std::string& path, std::string name);
+
+    // The original flat arena: 1280×720, ground at y=688, four spawns
+    static std::shared_ptr<const Tilemap> builtin();
+
+    // Serializes a map in the on-disk format. `solid` is columns*rows, row-major.
+    static std::vector<uint8_t> encode(int tile_size, int columns, int rows,
+                                       const std::vector<uint8_t>& solid,
+                                       const std::vector<SpawnPoint>& spawns);
+
+    ~Tilemap();
+    Tilemap(const Tilemap&) = delete;
+    Tilemap& operator=(const Tilemap&) = delete;
+
+    const std::string& name() const { return name_; }
+    int tile_size() const { return tile_size_; }
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+    float width_px() const { return static_cast<float>(columns_ * tile_size_); }
+    float height_px() const { return static_cast<float>(rows_ * tile_size_); }
+
+    // Outside the map, the sides and bottom are solid and the sky is open
+    bool solid(int tx, int ty) const {
+        if (tx < 0 || tx >= columns_ || ty >= rows_) return true;
+        if (ty < 0) return false;
+        return (bitmap_[ty * stride_ + (tx >> 3)] >> (tx & 7)) & 1;
+    }
+
+    std::size_t spawn_count() const { return spawn_count_; }
+    SpawnPoint spawn(std::size_t i) const;
+
+    // How far a box (center x,y and half extents) can move along one axis
+    // before touching a solid tile. Tiles are visited in order of travel, so
+    // fast movers can't tunnel through one-tile walls.
+    float sweep_x(float x, float y, float half_w, float half_h, float dx) const;
+    float sweep_y(float x, float y, float half_w, float half_h, float dy) const;
+
+    // The same sweeps in fixed point, bit-identical everywhere (lockstep rooms)
+    Fixed sweep_x(Fixed x, Fixed y, Fixed half_w, Fixed half_h, Fixed dx) const;
+    Fixed sweep_y(Fixed x, Fixed y, Fixed half_w, Fixed half_h, Fixed dy) const;
+
+    // Pre-serialized map_data object for game_start / game_rejoin
+    const std::string& map_data_json() const { return map_data_json_; }
+
+    // Tile/spawn bytes (mapped or owned) plus the cached map_data JSON
+    std::size_t memory_bytes() const {
+        return sizeof(*this) + mapping_size_ + memory::heap_bytes(owned_) + memory::heap_bytes(map_data_json_);
+    }
+
+private:
+    Tilemap() = default;
+
+    // Validates the buffer and points the accessors into it
+    bool bind(const uint8_t* data, std::size_t size);
+    void build_map_data();
+
+    int tile_of(float px) const;
+    int tile_of(Fixed px) const { return floor_div(px.raw, tile_size_ * Fixed::ONE); }
+
+    std::string name_;
+    int tile_size_ = 0;
+    int columns_ = 0;
+    int rows_ = 0;
+    int stride_ = 0;
+    const uint8_t* bitmap_ = nullptr;
+    const uint8_t* spawns_ = nullptr;
+    std::size_t spawn_count_ = 0;
+
+    void* mapping_ = nullptr;              // mmap'ed file, if loaded from disk
+    std::size_t mapping_size_ = 0;
+    std::vector<uint8_t> owned_;           // built-in map bytes
+
+    std::string map_data_json_;
+};
+
+// Loads each map once and hands the same instance to every room using it
+class MapRegistry {
+public:
+    explicit MapRegistry(std::string maps_dir) : dir_(std::move(maps_dir)) {}
+
+    // "<maps_dir>/<name>.wmap"; empty or unloadable names get the built-in map
+    std::shared_ptr<const Tilemap> get(const std::string& name);
+
+    std::size_t loaded() const { return maps_.size(); }
+
+    std::size_t memory_bytes() const {
+        std::size_t n = memory::hash_map_bytes(maps_);
+        for (const auto& [_, map] : maps_) n += map->memory_bytes();
+        return n;
+    }
+
+private:
+    std::string dir_;
+    std::unordered_map<std::string, std::shared_ptr<const Tilemap>> maps_;
+};
+
+} // namespace game
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "network/input_frames.h"
+
+// Datagrams of the optional UDP channel (server/udp_channel.h). Only
+// superseding traffic travels here, where a lost packet doesn't hold up the
+// next one; everything else stays on the WebSocket. Little-endian:
+//
+//   client → server  HELLO      0x10 | token[16]                             17 bytes
+//   server → client  HELLO_ACK  0x11                                          1 byte
+//   server → client  SNAPSHOT   0x20 | seq u32 | game_state JSON
+//   client → server  INPUT      0x21 | seq u32 | tick u32 | actions u8      10 bytes
+//
+// HELLO binds the sender's address to the WebSocket session that was sent
+// the token (udp_offer) and doubles as a keepalive. Receivers drop anything
+// whose seq isn't newer than the last one they took.
+namespace network::datagrams {
+
+enum Kind : uint8_t { HELLO = 0x10, HELLO_ACK = 0x11, SNAPSHOT = 0x20, INPUT = 0x21 };
+
+constexpr std::size_t TOKEN_SIZE = 16;
+constexpr std::size_t HELLO_SIZE = 1 + TOKEN_SIZE;
+constexpr std::size_t SNAPSHOT_HEADER = 5;
+constexpr std::size_t INPUT_SIZE = 10;
+
+// Kept under the smallest common path MTU, so nothing is fragmented;
+// larger snapshots go on the WebSocket
+constexpr std::size_t MAX_DATAGRAM = 1200;
+
+using Token = std::array<uint8_t, TOKEN_SIZE>;
+
+struct Input {
+    uint32_t seq = 0;
+    uint32_t tick = 0;
+    uint8_t actions = 0;
+};
+
+inline std::optional<Token> read_hello(std::string_view d) {
+    if (d.size() != HELLO_SIZE || static_cast<uint8_t>(d[0]) != HELLO) return std::nullopt;
+    Token t;
+    for (std::size_t i = 0; i < TOKEN_SIZE; ++i) t[i] = static_cast<uint8_t>(d[1 + i]);
+    return t;
+}
+
+inline std::optional<Input> read_input(std::string_view d) {
+    if (d.size() != INPUT_SIZE || static_cast<uint8_t>(d[0]) != INPUT) return std::nullopt;
+    return Input{static_cast<uint32_t>(frames::detail::get(d, 1, 4)),
+                 static_cast<uint32_t>(frames::detail::get(d, 5, 4)),
+                 static_cast<uint8_t>(d[9])};
+}
+
+inline void write_snapshot_header(std::string& out, uint32_t seq) {
+    out.push_back(static_cast<char>(SNAPSHOT));
+    frames::detail::put(out, seq, 4);
+}
+
+// Newer than `last`, allowing for wraparound
+inline bool seq_newer(uint32_t seq, uint32_t last) {
+    return static_cast<int32_t>(seq - last) > 0;
+}
+
+inline std::string token_hex(const Token& t) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * TOKEN_SIZE);
+    for (uint8_t b : t) {
+        hex.push_back(digits[b >> 4]);
+        hex.push_back(digits[b & 0xF]);
+    }
+    return hex;
+}
+
+} // namespace network::datagrams
@@ -0,0 +1,30 @@
+#include "network/deflate.h"
+
+#include <zlib.h>
+
+namespace network {
+
+Deflater::Deflater(int level) : stream_(new z_stream{}) {
+    // windowBits < 0: raw deflate; memLevel 8 is zlib's default
+    ok_ = deflateInit2(stream_, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+Deflater::~Deflater() {
+    if (ok_) deflateEnd(stream_);
+    delete stream_;
+}
+
+std::string_view Deflater::compress(std::string_view in) {
+    if (!ok_ || deflateReset(stream_) != Z_OK) return {};
+
+    out_.resize(deflateBound(stream_, static_cast<uLong>(in.size())));
+    stream_->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    stream_->avail_in = static_cast<uInt>(in.size());
+    stream_->next_out = reinterpret_cast<Bytef*>(out_.data());
+    stream_->avail_out = static_cast<uInt>(out_.size());
+
+    if (deflate(stream_, Z_FINISH) != Z_STREAM_END) return {};
+    return {out_.data(), out_.size() - stream_->avail_out};
+}
+
+} // namespace network
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+typedef struct z_stream_s z_stream;
+
+namespace network {
+
+// Raw DEFLATE (RFC 1951, no zlib header) of whole messages, each on its own:
+// the output inflates without any earlier frames, so it can be published
+// once and read by any subscriber, late joiners included. Browsers decode
+// it with DecompressionStream("deflate-raw").
+//
+// permessage-deflate doesn't fit one-to-many: uWS compresses per socket.
+class Deflater {
+public:
+    explicit Deflater(int level = 1);
+    ~Deflater();
+
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    // Compressed bytes, valid until the next call; empty on failure
+    std::string_view compress(std::string_view in);
+
+private:
+    z_stream* stream_;
+    bool ok_;
+    std::string out_;
+};
+
+} // namespace network
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Binary frames of lockstep rooms (everything else on the wire is JSON, see
+// messages.h). Little-endian, no padding:
+//
+//   client → server  INPUT     0x01 | tick u32 | actions u8                    6 bytes
+//   server → client  TICK      0x02 | tick u32 | count u8 | count × slot u8    6 + slots
+//   server → client  CHECKSUM  0x03 | tick u32 | checksum u64                  13 bytes
+//
+// An INPUT's actions (game::input bits) hold until the next INPUT: clients
+// send one when their buttons change, not every tick. A TICK carries the
+// actions every slot 0..count-1 used for `tick`, with PRESENT set on the
+// occupied ones. CHECKSUM is game::LockstepSim::checksum() after `tick`.
+namespace network::frames {
+
+enum Kind : uint8_t { INPUT = 0x01, TICK = 0x02, CHECKSUM = 0x03 };
+
+constexpr uint8_t PRESENT = 0x80;
+constexpr std::size_t INPUT_SIZE = 6;
+constexpr std::size_t TICK_HEADER = 6;
+constexpr std::size_t CHECKSUM_SIZE = 13;
+
+struct Input {
+    uint32_t tick = 0;
+    uint8_t actions = 0;
+};
+
+namespace detail {
+inline void put(std::string& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+inline uint64_t get(std::string_view in, std::size_t at, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= uint64_t(static_cast<uint8_t>(in[at + i])) << (8 * i);
+    return v;
+}
+} // namespace detail
+
+inline std::optional<Input> read_input(std::string_view frame) {
+    if (frame.size() != INPUT_SIZE || static_cast<uint8_t>(frame[0]) != INPUT) return std::nullopt;
+    return Input{static_cast<uint32_t>(detail::get(frame, 1, 4)), static_cast<uint8_t>(frame[5])};
+}
+
+inline void write_tick(std::string& out, uint32_t tick, const uint8_t* slots, std::size_t count) {
+    out.push_back(static_cast<char>(TICK));
+    detail::put(out, tick, 4);
+    out.push_back(static_cast<char>(count));
+    out.append(reinterpret_cast<const char*>(slots), count);
+}
+
+inline void write_checksum(std::string& out, uint32_t tick, uint64_t checksum) {
+    out.push_back(static_cast<char>(CHECKSUM));
+    detail::put(out, tick, 4);
+    detail::put(out, checksum, 8);
+}
+
+} // namespace network::frames
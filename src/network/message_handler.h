@@ -1,84 +1,159 @@
 #pragma once
 
 #include <string>
-#include <nlohmann/json.hpp>
+#include <string_view>
 
 #include "game/room.h"
+#include "network/input_frames.h"
+#include "network/messages.h"
 #include "network/protocol.h"
 #include "utils/logger.h"
+#include "utils/trace.h"
 
 namespace network {
 
-// Handles a single parsed message from a player inside a room.
-// Returns false if the message type is unrecognized (non-fatal).
-inline bool handle_message(game::Room& room,
-                           const std::string& player_id,
-                           const nlohmann::json& msg) {
-    std::string type = get_type(msg);
-    if (type.empty()) {
-        room.send_to(player_id, make_error(400, "Missing or invalid 'type' field"));
-        return false;
-    }
+// Every message type a client may send. Adding one: declare it in
+// messages.h (with its rate_class), list it here, and add its operator() to
+// RoomHandlers — the dispatcher refuses to compile until the handler exists.
+using InboundDispatcher = schema::Dispatcher<
+    msg::Ping,
+    msg::PlayerReady,
+    msg::ChatMessage,
+    msg::PlayerInput,
+    msg::ProbeAck,
+    msg::TimeSyncRequest,
+    msg::ResyncRequest,
+    msg::PlayerAction,
+    msg::BuyItem>;
+
+template <typename D> struct ClassTable;
+template <typename... Ms> struct ClassTable<schema::Dispatcher<Ms...>> {
+    static constexpr msg::MessageClass of[] = {Ms::rate_class...};
+};
+
+// Rate-limit class of a raw frame from its sniffed "type", before any
+// parse — so a flood of junk costs a byte scan, not a full decode
+inline msg::MessageClass classify(std::string_view raw) {
+    int idx = InboundDispatcher::lookup(schema::sniff_type(raw));
+    return idx < 0 ? msg::MessageClass::OTHER : ClassTable<InboundDispatcher>::of[idx];
+}
+
+// Typed handlers for one player's messages inside a room.
+// Each returns false if the message was rejected (non-fatal).
+struct RoomHandlers {
+    game::Room& room;
+    const std::string& player_id;
 
     // ── Heartbeat ───────────────────────────────
-    if (type == "ping") {
-        room.send_to(player_id, {{"type", "pong"}});
+    bool operator()(const msg::Ping&) const {
+        static const std::string pong = serialize(msg::Pong{});
+        room.send_to(player_id, pong);
+        return true;
+    }
+
+    // ── Latency ─────────────────────────────────
+    bool operator()(const msg::ProbeAck& m) const {
+        return room.record_probe_ack(player_id, m.probe, static_cast<float>(m.hold_ms),
+                                     network::server_time_us());
+    }
+
+    bool operator()(const msg::TimeSyncRequest& m) const {
+        room.handle_time_sync(player_id, m.client_time, network::server_time_us());
+        return true;
+    }
+
+    // ── Lockstep ──────────────────────────────────
+    bool operator()(const msg::ResyncRequest& m) const {
+        if (room.mode() != game::RoomMode::LOCKSTEP) return false;
+        room.request_resync(player_id, m.tick);
         return true;
     }
 
     // ── Lobby messages ────────────────────────────
-    if (type == "player_ready") {
-        bool ready = msg.value("ready", false);
-        room.set_player_ready(player_id, ready);
+    bool operator()(const msg::PlayerReady& m) const {
+        room.set_player_ready(player_id, m.ready);
         return true;
     }
 
-    if (type == "chat_message") {
-        std::string message = msg.value("message", "");
-        if (message.empty()) {
+    bool operator()(const msg::ChatMessage& m) const {
+        if (m.message.empty()) {
             room.send_to(player_id, make_error(400, "Empty chat message"));
             return false;
         }
+        std::string_view message = m.message;
         if (message.size() > 200) {
             message = message.substr(0, 200);
+            // Don't cut a multi-byte UTF-8 sequence in half
+            while (!message.empty() && (static_cast<unsigned char>(m.message[message.size()]) & 0xC0) == 0x80) {
+                message.remove_suffix(1);
+            }
         }
         room.handle_chat(player_id, message);
         return true;
     }
 
     // ── Gameplay messages ─────────────────────────
-    if (type == "player_input") {
-        int tick = msg.value("tick", 0);
-
-        std::vector<std::string> actions;
-        if (msg.contains("actions") && msg["actions"].is_array()) {
-            for (const auto& a : msg["actions"]) {
-                if (a.is_string()) {
-                    actions.push_back(a.get<std::string>());
-                }
-            }
-        }
-
-        room.queue_input(player_id, tick, actions);
+    bool operator()(const msg::PlayerInput& m) const {
+        room.queue_input(player_id, m.tick, m.actions.bits);
         return true;
     }
 
-    if (type == "player_action") {
+    bool operator()(const msg::PlayerAction&) const {
         // Phase 3+: use_item, etc.
         logger::debug("received player_action from " + player_id + " (Phase 3)");
         return true;
     }
 
-    if (type == "buy_item") {
+    bool operator()(const msg::BuyItem&) const {
         // Phase 4: shop system
         logger::debug("received buy_item from " + player_id + " (Phase 4)");
         return true;
     }
+};
+
+// Handles a single raw message from a player inside a room.
+// Returns false if the message was invalid, unrecognized or rejected (non-fatal).
+inline bool handle_message(game::Room& room,
+                           const std::string& player_id,
+                           std::string_view raw) {
+    TRACE_SCOPE("net", "msg.dispatch");
+    auto result = InboundDispatcher::dispatch(raw, RoomHandlers{room, player_id});
 
-    // Unknown message type — log but don't spam the client
-    logger::warn("unknown message type '" + type + "' from player " + player_id);
-    room.send_to(player_id, make_error(400, "Unknown message type: " + type));
+    switch (result.status) {
+        case schema::DispatchStatus::OK:
+            return result.handled;
+
+        case schema::DispatchStatus::INVALID_JSON:
+            room.send_to(player_id, make_error(400, "Invalid JSON"));
+            return false;
+
+        case schema::DispatchStatus::MISSING_TYPE:
+            room.send_to(player_id, make_error(400, "Missing or invalid 'type' field"));
+            return false;
+
+        case schema::DispatchStatus::UNKNOWN_TYPE: {
+            // Unknown message type — log but don't spam the client
+            logger::warn("unknown message type '" + result.type + "' from player " + player_id);
+            room.send_to(player_id, make_error(400, "Unknown message type: " + result.type));
+            return false;
+        }
+    }
     return false;
 }
 
+// Binary frames are lockstep INPUTs (network/input_frames.h); nothing else
+// is sent in binary
+inline bool handle_binary(game::Room& room,
+                          const std::string& player_id,
+                          std::string_view raw) {
+    TRACE_SCOPE("net", "msg.binary");
+    auto in = frames::read_input(raw);
+    if (!in || room.mode() != game::RoomMode::LOCKSTEP) {
+        room.send_to(player_id, make_error(400, "Unexpected binary frame"));
+        return false;
+    }
+    room.queue_input(player_id, static_cast<int>(in->tick), in->actions & game::input::ALL);
+    return true;
+}
+
 } // namespace network
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "network/schema.h"
+#include "game/player.h"
+
+// Every message on the wire, declared once. See network/schema.h for what
+// the `schema` alias generates. Outbound messages hold views, so building
+// one copies nothing; serialize() right away.
+namespace network::msg {
+
+using schema::Field;
+using schema::RawJson;
+using schema::Schema;
+
+// ── Client → server ─────────────────────────────────
+
+// Rate-limit class of an inbound message: each class has its own per-
+// connection budget (see server/inbound_limiter.h). OTHER covers types no
+// struct claims, which are still counted before they're refused.
+enum class MessageClass : uint8_t { INPUT, CHAT, CONTROL, ACTION, OTHER, COUNT };
+
+inline constexpr std::string_view class_name(MessageClass c) {
+    switch (c) {
+        case MessageClass::INPUT: return "input";
+        case MessageClass::CHAT: return "chat";
+        case MessageClass::CONTROL: return "control";
+        case MessageClass::ACTION: return "action";
+        default: return "other";
+    }
+}
+
+// "actions": ["left", "jump", ...] folded into game::input bits while parsing,
+// in order (game::input::add_action)
+struct ActionMask {
+    uint8_t bits = 0;
+};
+
+inline bool read_value(schema::Reader& r, ActionMask& out) {
+    if (r.peek() != '[') return r.skip_value();
+    std::string scratch;
+    return r.array([&] {
+        if (r.peek() != '"') return r.skip_value();
+        std::string_view action;
+        if (!r.string(action, scratch)) return false;
+        out.bits = game::input::add_action(out.bits, action);
+        return true;
+    });
+}
+
+struct Ping {
+    static constexpr auto rate_class = MessageClass::CONTROL;
+    using schema = Schema<"ping">;
+};
+
+struct PlayerReady {
+    bool ready = false;
+    static constexpr auto rate_class = MessageClass::ACTION;
+    using schema = Schema<"player_ready", Field<"ready", &PlayerReady::ready>>;
+};
+
+struct ChatMessage {
+    std::string message;
+    static constexpr auto rate_class = MessageClass::CHAT;
+    using schema = Schema<"chat_message", Field<"message", &ChatMessage::message>>;
+};
+
+struct PlayerInput {
+    int tick = 0;
+    ActionMask actions;
+    static constexpr auto rate_class = MessageClass::INPUT;
+    using schema = Schema<"player_input",
+        Field<"tick", &PlayerInput::tick>,
+        Field<"actions", &PlayerInput::actions>>;
+};
+
+// Echo of a game_state "probe" (server µs), sent back as soon as it's seen;
+// hold_ms = how long the client sat on it before replying
+struct ProbeAck {
+    int64_t probe = 0;
+    double hold_ms = 0.0;
+    static constexpr auto rate_class = MessageClass::CONTROL;
+    using schema = Schema<"probe_ack",
+        Field<"probe", &ProbeAck::probe>,
+        Field<"hold_ms", &ProbeAck::hold_ms>>;
+};
+
+// NTP-style clock sync; client_time is the client's own clock, echoed back
+struct TimeSyncRequest {
+    double client_time = 0.0;
+    static constexpr auto rate_class = MessageClass::CONTROL;
+    using schema = Schema<"time_sync", Field<"client_time", &TimeSyncRequest::client_time>>;
+};
+
+// Lockstep rooms: the client's state stopped matching the CHECKSUM frames;
+// answered with lockstep_state. tick = where it noticed, for the log.
+struct ResyncRequest {
+    int tick = 0;
+    static constexpr auto rate_class = MessageClass::CONTROL;
+    using schema = Schema<"resync_request", Field<"tick", &ResyncRequest::tick>>;
+};
+
+struct PlayerAction {
+    static constexpr auto rate_class = MessageClass::ACTION;
+    using schema = Schema<"player_action">;  // Phase 3
+};
+
+struct BuyItem {
+    static constexpr auto rate_class = MessageClass::ACTION;
+    using schema = Schema<"buy_item">;       // Phase 4
+};
+
+// ── Server → client ─────────────────────────────────
+
+struct Error {
+    int code = 0;
+    std::string_view message;
+    using schema = Schema<"error",
+        Field<"code", &Error::code>,
+        Field<"message", &Error::message>>;
+};
+
+struct Pong {
+    using schema = Schema<"pong">;
+};
+
+// Reply to time_sync. With t0 = client_time and t3 = local receive time the
+// client gets offset = ((recv - t0) + (send - t3)) / 2 in server µs, and the
+// room tick at `send`. interp_ms is how far behind the newest snapshot the
+// server suggests rendering (two snapshot intervals plus twice the jitter).
+struct TimeSync {
+    double client_time = 0.0;
+    int64_t server_recv_us = 0;
+    int64_t server_send_us = 0;
+    int server_tick = 0;
+    double tick_ms = 0;
+    double snapshot_ms = 0;
+    double interp_ms = 0;
+    double rtt_ms = 0;
+    double jitter_ms = 0;
+    using schema = Schema<"time_sync",
+        Field<"client_time", &TimeSync::client_time>,
+        Field<"server_recv_us", &TimeSync::server_recv_us>,
+        Field<"server_send_us", &TimeSync::server_send_us>,
+        Field<"server_tick", &TimeSync::server_tick>,
+        Field<"tick_ms", &TimeSync::tick_ms>,
+        Field<"snapshot_ms", &TimeSync::snapshot_ms>,
+        Field<"interp_ms", &TimeSync::interp_ms>,
+        Field<"rtt_ms", &TimeSync::rtt_ms>,
+        Field<"jitter_ms", &TimeSync::jitter_ms>>;
+};
+
+struct Connected {
+    std::string_view player_id;
+    std::string_view player_name;
+    int server_tick = 0;
+    std::string_view room_state;
+    using schema = Schema<"connected",
+        Field<"player_id", &Connected::player_id>,
+        Field<"player_name", &Connected::player_name>,
+        Field<"server_tick", &Connected::server_tick>,
+        Field<"room_state", &Connected::room_state>>;
+};
+
+// First frame on a spectator connection; the stream then runs delay_ms
+// behind the players at one snapshot per interval_ms
+struct Spectating {
+    std::string_view room_id;
+    std::string_view room_state;
+    int server_tick = 0;
+    int delay_ms = 0;
+    int interval_ms = 0;
+    bool deflate = false;
+    using schema = Schema<"spectating",
+        Field<"room_id", &Spectating::room_id>,
+        Field<"room_state", &Spectating::room_state>,
+        Field<"server_tick", &Spectating::server_tick>,
+        Field<"delay_ms", &Spectating::delay_ms>,
+        Field<"interval_ms", &Spectating::interval_ms>,
+        Field<"deflate", &Spectating::deflate>>;
+};
+
+struct PlayerJoined {
+    std::string_view player_id;
+    std::string_view player_name;
+    using schema = Schema<"player_joined",
+        Field<"player_id", &PlayerJoined::player_id>,
+        Field<"player_name", &PlayerJoined::player_name>>;
+};
+
+struct PlayerLeft {
+    std::string_view player_id;
+    using schema = Schema<"player_left", Field<"player_id", &PlayerLeft::player_id>>;
+};
+
+struct Redirect {
+    std::string_view url;
+    using schema = Schema<"redirect", Field<"url", &Redirect::url>>;
+};
+
+// UDP channel (server/udp_channel.h): the token to send back in a HELLO
+// datagram to `port` on the same host, then whether the channel is in use
+struct UdpOffer {
+    int port = 0;
+    std::string_view token;        // 32 hex digits
+    int timeout_ms = 0;            // silence after which snapshots return to the WebSocket
+    using schema = Schema<"udp_offer",
+        Field<"port", &UdpOffer::port>,
+        Field<"token", &UdpOffer::token>,
+        Field<"timeout_ms", &UdpOffer::timeout_ms>>;
+};
+
+struct UdpState {
+    bool active = false;
+    using schema = Schema<"udp_state", Field<"active", &UdpState::active>>;
+};
+
+struct ServerRestart {
+    std::string_view room_id;
+    bool resume = true;
+    int retry_ms = 0;
+    using schema = Schema<"server_restart",
+        Field<"room_id", &ServerRestart::room_id>,
+        Field<"resume", &ServerRestart::resume>,
+        Field<"retry_ms", &ServerRestart::retry_ms>>;
+};
+
+struct PlayerReadyState {
+    std::string_view player_id;
+    bool ready = false;
+    using schema = Schema<"player_ready_state",
+        Field<"player_id", &PlayerReadyState::player_id>,
+        Field<"ready", &PlayerReadyState::ready>>;
+};
+
+struct ChatBroadcast {
+    std::string_view player_id;
+    std::string_view player_name;
+    std::string_view message;
+    using schema = Schema<"chat_message",
+        Field<"player_id", &ChatBroadcast::player_id>,
+        Field<"player_name", &ChatBroadcast::player_name>,
+        Field<"message", &ChatBroadcast::message>>;
+};
+
+struct LobbyPlayer {
+    std::string_view id;
+    std::string_view name;
+    std::string_view display_name;
+    bool ready = false;
+    using schema = Schema<"",
+        Field<"id", &LobbyPlayer::id>,
+        Field<"name", &LobbyPlayer::name>,
+        Field<"display_name", &LobbyPlayer::display_name>,
+        Field<"ready", &LobbyPlayer::ready>>;
+};
+
+struct LobbyState {
+    std::string_view room_id;
+    std::string_view state;
+    int max_players = 0;
+    std::vector<LobbyPlayer> players;
+    using schema = Schema<"lobby_state",
+        Field<"room_id", &LobbyState::room_id>,
+        Field<"state", &LobbyState::state>,
+        Field<"max_players", &LobbyState::max_players>,
+        Field<"players", &LobbyState::players>>;
+};
+
+struct SpawnAssignment {
+    std::string_view player_id;
+    float x = 0;
+    float y = 0;
+    using schema = Schema<"",
+        Field<"player_id", &SpawnAssignment::player_id>,
+        Field<"x", &SpawnAssignment::x>,
+        Field<"y", &SpawnAssignment::y>>;
+};
+
+struct GameStart {
+    int round = 1;
+    RawJson map_data;
+    std::vector<SpawnAssignment> spawn_points;
+    using schema = Schema<"game_start",
+        Field<"round", &GameStart::round>,
+        Field<"map_data", &GameStart::map_data>,
+        Field<"spawn_points", &GameStart::spawn_points>>;
+};
+
+struct GameRejoin {
+    int tick = 0;
+    int round = 1;
+    RawJson map_data;
+    using schema = Schema<"game_rejoin",
+        Field<"tick", &GameRejoin::tick>,
+        Field<"round", &GameRejoin::round>,
+        Field<"map_data", &GameRejoin::map_data>>;
+};
+
+// Lockstep rooms: everyone's simulation state after `tick`, so a client
+// can (re)start stepping from the next TICK frame (network/input_frames.h).
+// Sent at match start, whenever someone joins or rejoins, and on
+// resync_request. Positions and velocities are raw Q16.16 (game/fixed.h).
+struct LockstepBody {
+    std::string_view player_id;
+    int slot = 0;
+    int32_t x = 0, y = 0, vx = 0, vy = 0;
+    bool grounded = false;
+    int facing = 1;                // 0 left, 1 right (game::Facing)
+    using schema = Schema<"",
+        Field<"player_id", &LockstepBody::player_id>,
+        Field<"slot", &LockstepBody::slot>,
+        Field<"x", &LockstepBody::x>,
+        Field<"y", &LockstepBody::y>,
+        Field<"vx", &LockstepBody::vx>,
+        Field<"vy", &LockstepBody::vy>,
+        Field<"grounded", &LockstepBody::grounded>,
+        Field<"facing", &LockstepBody::facing>>;
+};
+
+struct LockstepState {
+    int tick = 0;
+    int32_t dt = 0;                // raw Q16.16 seconds per tick
+    int checksum_interval = 0;     // ticks between CHECKSUM frames
+    std::vector<LockstepBody> players;
+    using schema = Schema<"lockstep_state",
+        Field<"tick", &LockstepState::tick>,
+        Field<"dt", &LockstepState::dt>,
+        Field<"checksum_interval", &LockstepState::checksum_interval>,
+        Field<"players", &LockstepState::players>>;
+};
+
+} // namespace network::msg
@@ -1,67 +1,63 @@
 #pragma once
 
 #include <string>
-#include <optional>
-#include <nlohmann/json.hpp>
+#include <string_view>
 
-namespace network {
+#include "network/messages.h"
 
-// Parse an incoming JSON message. Returns nullopt if invalid JSON.
-inline std::optional<nlohmann::json> parse_message(std::string_view raw) {
-    try {
-        return nlohmann::json::parse(raw);
-    } catch (const nlohmann::json::parse_error&) {
-        return std::nullopt;
-    }
-}
+namespace network {
 
-// Extract message type from a parsed message.
-inline std::string get_type(const nlohmann::json& msg) {
-    if (msg.contains("type") && msg["type"].is_string()) {
-        return msg["type"].get<std::string>();
-    }
-    return "";
-}
+using schema::serialize;
 
 // Build standard error response
-inline nlohmann::json make_error(int code, const std::string& message) {
-    return {
-        {"type", "error"},
-        {"code", code},
-        {"message", message}
-    };
+inline std::string make_error(int code, std::string_view message) {
+    return serialize(msg::Error{code, message});
 }
 
 // Build connected response
-inline nlohmann::json make_connected(const std::string& player_id,
-                                      const std::string& player_name,
-                                      int server_tick,
-                                      const std::string& room_state = "waiting") {
-    return {
-        {"type", "connected"},
-        {"player_id", player_id},
-        {"player_name", player_name},
-        {"server_tick", server_tick},
-        {"room_state", room_state}
-    };
+inline std::string make_connected(std::string_view player_id,
+                                  std::string_view player_name,
+                                  int server_tick,
+                                  std::string_view room_state = "waiting") {
+    return serialize(msg::Connected{player_id, player_name, server_tick, room_state});
+}
+
+// Build spectating — first frame to a spectator
+inline std::string make_spectating(std::string_view room_id, std::string_view room_state,
+                                   int server_tick, int delay_ms, int interval_ms, bool deflate) {
+    return serialize(msg::Spectating{room_id, room_state, server_tick, delay_ms, interval_ms, deflate});
 }
 
 // Build player_joined event
-inline nlohmann::json make_player_joined(const std::string& player_id,
-                                          const std::string& player_name) {
-    return {
-        {"type", "player_joined"},
-        {"player_id", player_id},
-        {"player_name", player_name}
-    };
+inline std::string make_player_joined(std::string_view player_id,
+                                      std::string_view player_name) {
+    return serialize(msg::PlayerJoined{player_id, player_name});
 }
 
 // Build player_left event
-inline nlohmann::json make_player_left(const std::string& player_id) {
-    return {
-        {"type", "player_left"},
-        {"player_id", player_id}
-    };
+inline std::string make_player_left(std::string_view player_id) {
+    return serialize(msg::PlayerLeft{player_id});
+}
+
+// Build redirect — the room lives on another node; reconnect to url
+inline std::string make_redirect(std::string_view url) {
+    return serialize(msg::Redirect{url});
+}
+
+// Build udp_offer — sent after connected to clients that asked for ?udp=1
+inline std::string make_udp_offer(int port, std::string_view token, int timeout_ms) {
+    return serialize(msg::UdpOffer{port, token, timeout_ms});
+}
+
+// Build udp_state — snapshots now travel over UDP (active) or the WebSocket
+inline std::string make_udp_state(bool active) {
+    return serialize(msg::UdpState{active});
+}
+
+// Build server_restart — the server is being replaced; reconnect to the same
+// URL after retry_ms and the match resumes where it left off
+inline std::string make_server_restart(std::string_view room_id, int retry_ms) {
+    return serialize(msg::ServerRestart{room_id, true, retry_ms});
 }
 
 } // namespace network
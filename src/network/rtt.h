@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+namespace network {
+
+// Server clock for probes and time sync: µs since its first use (server
+// startup). Monotonic; clients only ever compare it with values it handed out.
+inline int64_t server_time_us() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+// Milliseconds for the wire, to 0.01 ms (doubles print without float noise)
+inline double wire_ms(float ms) {
+    return std::round(static_cast<double>(ms) * 100.0) / 100.0;
+}
+
+// Smoothed round-trip time and jitter for one connection, updated the way
+// TCP does it (RFC 6298): srtt moves 1/8 towards each sample, the mean
+// deviation 1/4.
+class RttEstimator {
+public:
+    void add_sample(float rtt_ms) {
+        if (samples_ == 0) {
+            srtt_ = rtt_ms;
+            rttvar_ = rtt_ms / 2;
+            min_ = rtt_ms;
+        } else {
+            rttvar_ += 0.25f * (std::abs(srtt_ - rtt_ms) - rttvar_);
+            srtt_ += 0.125f * (rtt_ms - srtt_);
+            min_ = std::min(min_, rtt_ms);
+        }
+        last_ = rtt_ms;
+        samples_++;
+    }
+
+    bool valid() const { return samples_ > 0; }
+    float srtt_ms() const { return srtt_; }
+    float jitter_ms() const { return rttvar_; }
+    float min_ms() const { return min_; }
+    float last_ms() const { return last_; }
+    uint32_t samples() const { return samples_; }
+
+private:
+    float srtt_ = 0.0f;
+    float rttvar_ = 0.0f;
+    float min_ = 0.0f;
+    float last_ = 0.0f;
+    uint32_t samples_ = 0;
+};
+
+// RTT samples bucketed by upper bound in ms (last bucket = anything above).
+// Fixed buckets so room histograms add up into the shard's.
+class RttHistogram {
+public:
+    static constexpr std::array<int, 12> BOUNDS_MS = {10, 20, 30, 40, 50, 75, 100, 150, 200, 300, 500, 1000};
+
+    void add(float rtt_ms) {
+        auto it = std::lower_bound(BOUNDS_MS.begin(), BOUNDS_MS.end(), rtt_ms,
+                                   [](int bound, float v) { return static_cast<float>(bound) < v; });
+        counts_[static_cast<std::size_t>(it - BOUNDS_MS.begin())]++;
+        total_++;
+    }
+
+    void merge(const RttHistogram& o) {
+        for (std::size_t i = 0; i < counts_.size(); ++i) counts_[i] += o.counts_[i];
+        total_ += o.total_;
+    }
+
+    uint64_t count() const { return total_; }
+
+    // Upper bound of the bucket holding the p-th percentile; the overflow
+    // bucket reports the last bound, an empty histogram 0
+    int percentile(double p) const {
+        if (total_ == 0) return 0;
+        auto rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total_)));
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < BOUNDS_MS.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= rank) return BOUNDS_MS[i];
+        }
+        return BOUNDS_MS.back();
+    }
+
+    nlohmann::json to_json() const {
+        nlohmann::json buckets = nlohmann::json::object();
+        for (std::size_t i = 0; i < BOUNDS_MS.size(); ++i) {
+            buckets["le_" + std::to_string(BOUNDS_MS[i])] = counts_[i];
+        }
+        buckets["inf"] = counts_.back();
+        return {
+            {"count", total_},
+            {"p50_ms", percentile(50)},
+            {"p90_ms", percentile(90)},
+            {"p99_ms", percentile(99)},
+            {"buckets", std::move(buckets)}
+        };
+    }
+
+private:
+    std::array<uint64_t, BOUNDS_MS.size() + 1> counts_{};
+    uint64_t total_ = 0;
+};
+
+} // namespace network
@@ -0,0 +1,693 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "utils/json_writer.h"
+
+// Compile-time message schema.
+//
+// A message is a plain struct with a nested `schema` alias naming its wire
+// type and fields:
+//
+//   struct PlayerLeft {
+//       std::string_view player_id;
+//       using schema = Schema<"player_left", Field<"player_id", &PlayerLeft::player_id>>;
+//   };
+//
+// From that alone the templates below generate a serializer (keys pre-built
+// and emitted in sorted order, so output matches nlohmann's dump()), a parser
+// that fills the struct straight from the raw text, and a perfect-hash
+// dispatcher that routes inbound text to a typed handler.
+namespace network::schema {
+
+// ── Schema declaration ──────────────────────────────
+
+template <std::size_t N>
+struct FixedString {
+    char data[N]{};
+
+    constexpr FixedString(const char (&s)[N]) { std::copy_n(s, N, data); }
+    constexpr std::size_t size() const { return N - 1; }
+    constexpr std::string_view view() const { return {data, N - 1}; }
+};
+
+template <FixedString Name, auto Member>
+struct Field {
+    static constexpr auto name = Name;
+    static constexpr auto member = Member;
+};
+
+// Type "" marks a nested object (no "type" key)
+template <FixedString Type, typename... Fields>
+struct Schema {
+    static constexpr auto type = Type;
+    static constexpr bool has_type = Type.size() > 0;
+    using fields = std::tuple<Fields...>;
+    static constexpr std::size_t size = sizeof...(Fields);
+};
+
+// Pre-serialized JSON spliced in verbatim (e.g. cached map_data)
+struct RawJson {
+    std::string_view json;
+};
+
+template <typename T>
+concept Message = requires { typename T::schema; };
+
+namespace detail {
+
+constexpr bool valid_key(std::string_view s) {
+    for (char c : s) {
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) return false;
+    }
+    return !s.empty();
+}
+
+// `{"name":` or `,"name":` — built once per field at compile time
+template <char Lead, FixedString Name>
+struct KeyFragment {
+    static_assert(valid_key(Name.view()), "schema keys are [a-z0-9_]+ and need no escaping");
+    static constexpr auto chars = [] {
+        std::array<char, Name.size() + 4> a{};
+        a[0] = Lead;
+        a[1] = '"';
+        for (std::size_t i = 0; i < Name.size(); ++i) a[2 + i] = Name.data[i];
+        a[Name.size() + 2] = '"';
+        a[Name.size() + 3] = ':';
+        return a;
+    }();
+    static constexpr std::string_view view{chars.data(), chars.size()};
+};
+
+// `{"type":"pong"` or `,"type":"pong"`
+template <char Lead, FixedString Type>
+struct TypeFragment {
+    static_assert(valid_key(Type.view()), "message types are [a-z0-9_]+");
+    static constexpr auto chars = [] {
+        constexpr std::string_view key = "\"type\":\"";
+        std::array<char, key.size() + Type.size() + 2> a{};
+        a[0] = Lead;
+        for (std::size_t i = 0; i < key.size(); ++i) a[1 + i] = key[i];
+        for (std::size_t i = 0; i < Type.size(); ++i) a[1 + key.size() + i] = Type.data[i];
+        a[a.size() - 1] = '"';
+        return a;
+    }();
+    static constexpr std::string_view view{chars.data(), chars.size()};
+};
+
+template <typename S, std::size_t I>
+using field_at = std::tuple_element_t<I, typename S::fields>;
+
+// Emission order: slots 0..size-1 are fields, slot `size` is "type".
+// Sorted by key, like nlohmann's std::map-backed objects.
+template <typename S>
+constexpr auto key_order() {
+    constexpr std::size_t n = S::size + (S::has_type ? 1 : 0);
+    std::array<std::string_view, n> names{};
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((names[I] = field_at<S, I>::name.view()), ...);
+    }(std::make_index_sequence<S::size>{});
+    if constexpr (S::has_type) names[S::size] = "type";
+
+    std::array<std::size_t, n> order{};
+    for (std::size_t i = 0; i < n; ++i) order[i] = i;
+    for (std::size_t i = 1; i < n; ++i) {
+        for (std::size_t j = i; j > 0 && names[order[j]] < names[order[j - 1]]; --j) {
+            std::swap(order[j], order[j - 1]);
+        }
+    }
+    for (std::size_t i = 1; i < n; ++i) {
+        if (names[order[i]] == names[order[i - 1]]) throw "duplicate key in schema";
+    }
+    return order;
+}
+
+template <typename T> struct is_vector : std::false_type {};
+template <typename T, typename A> struct is_vector<std::vector<T, A>> : std::true_type {};
+
+} // namespace detail
+
+// ── Serializer ──────────────────────────────────────
+
+template <typename T>
+void write_value(utils::JsonWriter& w, const T& v);
+
+template <Message T>
+void write_object(utils::JsonWriter& w, const T& msg) {
+    using S = typename T::schema;
+    static constexpr auto order = detail::key_order<S>();
+
+    if constexpr (order.size() == 0) {
+        w.raw("{}");
+    } else {
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            auto slot = [&]<std::size_t Pos>(std::integral_constant<std::size_t, Pos>) {
+                constexpr std::size_t idx = order[Pos];
+                constexpr char lead = Pos == 0 ? '{' : ',';
+                if constexpr (idx == S::size) {
+                    w.raw(detail::TypeFragment<lead, S::type>::view);
+                } else {
+                    using F = detail::field_at<S, idx>;
+                    w.raw(detail::KeyFragment<lead, F::name>::view);
+                    write_value(w, msg.*F::member);
+                }
+            };
+            (slot(std::integral_constant<std::size_t, I>{}), ...);
+        }(std::make_index_sequence<order.size()>{});
+        w.raw('}');
+    }
+}
+
+template <typename T>
+void write_value(utils::JsonWriter& w, const T& v) {
+    if constexpr (std::is_same_v<T, bool>) {
+        w.boolean(v);
+    } else if constexpr (std::is_integral_v<T>) {
+        w.integer(static_cast<int64_t>(v));
+    } else if constexpr (std::is_same_v<T, double>) {
+        w.number(v);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        w.number(static_cast<float>(v));
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        w.string(std::string_view(v));
+    } else if constexpr (std::is_same_v<T, RawJson>) {
+        w.raw(v.json);
+    } else if constexpr (detail::is_vector<T>::value) {
+        w.raw('[');
+        bool first = true;
+        for (const auto& e : v) {
+            if (!first) w.raw(',');
+            first = false;
+            write_value(w, e);
+        }
+        w.raw(']');
+    } else if constexpr (Message<T>) {
+        write_object(w, v);
+    } else {
+        static_assert(sizeof(T) == 0, "no JSON writer for this field type");
+    }
+}
+
+// One-shot serialization into a fresh string
+template <Message T>
+std::string serialize(const T& msg) {
+    std::string out;
+    utils::JsonWriter w(out);
+    write_object(w, msg);
+    return out;
+}
+
+// ── Parser ──────────────────────────────────────────
+
+// Strict single-pass JSON reader over the raw frame. It validates as it goes
+// (including UTF-8), so the output of a successful parse can be re-sent
+// without further checks.
+class Reader {
+public:
+    static constexpr int MAX_DEPTH = 32;  // nested containers, the frame's own included
+
+    explicit Reader(std::string_view s) : s_(s) {}
+
+    bool ok() const { return ok_; }
+    bool fail() { ok_ = false; return false; }
+
+    void skip_ws() {
+        while (pos_ < s_.size()) {
+            char c = s_[pos_];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+            ++pos_;
+        }
+    }
+
+    char peek() {
+        skip_ws();
+        return pos_ < s_.size() ? s_[pos_] : '\0';
+    }
+
+    bool consume(char c) {
+        if (peek() != c) return false;
+        ++pos_;
+        return true;
+    }
+
+    bool at_end() {
+        skip_ws();
+        return pos_ == s_.size();
+    }
+
+    // String value. Points into the input when there are no escapes,
+    // otherwise into `scratch`.
+    bool string(std::string_view& out, std::string& scratch);
+
+    bool number(double& out);
+    bool literal(std::string_view word);
+
+    // Any value, validated and discarded; `depth` containers enclose it
+    bool skip_value(int depth = 0);
+
+    // Walks an object's members: fn(key, reader) must consume the value
+    template <typename Fn>
+    bool object(Fn&& fn) {
+        if (!consume('{')) return fail();
+        if (consume('}')) return true;
+        std::string key_scratch;
+        do {
+            std::string_view key;
+            if (peek() != '"' || !string(key, key_scratch)) return fail();
+            if (!consume(':')) return fail();
+            if (!fn(key) || !ok_) return fail();
+        } while (consume(','));
+        return consume('}') || fail();
+    }
+
+    // Walks an array: fn(reader) must consume one element
+    template <typename Fn>
+    bool array(Fn&& fn) {
+        if (!consume('[')) return fail();
+        if (consume(']')) return true;
+        do {
+            if (!fn() || !ok_) return fail();
+        } while (consume(','));
+        return consume(']') || fail();
+    }
+
+private:
+    bool utf8(const unsigned char*& p, const unsigned char* end);
+    static void append_utf8(std::string& out, uint32_t cp);
+
+    std::string_view s_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+// Field readers. A value of the wrong JSON type is skipped and the field
+// keeps its default, like json::value(key, default) without the throw.
+// Custom field types add an overload of read_value found by ADL.
+inline bool read_value(Reader& r, bool& out) {
+    char c = r.peek();
+    if (c == 't') { if (!r.literal("true")) return false; out = true; return true; }
+    if (c == 'f') { if (!r.literal("false")) return false; out = false; return true; }
+    return r.skip_value();
+}
+
+template <typename T>
+    requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+bool read_value(Reader& r, T& out) {
+    char c = r.peek();
+    if (c != '-' && (c < '0' || c > '9')) return r.skip_value();
+    double d;
+    if (!r.number(d)) return false;
+    if constexpr (std::is_integral_v<T>) {
+        if (d >= static_cast<double>(std::numeric_limits<T>::min())
+            && d <= static_cast<double>(std::numeric_limits<T>::max())) {
+            out = static_cast<T>(d);
+        }
+    } else {
+        out = static_cast<T>(d);
+    }
+    return true;
+}
+
+inline bool read_value(Reader& r, std::string& out) {
+    if (r.peek() != '"') return r.skip_value();
+    std::string_view v;
+    if (!r.string(v, out)) return false;
+    if (v.data() != out.data()) out.assign(v);
+    return true;
+}
+
+// A repeated key counts once, with its last value, as in a parsed object.
+template <Message T>
+bool read_object(Reader& r, T& msg) {
+    using S = typename T::schema;
+    [[maybe_unused]] static const T defaults{};
+    return r.object([&](std::string_view key) {
+        bool matched = false;
+        bool ok = true;
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((!matched && key == detail::field_at<S, I>::name.view()
+                  ? (matched = true,
+                     msg.*detail::field_at<S, I>::member = defaults.*detail::field_at<S, I>::member,
+                     ok = read_value(r, msg.*detail::field_at<S, I>::member))
+                  : false), ...);
+        }(std::make_index_sequence<S::size>{});
+        return matched ? ok : r.skip_value();
+    });
+}
+
+// ── Dispatcher ──────────────────────────────────────
+
+enum class DispatchStatus { OK, INVALID_JSON, MISSING_TYPE, UNKNOWN_TYPE };
+
+struct DispatchResult {
+    DispatchStatus status;
+    std::string type;         // unescaped; every inbound type fits in SSO
+    bool handled = false;     // the handler's return value
+};
+
+// Unvalidated look at a frame's top-level "type" — the last one, as
+// dispatch() takes it — for decisions that have to come before the parse
+// (rate limiting). One linear pass tracking strings and nesting; a type
+// that isn't a string, or whose key or value has escapes, comes back empty.
+inline std::string_view sniff_type(std::string_view raw) {
+    std::string_view found;
+    int depth = 0;
+    std::size_t i = 0;
+    const std::size_t n = raw.size();
+    auto skip_ws = [&](std::size_t j) {
+        while (j < n && (raw[j] == ' ' || raw[j] == '\t' || raw[j] == '\n' || raw[j] == '\r')) ++j;
+        return j;
+    };
+
+    while (i < n) {
+        char c = raw[i];
+        if (c == '"') {
+            std::size_t start = ++i;
+            bool escaped = false;
+            while (i < n && raw[i] != '"') {
+                if (raw[i] == '\\') {
+                    escaped = true;
+                    ++i;
+                }
+                ++i;
+            }
+            if (i >= n) break;
+            // An escaped key may spell "type" too: it hides any earlier one
+            bool maybe_type = depth == 1 && (escaped || raw.substr(start, i - start) == "type");
+            ++i;
+            if (maybe_type) {
+                std::size_t j = skip_ws(i);
+                if (j < n && raw[j] == ':') {
+                    found = {};
+                    j = skip_ws(j + 1);
+                    if (!escaped && j < n && raw[j] == '"') {
+                        std::size_t value = ++j;
+                        while (j < n && raw[j] != '"' && raw[j] != '\\') ++j;
+                        found = j < n && raw[j] == '"' ? raw.substr(value, j - value) : std::string_view{};
+                    }
+                }
+            }
+        } else {
+            if (c == '{' || c == '[') ++depth;
+            else if (c == '}' || c == ']') --depth;
+            ++i;
+        }
+    }
+    return found;
+}
+
+// Routes raw text by its "type" to handler(const M&) for each inbound
+// message M. Types are looked up through a perfect hash computed at compile
+// time: one hash, one table load and one string compare per message.
+template <Message... Ms>
+class Dispatcher {
+public:
+    static constexpr std::size_t COUNT = sizeof...(Ms);
+    static constexpr std::array<std::string_view, COUNT> names = {Ms::schema::type.view()...};
+
+    static constexpr uint32_t hash(std::string_view s, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char c : s) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+    static constexpr std::size_t TABLE_SIZE = std::bit_ceil(COUNT * 2);
+    static constexpr uint8_t EMPTY = 0xFF;
+
+    // Smallest seed under which every type lands in its own slot
+    static constexpr uint32_t SEED = [] {
+        for (uint32_t seed = 0; seed < 100000; ++seed) {
+            std::array<bool, TABLE_SIZE> used{};
+            bool clash = false;
+            for (auto name : names) {
+                auto slot = hash(name, seed) & (TABLE_SIZE - 1);
+                if (used[slot]) { clash = true; break; }
+                used[slot] = true;
+            }
+            if (!clash) return seed;
+        }
+        throw "no perfect hash seed found";
+    }();
+
+    static constexpr auto table = [] {
+        std::array<uint8_t, TABLE_SIZE> t{};
+        t.fill(EMPTY);
+        for (std::size_t i = 0; i < COUNT; ++i) {
+            t[hash(names[i], SEED) & (TABLE_SIZE - 1)] = static_cast<uint8_t>(i);
+        }
+        return t;
+    }();
+
+    // Index into Ms..., or -1
+    static constexpr int lookup(std::string_view type) {
+        auto i = table[hash(type, SEED) & (TABLE_SIZE - 1)];
+        return i != EMPTY && names[i] == type ? i : -1;
+    }
+
+    template <typename Handler>
+    static DispatchResult dispatch(std::string_view raw, Handler&& handler) {
+        static_assert((std::is_invocable_r_v<bool, Handler&, const Ms&> && ...),
+                      "handler must accept every inbound message type");
+
+        // Pass 1 validates the whole frame and finds "type" wherever it sits
+        std::string_view type;
+        std::string type_scratch;
+        bool have_type = false;
+        Reader scan(raw);
+        if (scan.peek() != '{') {
+            // Well-formed but not an object: it has no type
+            bool valid = scan.skip_value() && scan.at_end();
+            return {valid ? DispatchStatus::MISSING_TYPE : DispatchStatus::INVALID_JSON, {}};
+        }
+        bool valid = scan.object([&](std::string_view key) {
+            if (key != "type") return scan.skip_value(1);
+            // The last "type" counts, string or not
+            have_type = scan.peek() == '"';
+            return have_type ? scan.string(type, type_scratch) : scan.skip_value(1);
+        });
+        if (!valid || !scan.at_end()) return {DispatchStatus::INVALID_JSON, {}};
+        if (!have_type || type.empty()) return {DispatchStatus::MISSING_TYPE, {}};
+
+        int idx = lookup(type);
+        if (idx < 0) return {DispatchStatus::UNKNOWN_TYPE, std::string(type)};
+
+        // Pass 2 fills the typed struct through the per-type table entry
+        using Fn = bool (*)(std::string_view, Handler&);
+        static constexpr Fn handlers[] = {&invoke<Ms, Handler>...};
+        return {DispatchStatus::OK, std::string(type), handlers[idx](raw, handler)};
+    }
+
+private:
+    template <typename M, typename Handler>
+    static bool invoke(std::string_view raw, Handler& handler) {
+        M msg{};
+        Reader r(raw);
+        read_object(r, msg);  // already validated; only fills fields
+        return handler(static_cast<const M&>(msg));
+    }
+};
+
+// ── Reader internals ────────────────────────────────
+
+inline bool Reader::literal(std::string_view word) {
+    skip_ws();
+    if (s_.substr(pos_, word.size()) != word) return fail();
+    pos_ += word.size();
+    return true;
+}
+
+inline bool Reader::number(double& out) {
+    skip_ws();
+    std::size_t start = pos_;
+    auto digits = [&] {
+        std::size_t from = pos_;
+        while (pos_ < s_.size() && s_[pos_] >= '0' && s_[pos_] <= '9') ++pos_;
+        return pos_ > from;
+    };
+
+    if (pos_ < s_.size() && s_[pos_] == '-') ++pos_;
+    if (pos_ < s_.size() && s_[pos_] == '0') {
+        ++pos_;
+    } else if (!digits()) {
+        return fail();
+    }
+    if (pos_ < s_.size() && s_[pos_] == '.') {
+        ++pos_;
+        if (!digits()) return fail();
+    }
+    if (pos_ < s_.size() && (s_[pos_] == 'e' || s_[pos_] == 'E')) {
+        ++pos_;
+        if (pos_ < s_.size() && (s_[pos_] == '+' || s_[pos_] == '-')) ++pos_;
+        if (!digits()) return fail();
+    }
+
+    // Overflow is rejected, as nlohmann does; underflow rounds toward zero
+    // the way nlohmann's strtod does, so 1e-400 reads as 0
+    auto res = std::from_chars(s_.data() + start, s_.data() + pos_, out);
+    if (res.ec == std::errc()) return true;
+    out = std::strtod(std::string(s_.substr(start, pos_ - start)).c_str(), nullptr);
+    return std::isfinite(out) || fail();
+}
+
+inline bool Reader::utf8(const unsigned char*& p, const unsigned char* end) {
+    unsigned char c = *p;
+    int extra;
+    uint32_t cp;
+    if (c >= 0xC2 && c <= 0xDF) { extra = 1; cp = c & 0x1F; }
+    else if (c >= 0xE0 && c <= 0xEF) { extra = 2; cp = c & 0x0F; }
+    else if (c >= 0xF0 && c <= 0xF4) { extra = 3; cp = c & 0x07; }
+    else return false;
+
+    if (end - p <= extra) return false;
+    for (int i = 1; i <= extra; ++i) {
+        if ((p[i] & 0xC0) != 0x80) return false;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    // Reject overlong forms, surrogates and anything past U+10FFFF
+    if ((extra == 2 && cp < 0x800) || (extra == 3 && (cp < 0x10000 || cp > 0x10FFFF))
+        || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return false;
+    }
+    p += extra + 1;
+    return true;
+}
+
+inline void Reader::append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+inline bool Reader::string(std::string_view& out, std::string& scratch) {
+    if (!consume('"')) return fail();
+
+    auto* begin = reinterpret_cast<const unsigned char*>(s_.data() + pos_);
+    auto* end = reinterpret_cast<const unsigned char*>(s_.data() + s_.size());
+    auto* p = begin;
+    bool escaped = false;
+
+    // Fast path: scan until the closing quote or the first escape
+    while (p < end && *p != '"' && *p != '\\') {
+        if (*p < 0x20) return fail();
+        if (*p < 0x80) { ++p; continue; }
+        if (!utf8(p, end)) return fail();
+    }
+    if (p < end && *p == '\\') {
+        escaped = true;
+        scratch.assign(reinterpret_cast<const char*>(begin), p - begin);
+    }
+
+    auto hex4 = [&](uint32_t& v) {
+        if (end - p < 4) return false;
+        v = 0;
+        for (int i = 0; i < 4; ++i) {
+            unsigned char h = p[i];
+            v <<= 4;
+            if (h >= '0' && h <= '9') v |= h - '0';
+            else if (h >= 'a' && h <= 'f') v |= h - 'a' + 10;
+            else if (h >= 'A' && h <= 'F') v |= h - 'A' + 10;
+            else return false;
+        }
+        p += 4;
+        return true;
+    };
+
+    while (escaped && p < end && *p != '"') {
+        if (*p == '\\') {
+            if (++p >= end) return fail();
+            switch (*p++) {
+                case '"':  scratch.push_back('"'); break;
+                case '\\': scratch.push_back('\\'); break;
+                case '/':  scratch.push_back('/'); break;
+                case 'b':  scratch.push_back('\b'); break;
+                case 'f':  scratch.push_back('\f'); break;
+                case 'n':  scratch.push_back('\n'); break;
+                case 'r':  scratch.push_back('\r'); break;
+                case 't':  scratch.push_back('\t'); break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!hex4(cp)) return fail();
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        uint32_t lo;
+                        if (end - p < 2 || p[0] != '\\' || p[1] != 'u') return fail();
+                        p += 2;
+                        if (!hex4(lo) || lo < 0xDC00 || lo > 0xDFFF) return fail();
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        return fail();
+                    }
+                    append_utf8(scratch, cp);
+                    break;
+                }
+                default: return fail();
+            }
+        } else if (*p < 0x20) {
+            return fail();
+        } else if (*p < 0x80) {
+            scratch.push_back(static_cast<char>(*p++));
+        } else {
+            auto* from = p;
+            if (!utf8(p, end)) return fail();
+            scratch.append(reinterpret_cast<const char*>(from), p - from);
+        }
+    }
+
+    if (p >= end) return fail();  // unterminated
+    out = escaped ? std::string_view(scratch)
+                  : std::string_view(reinterpret_cast<const char*>(begin), p - begin);
+    pos_ = static_cast<std::size_t>(reinterpret_cast<const char*>(p + 1) - s_.data());
+    return true;
+}
+
+inline bool Reader::skip_value(int depth) {
+    switch (peek()) {
+        case '{':
+            if (depth >= MAX_DEPTH) return fail();
+            return object([&](std::string_view) { return skip_value(depth + 1); });
+        case '[':
+            if (depth >= MAX_DEPTH) return fail();
+            return array([&] { return skip_value(depth + 1); });
+        case '"': {
+            std::string_view v;
+            std::string scratch;
+            return string(v, scratch);
+        }
+        case 't': return literal("true");
+        case 'f': return literal("false");
+        case 'n': return literal("null");
+        default: {
+            double d;
+            return number(d);
+        }
+    }
+}
+
+} // namespace network::schema
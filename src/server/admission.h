@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+
+#include "utils/memory_stats.h"
+
+namespace server {
+
+// Classic token bucket: refills at `rate` tokens/s up to `burst`.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket() = default;
+    TokenBucket(double rate, double burst, Clock::time_point now)
+        : rate_(rate), burst_(burst), tokens_(burst), last_(now) {}
+
+    bool try_take(Clock::time_point now, double cost = 1.0) {
+        refill(now);
+        if (tokens_ < cost) return false;
+        tokens_ -= cost;
+        return true;
+    }
+
+    // Full bucket = no recent activity
+    bool idle(Clock::time_point now) {
+        refill(now);
+        return tokens_ >= burst_;
+    }
+
+private:
+    void refill(Clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - last_).count();
+        if (elapsed > 0) {
+            tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+            last_ = now;
+        }
+    }
+
+    double rate_ = 0;
+    double burst_ = 0;
+    double tokens_ = 0;
+    Clock::time_point last_{};
+};
+
+// Handshake admission limits, per source address and for the whole node.
+// Checked first thing in .upgrade, before any JWT or room work, so floods
+// and reconnect storms are shed with a cheap 429.
+class AdmissionControl {
+public:
+    using Clock = TokenBucket::Clock;
+
+    AdmissionControl(double per_ip_rate, double per_ip_burst, double global_rate, double global_burst)
+        : per_ip_rate_(per_ip_rate), per_ip_burst_(per_ip_burst),
+          global_(global_rate, global_burst, Clock::now()) {}
+
+    // remote_addr is the raw 4- or 16-byte address from uWS getRemoteAddress()
+    bool admit(std::string_view remote_addr, Clock::time_point now) {
+        AddrKey key(remote_addr);
+        auto it = per_ip_.find(key);
+        if (it == per_ip_.end()) {
+            it = per_ip_.emplace(key, TokenBucket(per_ip_rate_, per_ip_burst_, now)).first;
+        }
+        if (!it->second.try_take(now)) {
+            rejected_ip_++;
+            return false;
+        }
+        if (!global_.try_take(now)) {
+            rejected_global_++;
+            return false;
+        }
+        return true;
+    }
+
+    // Forget addresses whose bucket has refilled — call periodically
+    void prune(Clock::time_point now) {
+        for (auto it = per_ip_.begin(); it != per_ip_.end();) {
+            if (it->second.idle(now)) it = per_ip_.erase(it);
+            else ++it;
+        }
+    }
+
+    uint64_t rejected_ip() const { return rejected_ip_; }
+    uint64_t rejected_global() const { return rejected_global_; }
+    std::size_t tracked_addresses() const { return per_ip_.size(); }
+    std::size_t memory_bytes() const { return memory::hash_map_bytes(per_ip_); }
+
+private:
+    // Fixed-size address key — no string allocation per handshake
+    struct AddrKey {
+        std::array<uint8_t, 16> bytes{};
+        uint8_t len = 0;
+
+        explicit AddrKey(std::string_view raw) {
+            len = static_cast<uint8_t>(std::min<std::size_t>(raw.size(), bytes.size()));
+            std::memcpy(bytes.data(), raw.data(), len);
+        }
+
+        bool operator==(const AddrKey& o) const { return len == o.len && bytes == o.bytes; }
+    };
+
+    struct AddrHash {
+        std::size_t operator()(const AddrKey& k) const {
+            // FNV-1a
+            uint64_t h = 1469598103934665603ull;
+            for (uint8_t i = 0; i < k.len; ++i) {
+                h = (h ^ k.bytes[i]) * 1099511628211ull;
+            }
+            return static_cast<std::size_t>(h);
+        }
+    };
+
+    double per_ip_rate_;
+    double per_ip_burst_;
+    TokenBucket global_;
+    std::unordered_map<AddrKey, TokenBucket, AddrHash> per_ip_;
+
+    uint64_t rejected_ip_ = 0;
+    uint64_t rejected_global_ = 0;
+};
+
+// Value of `key` in a raw (undecoded) query string, without allocating.
+// Empty if absent.
+inline std::string_view find_query_param(std::string_view query, std::string_view key) {
+    while (!query.empty()) {
+        auto amp = query.find('&');
+        auto pair = query.substr(0, amp);
+        auto eq = pair.find('=');
+        if (pair.substr(0, eq) == key) {
+            return eq == std::string_view::npos ? std::string_view{} : pair.substr(eq + 1);
+        }
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    return {};
+}
+
+inline bool has_query_param(std::string_view query, std::string_view key) {
+    while (!query.empty()) {
+        auto amp = query.find('&');
+        auto pair = query.substr(0, amp);
+        if (pair.substr(0, pair.find('=')) == key) return true;
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    return false;
+}
+
+// `query` without any `key` parameter, the other pairs in their order
+inline std::string strip_query_param(std::string_view query, std::string_view key) {
+    std::string out;
+    while (!query.empty()) {
+        auto amp = query.find('&');
+        auto pair = query.substr(0, amp);
+        if (!pair.empty() && pair.substr(0, pair.find('=')) != key) {
+            if (!out.empty()) out += '&';
+            out += pair;
+        }
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    return out;
+}
+
+} // namespace server
@@ -0,0 +1,54 @@
+#include "server/crypto_pool.h"
+#include "utils/trace.h"
+
+namespace server {
+
+CryptoPool::CryptoPool(int threads, std::size_t max_queue) : max_queue_(max_queue) {
+    threads_.reserve(threads);
+    for (int i = 0; i < threads; ++i) {
+        threads_.emplace_back([this] {
+            TRACE_THREAD_NAME("crypto");
+            worker_loop();
+        });
+    }
+}
+
+CryptoPool::~CryptoPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+bool CryptoPool::try_submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jobs_.size() >= max_queue_) return false;
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+std::size_t CryptoPool::queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+void CryptoPool::worker_loop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (stopping_ && jobs_.empty()) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+} // namespace server
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace server {
+
+// Small fixed pool of threads for CPU-heavy handshake work (JWT HMAC +
+// payload parsing), keeping it off the event loop. Jobs must not touch
+// loop-owned state; they hand results back with uWS::Loop::defer().
+class CryptoPool {
+public:
+    CryptoPool(int threads, std::size_t max_queue);
+    ~CryptoPool();
+
+    CryptoPool(const CryptoPool&) = delete;
+    CryptoPool& operator=(const CryptoPool&) = delete;
+
+    // Queue a job. Returns false if the backlog is full (caller should shed).
+    bool try_submit(std::function<void()> job);
+
+    std::size_t queued() const;
+
+private:
+    void worker_loop();
+
+    std::size_t max_queue_;
+    std::vector<std::thread> threads_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    bool stopping_ = false;
+};
+
+} // namespace server
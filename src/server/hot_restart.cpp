@@ -0,0 +1,158 @@
+#include "server/hot_restart.h"
+#include "utils/logger.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace server {
+
+namespace {
+
+constexpr char TAKEOVER_REQUEST[] = "TAKEOVER\n";
+constexpr int HANDOFF_TIMEOUT_SECONDS = 2;
+
+bool make_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+bool write_all(int fd, const void* data, size_t len) {
+    auto* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_all(int fd, void* data, size_t len) {
+    auto* p = static_cast<char*>(data);
+    while (len > 0) {
+        ssize_t n = ::recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void set_timeouts(int fd) {
+    timeval tv{HANDOFF_TIMEOUT_SECONDS, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+} // namespace
+
+HotRestart::HotRestart(std::string socket_path) : path_(std::move(socket_path)) {}
+
+HotRestart::~HotRestart() {
+    if (peer_fd_ >= 0) ::close(peer_fd_);
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+}
+
+std::optional<nlohmann::json> HotRestart::request_takeover() {
+    sockaddr_un addr;
+    if (!make_address(path_, addr)) {
+        logger::error("hot restart: socket path too long: " + path_);
+        return std::nullopt;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return std::nullopt;
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        // Nobody home — first start, or the previous process died
+        ::close(fd);
+        ::unlink(path_.c_str());
+        return std::nullopt;
+    }
+
+    set_timeouts(fd);
+    logger::info("hot restart: predecessor found on " + path_ + ", requesting takeover");
+
+    std::optional<nlohmann::json> state;
+    uint32_t len = 0;
+    if (write_all(fd, TAKEOVER_REQUEST, sizeof(TAKEOVER_REQUEST) - 1) && read_all(fd, &len, sizeof(len))) {
+        std::string payload(len, '\0');
+        if (read_all(fd, payload.data(), len)) {
+            auto parsed = nlohmann::json::parse(payload, nullptr, false);
+            if (!parsed.is_discarded()) state = std::move(parsed);
+        }
+    }
+    ::close(fd);
+
+    if (!state) logger::error("hot restart: handoff from predecessor failed, starting fresh");
+    return state;
+}
+
+bool HotRestart::listen() {
+    sockaddr_un addr;
+    if (!make_address(path_, addr)) return false;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    // Replaces the predecessor's (already handed-off) socket file
+    ::unlink(path_.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 1) != 0) {
+        logger::error("hot restart: cannot listen on " + path_ + ": " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    listen_fd_ = fd;
+    logger::info("hot restart: control socket listening on " + path_);
+    return true;
+}
+
+bool HotRestart::poll_takeover() {
+    if (listen_fd_ < 0 || peer_fd_ >= 0) return peer_fd_ >= 0;
+
+    int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return false;
+
+    // The successor writes its request right after connecting
+    set_timeouts(fd);
+    char buf[sizeof(TAKEOVER_REQUEST) - 1];
+    if (!read_all(fd, buf, sizeof(buf)) || std::memcmp(buf, TAKEOVER_REQUEST, sizeof(buf)) != 0) {
+        logger::warn("hot restart: ignoring malformed control connection");
+        ::close(fd);
+        return false;
+    }
+
+    peer_fd_ = fd;
+    return true;
+}
+
+bool HotRestart::send_state(const nlohmann::json& state) {
+    if (peer_fd_ < 0) return false;
+
+    std::string payload = state.dump();
+    auto len = static_cast<uint32_t>(payload.size());
+    bool ok = write_all(peer_fd_, &len, sizeof(len)) && write_all(peer_fd_, payload.data(), payload.size());
+
+    ::close(peer_fd_);
+    peer_fd_ = -1;
+    // Stop listening; the successor binds a fresh socket at the same path
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+
+    logger::info("hot restart: handed off " + std::to_string(payload.size()) + " bytes of state"
+                 + (ok ? "" : " (FAILED)"));
+    return ok;
+}
+
+} // namespace server
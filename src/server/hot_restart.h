@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <nlohmann/json.hpp>
+
+namespace server {
+
+// Zero-downtime restart over a Unix control socket.
+//
+// A freshly started process binds the game port next to the old one (both
+// with SO_REUSEPORT) and then calls request_takeover(): if an older process
+// is listening on the control socket, it stops accepting, returns its
+// serialized room state and starts draining its clients. The new process
+// restores that state and becomes the control-socket listener itself.
+//
+// Wire format (both directions are one-shot):
+//   successor → predecessor:  "TAKEOVER\n"
+//   predecessor → successor:  uint32 length (host order) + JSON state
+class HotRestart {
+public:
+    explicit HotRestart(std::string socket_path);
+    ~HotRestart();
+
+    HotRestart(const HotRestart&) = delete;
+    HotRestart& operator=(const HotRestart&) = delete;
+
+    // Successor side. Returns the predecessor's state, or nullopt if no
+    // process is running (a stale socket file is removed).
+    std::optional<nlohmann::json> request_takeover();
+
+    // Predecessor side: bind the control socket (non-blocking)
+    bool listen();
+
+    // Non-blocking — true once a successor has connected and asked for a takeover
+    bool poll_takeover();
+
+    // Hand the state to the waiting successor and stop listening
+    bool send_state(const nlohmann::json& state);
+
+    const std::string& socket_path() const { return path_; }
+
+private:
+    std::string path_;
+    int listen_fd_ = -1;
+    int peer_fd_ = -1;
+};
+
+} // namespace server
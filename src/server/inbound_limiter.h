@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+#include "network/messages.h"
+#include "server/admission.h"
+
+namespace server {
+
+using network::msg::MessageClass;
+
+constexpr std::size_t MESSAGE_CLASSES = static_cast<std::size_t>(MessageClass::COUNT);
+
+// Per-connection inbound budgets, shared by every socket on the node
+struct InboundLimits {
+    enum class Action { DROP, THROTTLE, DISCONNECT };
+
+    std::array<double, MESSAGE_CLASSES> rate{};  // messages/s per class; burst is twice that
+    double bytes_per_sec = 32 * 1024;
+    Action action = Action::THROTTLE;
+    int strikes = 20;                            // DISCONNECT: violations within STRIKE_WINDOW
+
+    static constexpr auto STRIKE_WINDOW = std::chrono::seconds(10);
+    static constexpr auto NOTICE_INTERVAL = std::chrono::seconds(1);
+};
+
+// What one connection cost us, for /metrics' heaviest-players list
+struct ConnectionUsage {
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t cpu_ns = 0;      // loop-thread time spent dispatching its messages
+    uint32_t messages = 0;
+    uint32_t limited = 0;     // frames refused by the limiter
+};
+
+// Token buckets for one connection: one per message class plus one for raw
+// bytes. Checked in .message before the frame is parsed, using the class
+// sniffed from its "type", so a client spamming inputs or junk is refused
+// for the price of a byte scan. Loop thread only.
+//
+// Every socket carries one, so it keeps only what differs per connection:
+// the token counts and one refill time. Rates and bursts are read from the
+// shared InboundLimits.
+class InboundLimiter {
+public:
+    using Clock = TokenBucket::Clock;
+
+    enum class Verdict {
+        ACCEPT,
+        DROP,         // refuse silently
+        NOTIFY,       // refuse and tell the client (at most once per NOTICE_INTERVAL)
+        DISCONNECT    // out of strikes
+    };
+
+    InboundLimiter() = default;
+    InboundLimiter(const InboundLimits& limits, Clock::time_point now)
+        : limits_(&limits), last_refill_(now), strike_window_start_(now) {
+        for (std::size_t i = 0; i < MESSAGE_CLASSES; ++i) {
+            tokens_[i] = static_cast<float>(2 * limits.rate[i]);
+        }
+        tokens_[MESSAGE_CLASSES] = static_cast<float>(2 * limits.bytes_per_sec);
+    }
+
+    Verdict check(MessageClass c, std::size_t bytes, Clock::time_point now) {
+        if (!limits_) return Verdict::ACCEPT;
+        refill(now);
+        auto i = static_cast<std::size_t>(c);
+        float& byte_tokens = tokens_[MESSAGE_CLASSES];
+        if (byte_tokens >= static_cast<float>(bytes) && tokens_[i] >= 1.0f) {
+            byte_tokens -= static_cast<float>(bytes);
+            tokens_[i] -= 1.0f;
+            return Verdict::ACCEPT;
+        }
+
+        using Action = InboundLimits::Action;
+        if (limits_->action == Action::DROP) return Verdict::DROP;
+
+        if (limits_->action == Action::DISCONNECT) {
+            if (now - strike_window_start_ > InboundLimits::STRIKE_WINDOW) {
+                strike_window_start_ = now;
+                strikes_ = 0;
+            }
+            if (++strikes_ >= limits_->strikes) return Verdict::DISCONNECT;
+        }
+
+        if (now - last_notice_ < InboundLimits::NOTICE_INTERVAL) return Verdict::DROP;
+        last_notice_ = now;
+        return Verdict::NOTIFY;
+    }
+
+private:
+    void refill(Clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+        if (elapsed <= 0) return;
+        last_refill_ = now;
+        for (std::size_t i = 0; i <= MESSAGE_CLASSES; ++i) {
+            double rate = i < MESSAGE_CLASSES ? limits_->rate[i] : limits_->bytes_per_sec;
+            tokens_[i] = static_cast<float>(std::min(2 * rate, tokens_[i] + elapsed * rate));
+        }
+    }
+
+    const InboundLimits* limits_ = nullptr;   // null = unlimited (not yet opened)
+    std::array<float, MESSAGE_CLASSES + 1> tokens_{};  // per class, then bytes
+    Clock::time_point last_refill_{};
+    Clock::time_point strike_window_start_{};
+    Clock::time_point last_notice_{};
+    int strikes_ = 0;
+};
+
+} // namespace server
@@ -75,20 +75,20 @@ inline std::vector<uint8_t> hmac_sha256(std::string_view key, std::string_view d
 
 // Validate a JWT token against a secret key.
 // Returns the payload if valid, nullopt if invalid/expired.
-inline std::optional<JwtPayload> validate_jwt(const std::string& token,
+inline std::optional<JwtPayload> validate_jwt(std::string_view token,
                                                const std::string& secret) {
     // Split into header.payload.signature
     auto dot1 = token.find('.');
-    if (dot1 == std::string::npos) return std::nullopt;
+    if (dot1 == std::string_view::npos) return std::nullopt;
     auto dot2 = token.find('.', dot1 + 1);
-    if (dot2 == std::string::npos) return std::nullopt;
+    if (dot2 == std::string_view::npos) return std::nullopt;
 
-    std::string_view header_b64 = std::string_view(token).substr(0, dot1);
-    std::string_view payload_b64 = std::string_view(token).substr(dot1 + 1, dot2 - dot1 - 1);
-    std::string_view signature_b64 = std::string_view(token).substr(dot2 + 1);
+    // The header isn't parsed: the signature is always checked as HS256
+    std::string_view payload_b64 = token.substr(dot1 + 1, dot2 - dot1 - 1);
+    std::string_view signature_b64 = token.substr(dot2 + 1);
 
     // Verify signature: HMAC-SHA256(header.payload, secret)
-    std::string_view signed_part = std::string_view(token).substr(0, dot2);
+    std::string_view signed_part = token.substr(0, dot2);
     auto expected_sig = detail::hmac_sha256(secret, signed_part);
     auto actual_sig = detail::base64url_decode(signature_b64);
 
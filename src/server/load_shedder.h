@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "game/room.h"
+#include "utils/logger.h"
+
+namespace server {
+
+// Keeps the game loop inside its tick budget. The loop reports how long each
+// tick took; once the smoothed time runs over budget the shard degrades, in
+// the order the policy allows:
+//   throttle — the most expensive rooms broadcast snapshots every 2nd, 4th…
+//              tick (up to max_stride) until the excess is covered
+//   reject   — new rooms are refused (admit_room() is the creation check)
+// Recovery is gradual: below RECOVER_LOAD one throttled room per adjustment
+// goes back towards full rate. Loop thread only.
+class LoadShedder {
+public:
+    struct Policy {
+        bool throttle_snapshots = true;
+        bool reject_rooms = true;
+        int max_stride = 4;
+    };
+
+    static constexpr double SMOOTHING = 0.2;      // EWMA weight of the newest tick
+    static constexpr double RECOVER_LOAD = 0.7;   // leave overload below this fraction of budget
+
+    LoadShedder(double budget_us, int max_rooms, Policy policy)
+        : budget_us_(budget_us), max_rooms_(max_rooms), policy_(policy) {}
+
+    // Called at the end of every tick with its wall time
+    void record_tick(double tick_us) {
+        tick_us_avg_ += SMOOTHING * (tick_us - tick_us_avg_);
+        window_max_us_ = std::max(window_max_us_, tick_us);
+        if (tick_us > budget_us_) ticks_over_budget_++;
+
+        double l = load();
+        if (!overloaded_ && l > 1.0) {
+            overloaded_ = true;
+            overload_episodes_++;
+            logger::warn("tick over budget (" + std::to_string(static_cast<int>(tick_us_avg_)) + "us avg, budget "
+                         + std::to_string(static_cast<int>(budget_us_)) + "us) — shedding load");
+        } else if (overloaded_ && l < RECOVER_LOAD) {
+            overloaded_ = false;
+            logger::info("tick back within budget — no longer rejecting rooms");
+        }
+    }
+
+    // Re-plan snapshot strides — called about once per second with the
+    // rooms currently playing. Reorders `rooms`.
+    void adjust(std::vector<game::Room*>& rooms) {
+        last_window_max_us_ = window_max_us_;
+        window_max_us_ = 0.0;
+
+        // Most expensive first
+        std::sort(rooms.begin(), rooms.end(), [](const game::Room* a, const game::Room* b) {
+            return a->tick_cost().total_us() > b->tick_cost().total_us();
+        });
+
+        if (overloaded_ && policy_.throttle_snapshots) {
+            // Halve the publish cost of the priciest rooms until the excess is covered
+            double excess = tick_us_avg_ - budget_us_ * RECOVER_LOAD;
+            for (auto* room : rooms) {
+                if (excess <= 0) break;
+                int stride = room->snapshot_stride();
+                if (stride >= policy_.max_stride) continue;
+                room->set_snapshot_stride(std::min(stride * 2, policy_.max_stride));
+                excess -= room->tick_cost().publish_us / 2;
+                throttle_steps_++;
+            }
+        } else if (!overloaded_ && load() < RECOVER_LOAD) {
+            // Cheapest throttled room first — it's the least likely to tip us back over
+            for (auto it = rooms.rbegin(); it != rooms.rend(); ++it) {
+                int stride = (*it)->snapshot_stride();
+                if (stride > 1) {
+                    (*it)->set_snapshot_stride(stride / 2);
+                    break;
+                }
+            }
+        }
+
+        // What /metrics shows
+        top_.clear();
+        for (std::size_t i = 0; i < rooms.size() && i < TOP_ROOMS; ++i) {
+            const auto& c = rooms[i]->tick_cost();
+            top_.push_back({rooms[i]->id(), c.update_us, c.publish_us, rooms[i]->snapshot_stride()});
+        }
+
+        throttled_rooms_ = static_cast<int>(std::count_if(rooms.begin(), rooms.end(),
+            [](const game::Room* r) { return r->snapshot_stride() > 1; }));
+    }
+
+    // Whether a new room may be created on this shard
+    bool admit_room(std::size_t active_rooms) {
+        bool ok = static_cast<int>(active_rooms) < max_rooms_
+                  && !(overloaded_ && policy_.reject_rooms);
+        if (!ok) rooms_rejected_++;
+        return ok;
+    }
+
+    double load() const { return budget_us_ > 0 ? tick_us_avg_ / budget_us_ : 0.0; }
+    bool overloaded() const { return overloaded_; }
+
+    nlohmann::json to_json() const {
+        nlohmann::json top = nlohmann::json::array();
+        for (const auto& r : top_) {
+            top.push_back({{"room_id", r.id}, {"update_us", r.update_us},
+                           {"publish_us", r.publish_us}, {"snapshot_stride", r.stride}});
+        }
+        return {
+            {"budget_ms", budget_us_ / 1000.0},
+            {"tick_ms_avg", tick_us_avg_ / 1000.0},
+            {"tick_ms_max", last_window_max_us_ / 1000.0},
+            {"load", load()},
+            {"overloaded", overloaded_},
+            {"overload_episodes", overload_episodes_},
+            {"ticks_over_budget", ticks_over_budget_},
+            {"throttled_rooms", throttled_rooms_},
+            {"throttle_steps", throttle_steps_},
+            {"rooms_rejected", rooms_rejected_},
+            {"policy", {
+                {"throttle_snapshots", policy_.throttle_snapshots},
+                {"reject_rooms", policy_.reject_rooms},
+                {"max_snapshot_stride", policy_.max_stride}
+            }},
+            {"expensive_rooms", std::move(top)}
+        };
+    }
+
+private:
+    static constexpr std::size_t TOP_ROOMS = 5;
+
+    struct RoomCost {
+        std::string id;
+        float update_us;
+        float publish_us;
+        int stride;
+    };
+
+    double budget_us_;
+    int max_rooms_;
+    Policy policy_;
+
+    double tick_us_avg_ = 0.0;
+    double window_max_us_ = 0.0;       // since the last adjust()
+    double last_window_max_us_ = 0.0;
+    bool overloaded_ = false;
+
+    uint64_t overload_episodes_ = 0;
+    uint64_t ticks_over_budget_ = 0;
+    uint64_t throttle_steps_ = 0;
+    uint64_t rooms_rejected_ = 0;
+    int throttled_rooms_ = 0;
+    std::vector<RoomCost> top_;
+};
+
+} // namespace server
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+#include "game/rollback.h"
+#include "network/messages.h"
+#include "network/rtt.h"
+
+namespace server {
+
+// Shard-wide counters, exposed at /metrics. Loop thread only.
+struct Metrics {
+    // ── Outbound ────────────────────────────────────
+    uint64_t ws_messages_queued = 0;        // messages handed to per-client outboxes
+    uint64_t ws_frames_sent = 0;            // WebSocket frames written (batching merges messages)
+    uint64_t ws_flushes = 0;                // corked outbox flushes ≈ write syscalls
+    uint64_t ws_dropped_backpressure = 0;   // messages dropped on a congested socket
+
+    // ── Inbound ─────────────────────────────────────
+    uint64_t ws_messages_received = 0;
+    uint64_t ws_bytes_received = 0;
+    uint64_t inbound_dispatch_ns = 0;       // loop-thread time in message handlers
+    uint64_t inbound_disconnects = 0;       // sockets closed for exceeding their budget
+    std::array<uint64_t, static_cast<std::size_t>(network::msg::MessageClass::COUNT)> inbound_limited{};
+
+    // ── Spectators ──────────────────────────────────
+    uint64_t spectator_frames = 0;          // frames published (once per room, not per viewer)
+    uint64_t spectator_bytes = 0;
+    uint64_t spectator_deflated_bytes = 0;  // of those, deflated for ?deflate=1 viewers
+
+    // RTT samples from rooms that have since closed (live rooms keep their own)
+    network::RttHistogram rtt_retired;
+    // Likewise for lockstep resyncs and late-input rollback
+    uint64_t lockstep_resyncs_retired = 0;
+    game::RollbackStats rollback_retired;
+
+    // Per connected player per second, over the last sampling window
+    double flushes_per_player_sec = 0.0;
+    double frames_per_player_sec = 0.0;
+
+    // Recompute windowed rates — called about once per second
+    void sample(int players, double elapsed_sec) {
+        if (elapsed_sec > 0 && players > 0) {
+            flushes_per_player_sec = (ws_flushes - last_flushes_) / elapsed_sec / players;
+            frames_per_player_sec = (ws_frames_sent - last_frames_) / elapsed_sec / players;
+        } else {
+            flushes_per_player_sec = 0.0;
+            frames_per_player_sec = 0.0;
+        }
+        last_flushes_ = ws_flushes;
+        last_frames_ = ws_frames_sent;
+    }
+
+    nlohmann::json to_json() const {
+        return {
+            {"outbound", {
+                {"messages_queued", ws_messages_queued},
+                {"frames_sent", ws_frames_sent},
+                {"flushes", ws_flushes},
+                {"dropped_backpressure", ws_dropped_backpressure},
+                {"flushes_per_player_sec", flushes_per_player_sec},
+                {"frames_per_player_sec", frames_per_player_sec}
+            }},
+            {"inbound", inbound_json()},
+            {"spectators", {
+                {"frames_published", spectator_frames},
+                {"bytes_published", spectator_bytes},
+                {"deflated_bytes_published", spectator_deflated_bytes}
+            }}
+        };
+    }
+
+private:
+    nlohmann::json inbound_json() const {
+        nlohmann::json limited = nlohmann::json::object();
+        for (std::size_t i = 0; i < inbound_limited.size(); ++i) {
+            limited[std::string(network::msg::class_name(static_cast<network::msg::MessageClass>(i)))] =
+                inbound_limited[i];
+        }
+        return {
+            {"messages", ws_messages_received},
+            {"bytes", ws_bytes_received},
+            {"dispatch_ms", inbound_dispatch_ns / 1e6},
+            {"limited", std::move(limited)},
+            {"disconnects", inbound_disconnects}
+        };
+    }
+
+    uint64_t last_flushes_ = 0;
+    uint64_t last_frames_ = 0;
+};
+
+} // namespace server
@@ -0,0 +1,202 @@
+#include "server/tls.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <fstream>
+
+#ifndef LIBUS_NO_SSL
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#endif
+
+namespace server {
+
+#ifdef LIBUS_NO_SSL
+
+bool TlsSessions::configure(void* /*ssl_ctx*/, const config::ServerConfig& /*cfg*/) {
+    logger::error("tls: TLS_CERT_FILE is set but this binary was built without ENABLE_TLS");
+    return false;
+}
+
+int TlsSessions::ticket(unsigned char*, unsigned char*, void*, void*, int) { return 0; }
+
+nlohmann::json TlsSessions::to_json() const { return nullptr; }
+
+#else
+
+namespace {
+
+// Where the SSL_CTX keeps its TlsSessions, for the ticket callback
+int ex_index() {
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+int ticket_cb(SSL* ssl, unsigned char key_name[16], unsigned char iv[EVP_MAX_IV_LENGTH],
+              EVP_CIPHER_CTX* cipher_ctx, EVP_MAC_CTX* mac_ctx, int enc) {
+    auto* self = static_cast<TlsSessions*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ex_index()));
+    return self ? self->ticket(key_name, iv, cipher_ctx, mac_ctx, enc) : -1;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+bool TlsSessions::configure(void* ssl_ctx, const config::ServerConfig& cfg) {
+    auto* ctx = static_cast<SSL_CTX*>(ssl_ctx);
+    if (!ctx) {
+        logger::error("tls: no SSL context");
+        return false;
+    }
+    ctx_ = ctx;
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+
+    // Session IDs (TLS 1.2 clients without ticket support)
+    static const unsigned char sid_ctx[] = "wombocombo";
+    SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, cfg.tls_session_cache);
+    SSL_CTX_set_timeout(ctx, cfg.tls_session_lifetime_s);
+
+    // A reconnecting client uses one ticket; OpenSSL's default of two per
+    // handshake doubles the encryption work and the bytes
+    SSL_CTX_set_num_tickets(ctx, 1);
+
+    if (!cfg.tls_ticket_key_file.empty()) {
+        if (!load_keys(cfg.tls_ticket_key_file)) return false;
+        SSL_CTX_set_ex_data(ctx, ex_index(), this);
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticket_cb);
+    }
+
+    logger::info("tls: session cache " + std::to_string(cfg.tls_session_cache) + " entries, lifetime "
+                 + std::to_string(cfg.tls_session_lifetime_s) + "s, ticket keys "
+                 + (keys_.empty() ? "per process" : std::to_string(keys_.size()) + " from "
+                                                    + cfg.tls_ticket_key_file));
+    return true;
+}
+
+bool TlsSessions::load_keys(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        logger::error("tls: cannot read ticket key file " + path);
+        return false;
+    }
+    std::string line;
+    for (int n = 1; std::getline(in, line); ++n) {
+        line.erase(std::remove_if(line.begin(), line.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)); }),
+                   line.end());
+        if (line.empty() || line[0] == '#') continue;
+
+        uint8_t raw[80];
+        bool ok = line.size() == 2 * sizeof(raw);
+        for (std::size_t i = 0; ok && i < sizeof(raw); ++i) {
+            int hi = hex_value(line[2 * i]), lo = hex_value(line[2 * i + 1]);
+            ok = hi >= 0 && lo >= 0;
+            raw[i] = static_cast<uint8_t>(hi << 4 | lo);
+        }
+        if (!ok) {
+            logger::error("tls: " + path + ":" + std::to_string(n) + " is not a 160-character hex key");
+            return false;
+        }
+        Key key;
+        std::memcpy(key.name.data(), raw, 16);
+        std::memcpy(key.hmac.data(), raw + 16, 32);
+        std::memcpy(key.aes.data(), raw + 48, 32);
+        keys_.push_back(key);
+    }
+    if (keys_.empty()) {
+        logger::error("tls: no keys in " + path);
+        return false;
+    }
+    return true;
+}
+
+// OpenSSL's contract: when encrypting, fill key_name and iv and set up both
+// contexts (1 = ok). When decrypting, 0 = unknown key (full handshake),
+// 1 = ok, 2 = ok and issue a new ticket. -1 aborts the handshake.
+//
+// Always 2 when decrypting: TLS 1.3 clients don't offer a ticket twice, so
+// one resumed without a new ticket can't resume again, and TLS 1.2 ones
+// move to the current key.
+int TlsSessions::ticket(unsigned char* key_name, unsigned char* iv, void* cipher_ctx, void* mac_ctx, int enc) {
+    auto* cctx = static_cast<EVP_CIPHER_CTX*>(cipher_ctx);
+    auto* hctx = static_cast<EVP_MAC_CTX*>(mac_ctx);
+
+    const Key* key = nullptr;
+    if (enc) {
+        key = &keys_.front();
+        std::memcpy(key_name, key->name.data(), key->name.size());
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1) return -1;
+    } else {
+        auto it = std::find_if(keys_.begin(), keys_.end(), [&](const Key& k) {
+            return std::memcmp(k.name.data(), key_name, k.name.size()) == 0;
+        });
+        if (it == keys_.end()) {
+            tickets_.unknown_key++;
+            return 0;
+        }
+        key = &*it;
+    }
+
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, const_cast<uint8_t*>(key->hmac.data()),
+                                          key->hmac.size()),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+    if (!EVP_MAC_CTX_set_params(hctx, params)) return -1;
+
+    if (enc) {
+        if (!EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, key->aes.data(), iv)) return -1;
+        tickets_.issued++;
+        return 1;
+    }
+    if (!EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, key->aes.data(), iv)) return -1;
+    tickets_.decrypted++;
+    if (key != &keys_.front()) tickets_.rotated++;
+    return 2;
+}
+
+nlohmann::json TlsSessions::to_json() const {
+    auto* ctx = static_cast<SSL_CTX*>(ctx_);
+    if (!ctx) return nullptr;
+    long accepted = SSL_CTX_sess_accept_good(ctx);
+    long resumed = SSL_CTX_sess_hits(ctx);
+    nlohmann::json out = {
+        {"handshakes", accepted},
+        {"handshakes_started", SSL_CTX_sess_accept(ctx)},
+        {"resumed", resumed},
+        {"resumed_pct", accepted > 0 ? 100.0 * static_cast<double>(resumed) / static_cast<double>(accepted) : 0.0},
+        {"session_cache", {
+            {"entries", SSL_CTX_sess_number(ctx)},
+            {"misses", SSL_CTX_sess_misses(ctx)},
+            {"timeouts", SSL_CTX_sess_timeouts(ctx)},
+            {"full", SSL_CTX_sess_cache_full(ctx)}
+        }}
+    };
+    if (!keys_.empty()) {
+        out["tickets"] = {
+            {"keys", keys_.size()},
+            {"issued", tickets_.issued},
+            {"decrypted", tickets_.decrypted},
+            {"old_key", tickets_.rotated},
+            {"unknown_key", tickets_.unknown_key}
+        };
+    }
+    return out;
+}
+
+#endif
+
+} // namespace server
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "utils/config.h"
+
+namespace server {
+
+// Session resumption for in-process TLS (TLS_CERT_FILE, ENABLE_TLS builds).
+// uWS::SSLApp loads the certificate; this tunes the SSL_CTX it built so a
+// reconnecting client skips the full handshake: a server-side session cache
+// for clients resuming by session ID, and session tickets for the rest
+// (every TLS 1.3 client).
+//
+// Ticket keys come from TLS_TICKET_KEY_FILE when set, so a ticket issued
+// before a hot restart or by another node still resumes. One key per line,
+// 160 hex characters (name 16 | HMAC 32 | AES 32 bytes, e.g.
+// `openssl rand -hex 80`). The first line encrypts new tickets; the rest
+// only decrypt. To rotate, prepend a key and hot restart. Without the file
+// OpenSSL uses random keys that die with the process.
+//
+// Loop thread only: OpenSSL calls back from the handshake.
+class TlsSessions {
+public:
+    // Applies the settings to an SSL_CTX*; false (logged) when the ticket
+    // key file is unusable or the build has no TLS
+    bool configure(void* ssl_ctx, const config::ServerConfig& cfg);
+
+    std::size_t ticket_keys() const { return keys_.size(); }
+
+    nlohmann::json to_json() const;
+
+    // One ticket key, as laid out in the key file
+    struct Key {
+        std::array<uint8_t, 16> name{};
+        std::array<uint8_t, 32> hmac{};
+        std::array<uint8_t, 32> aes{};
+    };
+
+    // The ticket callback's work; public for the C trampoline in tls.cpp
+    int ticket(unsigned char* key_name, unsigned char* iv, void* cipher_ctx, void* mac_ctx, int enc);
+
+private:
+    bool load_keys(const std::string& path);
+
+    void* ctx_ = nullptr;  // SSL_CTX*
+    std::vector<Key> keys_;
+
+    struct Stats {
+        uint64_t issued = 0;       // tickets encrypted
+        uint64_t decrypted = 0;    // presented with a known key
+        uint64_t rotated = 0;      // ... an older one than the current
+        uint64_t unknown_key = 0;  // full handshake: rotated out or another cluster's key
+    } tickets_;
+};
+
+} // namespace server
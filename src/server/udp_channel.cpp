@@ -0,0 +1,308 @@
+#include "server/udp_channel.h"
+#include "utils/logger.h"
+#include "utils/memory_stats.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <openssl/rand.h>
+#include <random>
+#include <unistd.h>
+
+namespace server {
+
+namespace {
+
+namespace dg = network::datagrams;
+
+constexpr int SOCKET_BUFFER_BYTES = 4 * 1024 * 1024;
+constexpr unsigned int BATCH = 64;                 // datagrams per recvmmsg/sendmmsg
+constexpr int MAX_DATAGRAMS_PER_POLL = 8192;       // bounds the loop time one poll can take
+constexpr auto EXPIRY_INTERVAL = std::chrono::milliseconds(250);
+
+// Address bytes and port, as a map key
+std::string addr_key(const sockaddr_storage& a) {
+    std::string key;
+    if (a.ss_family == AF_INET6) {
+        const auto& in6 = reinterpret_cast<const sockaddr_in6&>(a);
+        key.assign(reinterpret_cast<const char*>(&in6.sin6_addr), sizeof(in6.sin6_addr));
+        key.append(reinterpret_cast<const char*>(&in6.sin6_port), sizeof(in6.sin6_port));
+    } else {
+        const auto& in4 = reinterpret_cast<const sockaddr_in&>(a);
+        key.assign(reinterpret_cast<const char*>(&in4.sin_addr), sizeof(in4.sin_addr));
+        key.append(reinterpret_cast<const char*>(&in4.sin_port), sizeof(in4.sin_port));
+    }
+    return key;
+}
+
+std::string token_key(const dg::Token& t) {
+    return std::string(reinterpret_cast<const char*>(t.data()), t.size());
+}
+
+// Dual-stack where IPv6 is available, IPv4 otherwise
+int open_socket(int port) {
+    int fd = ::socket(AF_INET6, SOCK_DGRAM, 0);
+    if (fd >= 0) {
+        int off = 0;
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+        sockaddr_in6 addr{};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_any;
+        addr.sin6_port = htons(static_cast<uint16_t>(port));
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+    } else {
+        fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) return -1;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+    }
+    int buf = SOCKET_BUFFER_BYTES;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+} // namespace
+
+UdpChannel::UdpChannel(int port, std::chrono::milliseconds timeout, Handlers handlers)
+    : port_(port), timeout_(timeout), handlers_(std::move(handlers)) {
+    fd_ = open_socket(port);
+    if (fd_ < 0) {
+        logger::error("udp: cannot bind port " + std::to_string(port) + ": " + std::strerror(errno)
+                      + " — WebSocket only");
+        return;
+    }
+    logger::info("udp: snapshot channel on port " + std::to_string(port));
+}
+
+UdpChannel::~UdpChannel() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+// ── Sessions ────────────────────────────────────────
+
+dg::Token UdpChannel::offer(const std::string& player_id) {
+    remove(player_id);
+
+    dg::Token token;
+    if (RAND_bytes(token.data(), static_cast<int>(token.size())) != 1) {
+        static thread_local std::mt19937_64 rng{std::random_device{}()};
+        for (auto& b : token) b = static_cast<uint8_t>(rng());
+    }
+    Session& s = sessions_[player_id];
+    s.token = token;
+    by_token_[token_key(token)] = player_id;
+    return token;
+}
+
+void UdpChannel::remove(const std::string& player_id) {
+    auto it = sessions_.find(player_id);
+    if (it == sessions_.end()) return;
+    if (it->second.bound) by_addr_.erase(addr_key(it->second.addr));
+    by_token_.erase(token_key(it->second.token));
+    sessions_.erase(it);
+}
+
+bool UdpChannel::bound(const std::string& player_id) const {
+    auto it = sessions_.find(player_id);
+    return it != sessions_.end() && it->second.bound;
+}
+
+void UdpChannel::unbind(Session& s) {
+    if (!s.bound) return;
+    by_addr_.erase(addr_key(s.addr));
+    s.bound = false;
+}
+
+// ── Receive ─────────────────────────────────────────
+
+void UdpChannel::poll(Clock::time_point now) {
+    if (fd_ < 0) return;
+
+    static thread_local std::vector<char> buffers(BATCH * dg::MAX_DATAGRAM);
+    std::array<mmsghdr, BATCH> msgs{};
+    std::array<iovec, BATCH> iov{};
+    std::array<sockaddr_storage, BATCH> from{};
+
+    for (int handled = 0; handled < MAX_DATAGRAMS_PER_POLL;) {
+        for (unsigned int i = 0; i < BATCH; ++i) {
+            iov[i] = {buffers.data() + i * dg::MAX_DATAGRAM, dg::MAX_DATAGRAM};
+            msgs[i].msg_hdr = {};
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &from[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+        }
+        int n = ::recvmmsg(fd_, msgs.data(), BATCH, MSG_DONTWAIT, nullptr);
+        if (n <= 0) break;
+        for (int i = 0; i < n; ++i) {
+            std::string_view d(static_cast<const char*>(iov[i].iov_base), msgs[i].msg_len);
+            stats_.datagrams_in++;
+            stats_.bytes_in += d.size();
+            handle(d, from[i], msgs[i].msg_hdr.msg_namelen, now);
+        }
+        handled += n;
+        if (static_cast<unsigned int>(n) < BATCH) break;
+    }
+
+    // Quiet clients fall back to the WebSocket
+    if (now < next_expiry_) return;
+    next_expiry_ = now + EXPIRY_INTERVAL;
+    for (auto& [pid, s] : sessions_) {
+        if (s.bound && now - s.last_seen > timeout_) {
+            unbind(s);
+            stats_.expired++;
+            if (handlers_.expired) handlers_.expired(pid);
+        }
+    }
+}
+
+void UdpChannel::handle(std::string_view d, const sockaddr_storage& from, socklen_t from_len,
+                        Clock::time_point now) {
+    if (d.empty()) {
+        stats_.rejected++;
+        return;
+    }
+
+    if (static_cast<uint8_t>(d[0]) == dg::HELLO) {
+        auto token = dg::read_hello(d);
+        auto pid = token ? by_token_.find(token_key(*token)) : by_token_.end();
+        if (pid == by_token_.end()) {
+            stats_.rejected++;
+            return;
+        }
+        Session& s = sessions_[pid->second];
+        auto key = addr_key(from);
+        bool moved = !s.bound || addr_key(s.addr) != key;
+        if (moved) {
+            // First bind, or the client's address changed (NAT rebinding)
+            unbind(s);
+            if (auto other = by_addr_.find(key); other != by_addr_.end()) {
+                unbind(sessions_[other->second]);  // a previous session from the same address
+            }
+            s.addr = from;
+            s.addr_len = from_len;
+            s.bound = true;
+            by_addr_[key] = pid->second;
+        }
+        s.last_seen = now;
+        static const char ack = static_cast<char>(dg::HELLO_ACK);
+        queue(s, std::string_view(&ack, 1));
+        if (moved && handlers_.bound) handlers_.bound(pid->second);
+        return;
+    }
+
+    auto pid = by_addr_.find(addr_key(from));
+    auto in = dg::read_input(d);
+    if (pid == by_addr_.end() || !in) {
+        stats_.rejected++;
+        return;
+    }
+    Session& s = sessions_[pid->second];
+    s.last_seen = now;
+    if (s.any_input && !dg::seq_newer(in->seq, s.last_input_seq)) {
+        stats_.stale_inputs++;
+        return;
+    }
+    s.any_input = true;
+    s.last_input_seq = in->seq;
+    if (handlers_.input) handlers_.input(pid->second, *in);
+}
+
+// ── Send ────────────────────────────────────────────
+
+bool UdpChannel::send_snapshot(const std::string& player_id, std::string_view json) {
+    auto it = sessions_.find(player_id);
+    if (it == sessions_.end() || !it->second.bound) return false;
+    if (dg::SNAPSHOT_HEADER + json.size() > dg::MAX_DATAGRAM) {
+        stats_.oversize++;
+        return false;
+    }
+    Session& s = it->second;
+    dg::write_snapshot_header(out_bytes_, ++s.seq_out);
+    out_bytes_.append(json);
+    out_.push_back({static_cast<uint32_t>(out_bytes_.size()), s.addr_len, s.addr});
+    return true;
+}
+
+void UdpChannel::queue(const Session& s, std::string_view bytes) {
+    out_bytes_.append(bytes);
+    out_.push_back({static_cast<uint32_t>(out_bytes_.size()), s.addr_len, s.addr});
+}
+
+void UdpChannel::flush() {
+    if (out_.empty()) return;
+    std::array<mmsghdr, BATCH> msgs{};
+    std::array<iovec, BATCH> iov{};
+
+    std::size_t next = 0;
+    while (next < out_.size()) {
+        uint32_t start = next == 0 ? 0 : out_[next - 1].end;
+        unsigned int n = 0;
+        for (; n < BATCH && next + n < out_.size(); ++n) {
+            auto& o = out_[next + n];
+            iov[n] = {out_bytes_.data() + start, o.end - start};
+            msgs[n].msg_hdr = {};
+            msgs[n].msg_hdr.msg_iov = &iov[n];
+            msgs[n].msg_hdr.msg_iovlen = 1;
+            msgs[n].msg_hdr.msg_name = &o.addr;
+            msgs[n].msg_hdr.msg_namelen = o.addr_len;
+            start = o.end;
+        }
+        int sent = ::sendmmsg(fd_, msgs.data(), n, MSG_DONTWAIT);
+        if (sent <= 0) {
+            // Socket buffer full: unreliable by design, the next snapshot replaces these
+            stats_.send_dropped += out_.size() - next;
+            break;
+        }
+        for (int i = 0; i < sent; ++i) stats_.bytes_out += msgs[i].msg_len;
+        stats_.datagrams_out += static_cast<uint64_t>(sent);
+        next += static_cast<std::size_t>(sent);
+    }
+    out_.clear();
+    out_bytes_.clear();
+}
+
+// ── Metrics ─────────────────────────────────────────
+
+nlohmann::json UdpChannel::to_json() const {
+    return {
+        {"port", port_},
+        {"sessions", sessions_.size()},
+        {"bound", by_addr_.size()},
+        {"datagrams_in", stats_.datagrams_in},
+        {"datagrams_out", stats_.datagrams_out},
+        {"bytes_in", stats_.bytes_in},
+        {"bytes_out", stats_.bytes_out},
+        {"rejected", stats_.rejected},
+        {"stale_inputs", stats_.stale_inputs},
+        {"oversize_snapshots", stats_.oversize},
+        {"send_dropped", stats_.send_dropped},
+        {"expired", stats_.expired}
+    };
+}
+
+std::size_t UdpChannel::memory_bytes() const {
+    std::size_t bytes = memory::hash_map_bytes(sessions_) + memory::hash_map_bytes(by_token_)
+                      + memory::hash_map_bytes(by_addr_) + memory::heap_bytes(out_bytes_)
+                      + memory::heap_bytes(out_);
+    for (const auto& [pid, _] : sessions_) bytes += memory::heap_bytes(pid);
+    for (const auto& [key, pid] : by_token_) bytes += memory::heap_bytes(key) + memory::heap_bytes(pid);
+    for (const auto& [key, pid] : by_addr_) bytes += memory::heap_bytes(key) + memory::heap_bytes(pid);
+    return bytes;
+}
+
+} // namespace server
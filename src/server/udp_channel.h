@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <nlohmann/json.hpp>
+
+#include "network/datagrams.h"
+
+namespace server {
+
+// Optional UDP path next to players' WebSockets (UDP_PORT), for traffic
+// where the newest message supersedes the rest: game_state out, player
+// input in. Over TCP one lost segment stalls every snapshot queued behind
+// it; here the client just takes the next one.
+//
+// A player that connects with ?udp=1 is sent a token (udp_offer) over its
+// WebSocket and sends it back in a HELLO datagram, which binds the sender's
+// address to that session. Until then, and whenever the client goes quiet
+// for the timeout, its snapshots and inputs use the WebSocket as before.
+//
+// Polled from the game loop (no uSockets integration needed): inputs are
+// only read once per tick anyway. Loop thread only.
+class UdpChannel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Handlers {
+        std::function<void(const std::string& player_id)> bound;    // HELLO from a new address
+        std::function<void(const std::string& player_id, const network::datagrams::Input&)> input;
+        std::function<void(const std::string& player_id)> expired;  // silent for the timeout
+    };
+
+    UdpChannel(int port, std::chrono::milliseconds timeout, Handlers handlers);
+    ~UdpChannel();
+
+    UdpChannel(const UdpChannel&) = delete;
+    UdpChannel& operator=(const UdpChannel&) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+    int port() const { return port_; }
+
+    // A session for a WebSocket player, replacing any earlier one; the
+    // token goes to the client in udp_offer
+    network::datagrams::Token offer(const std::string& player_id);
+    void remove(const std::string& player_id);
+    bool bound(const std::string& player_id) const;
+
+    // Queues a SNAPSHOT for the next flush(). False when the player has no
+    // bound address or the snapshot doesn't fit a datagram: send it on the
+    // WebSocket instead.
+    bool send_snapshot(const std::string& player_id, std::string_view json);
+
+    // Handles everything received since the last call, then expires
+    // sessions that have gone quiet
+    void poll(Clock::time_point now);
+
+    // Sends what was queued this iteration, batched with sendmmsg
+    void flush();
+
+    nlohmann::json to_json() const;
+    std::size_t memory_bytes() const;
+
+private:
+    struct Session {
+        network::datagrams::Token token{};
+        sockaddr_storage addr{};
+        socklen_t addr_len = 0;
+        bool bound = false;
+        bool any_input = false;
+        uint32_t seq_out = 0;
+        uint32_t last_input_seq = 0;
+        Clock::time_point last_seen{};
+    };
+
+    struct Stats {
+        uint64_t datagrams_in = 0;
+        uint64_t datagrams_out = 0;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t rejected = 0;       // malformed, unknown token or unbound address
+        uint64_t stale_inputs = 0;   // arrived after a newer one
+        uint64_t oversize = 0;       // snapshots too big for a datagram, sent on the WebSocket
+        uint64_t send_dropped = 0;   // socket buffer full
+        uint64_t expired = 0;        // sessions fallen back to the WebSocket
+    };
+
+    // A queued datagram: bytes up to `end` in out_bytes_
+    struct Outgoing {
+        uint32_t end;
+        socklen_t addr_len;
+        sockaddr_storage addr;
+    };
+
+    void handle(std::string_view d, const sockaddr_storage& from, socklen_t from_len, Clock::time_point now);
+    void unbind(Session& s);
+    void queue(const Session& s, std::string_view bytes);
+
+    int fd_ = -1;
+    int port_;
+    std::chrono::milliseconds timeout_;
+    Handlers handlers_;
+    Clock::time_point next_expiry_{};
+
+    std::unordered_map<std::string, Session> sessions_;      // by player id
+    std::unordered_map<std::string, std::string> by_token_;  // token bytes → player id
+    std::unordered_map<std::string, std::string> by_addr_;   // bound address → player id
+
+    std::string out_bytes_;
+    std::vector<Outgoing> out_;
+    Stats stats_;
+};
+
+} // namespace server
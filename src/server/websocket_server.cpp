@@ -3,6 +3,10 @@
 #include "network/protocol.h"
 #include "network/message_handler.h"
 #include "utils/logger.h"
+#include "utils/alloc_stats.h"
+#include "utils/json_writer.h"
+#include "utils/memory_stats.h"
+#include "utils/trace.h"
 
 #include <App.h>  // uWebSockets main header
 
@@ -14,13 +18,17 @@ extern "C" {
     void us_timer_set(struct us_timer_t *timer, void (*cb)(struct us_timer_t *), int ms, int repeat_ms);
     void us_timer_close(struct us_timer_t *timer);
     void *us_timer_ext(struct us_timer_t *timer);
+    struct us_listen_socket_t;
+    void us_listen_socket_close(int ssl, struct us_listen_socket_t *ls);
 }
 
 #include <string>
 #include <sstream>
 #include <random>
 #include <algorithm>
+#include <charconv>
 #include <cstring>
+#include <unistd.h>
 
 namespace server {
 
@@ -38,19 +46,92 @@ static std::string generate_id(int len = 8) {
     return id;
 }
 
+// Pending JWT verifications beyond this are shed with 503
+static constexpr std::size_t CRYPTO_MAX_QUEUE = 4096;
+
+// uSockets' event loop backend, fixed at build time (ENABLE_IO_URING)
+#ifdef LIBUS_USE_IO_URING
+static constexpr const char* EVENT_LOOP = "io_uring";
+#else
+static constexpr const char* EVENT_LOOP = "epoll";
+#endif
+
+// ── Socket types ────────────────────────────────────
+// Player sockets and the app are stored untyped; their uWS types differ
+// only in the SSL flag, which is the same for everything on a node
+
+template <bool SSL>
+using PlayerSocket = uWS::WebSocket<SSL, true, PerSocketData>;
+
+template <bool SSL>
+using SpectatorSocket = uWS::WebSocket<SSL, true, SpectatorData>;
+
+template <typename F>
+decltype(auto) WebSocketServer::with_socket(void* raw, F&& f) const {
+    if (tls_) return f(static_cast<PlayerSocket<true>*>(raw));
+    return f(static_cast<PlayerSocket<false>*>(raw));
+}
+
+template <typename F>
+void WebSocketServer::with_app(F&& f) const {
+    if (!app_) return;
+    if (tls_) f(static_cast<uWS::SSLApp*>(app_));
+    else f(static_cast<uWS::App*>(app_));
+}
+
+PerSocketData* WebSocketServer::socket_data(void* raw) const {
+    return with_socket(raw, [](auto* ws) { return ws->getUserData(); });
+}
+
+template <typename F>
+void WebSocketServer::with_spectator(void* raw, F&& f) const {
+    if (tls_) f(static_cast<SpectatorSocket<true>*>(raw));
+    else f(static_cast<SpectatorSocket<false>*>(raw));
+}
+
 WebSocketServer::WebSocketServer(const config::ServerConfig& cfg)
-    : cfg_(cfg) {
+    : cfg_(cfg),
+      maps_(cfg.maps_dir),
+      load_shedder_(1e6 / cfg.tick_rate * cfg.tick_budget_pct / 100.0, cfg.max_rooms,
+                    {cfg.overload_throttle_snapshots, cfg.overload_reject_rooms, cfg.max_snapshot_stride}),
+      admission_(cfg.admit_per_ip_rate, cfg.admit_per_ip_burst,
+                 cfg.admit_global_rate, cfg.admit_global_burst),
+      crypto_pool_(cfg.crypto_threads, CRYPTO_MAX_QUEUE),
+      sim_pool_(cfg.sim_threads),
+      tls_(!cfg.tls_cert_file.empty()) {
     tick_dt_ = 1.0f / static_cast<float>(cfg.tick_rate);
 
+    auto rate = [&](MessageClass c) -> double& { return inbound_limits_.rate[static_cast<std::size_t>(c)]; };
+    rate(MessageClass::INPUT) = cfg.inbound_rate_input;
+    rate(MessageClass::CHAT) = cfg.inbound_rate_chat;
+    rate(MessageClass::CONTROL) = cfg.inbound_rate_control;
+    rate(MessageClass::ACTION) = cfg.inbound_rate_action;
+    rate(MessageClass::OTHER) = cfg.inbound_rate_other;
+    inbound_limits_.bytes_per_sec = cfg.inbound_bytes_per_sec;
+    inbound_limits_.strikes = cfg.inbound_strikes;
+    if (cfg.inbound_policy == "drop") inbound_limits_.action = InboundLimits::Action::DROP;
+    else if (cfg.inbound_policy == "disconnect") inbound_limits_.action = InboundLimits::Action::DISCONNECT;
+    else inbound_limits_.action = InboundLimits::Action::THROTTLE;
+
+    rooms_.reserve(cfg.max_rooms);
+    playing_rooms_.reserve(cfg.max_rooms);
+    utils::JsonWriter::warm_up();
+    network::server_time_us();  // starts the probe / time-sync clock
+
+    // Load (mmap) the map up front rather than on the first room
+    logger::info("map: " + maps_.get(cfg.map_name)->name());
+
     // Connect to Redis and fetch JWT secret
     bool redis_connected = false;
 
     // First try with password if provided
+    std::string redis_password = cfg.redis_password;
     if (!cfg.redis_password.empty()) {
         redis_connected = redis_.connect(cfg.redis_addr, cfg.redis_port, cfg.redis_password);
         if (!redis_connected) {
             logger::warn("Redis auth failed, retrying without password...");
             redis_connected = redis_.connect(cfg.redis_addr, cfg.redis_port, "");
+            if (redis_connected) redis_password.clear();
         }
     } else {
         redis_connected = redis_.connect(cfg.redis_addr, cfg.redis_port, "");
@@ -67,64 +148,155 @@ WebSocketServer::WebSocketServer(const config::ServerConfig& cfg)
     } else {
         logger::warn("Redis not available — JWT validation disabled, running in dev mode");
     }
-}
 
-std::unordered_map<std::string, std::string> WebSocketServer::parse_query(std::string_view url) {
-    std::unordered_map<std::string, std::string> params;
-
-    auto qpos = url.find('?');
-    if (qpos == std::string_view::npos) return params;
-
-    auto query = url.substr(qpos + 1);
-    std::string key, value;
-    bool in_key = true;
+    if (cfg.stats_enabled) {
+        // Starts even if Redis is down now; the writer buffers and retries
+        stats_ = std::make_unique<storage::StatsWriter>(storage::StatsConfig{
+            cfg.redis_addr, cfg.redis_port, redis_password, cfg.stats_flush_ms,
+            static_cast<std::size_t>(cfg.stats_queue_size), static_cast<std::size_t>(cfg.stats_max_pending)});
+    }
 
-    for (char c : query) {
-        if (c == '=') {
-            in_key = false;
-        } else if (c == '&') {
-            if (!key.empty()) params[key] = value;
-            key.clear();
-            value.clear();
-            in_key = true;
+    if (cfg.cluster_enabled) {
+        if (redis_connected) {
+            std::string node_id = cfg.node_id;
+            if (node_id.empty()) {
+                char host[64] = {};
+                gethostname(host, sizeof(host) - 1);
+                node_id = std::string(host) + "-" + std::to_string(getpid());
+            }
+            // Its own connection and thread: the loop never waits on the registry
+            registry_ = std::make_unique<storage::RoomRegistry>(storage::RegistryConfig{
+                cfg.redis_addr, cfg.redis_port, redis_password, node_id, cfg.public_url, cfg.node_ttl});
+            logger::info("cluster: node " + node_id + " at " + cfg.public_url);
         } else {
-            if (in_key) key += c;
-            else value += c;
+            logger::warn("cluster: Redis not available — running single-node");
         }
     }
-    if (!key.empty()) params[key] = value;
 
-    return params;
+    if (!cfg.hot_restart_socket.empty()) {
+        hot_restart_ = std::make_unique<HotRestart>(cfg.hot_restart_socket);
+    }
+
+    if (cfg.udp_port > 0) {
+        UdpChannel::Handlers handlers;
+        handlers.bound = [this](const std::string& pid) {
+            deliver(pid, network::make_udp_state(true), game::Room::Payload::TEXT);
+        };
+        handlers.input = [this](const std::string& pid, const network::datagrams::Input& in) {
+            handle_udp_input(pid, in);
+        };
+        handlers.expired = [this](const std::string& pid) {
+            logger::debug("udp: player " + pid + " went quiet, back to WebSocket only");
+            deliver(pid, network::make_udp_state(false), game::Room::Payload::TEXT);
+        };
+        udp_ = std::make_unique<UdpChannel>(cfg.udp_port, std::chrono::milliseconds(cfg.udp_timeout_ms),
+                                            std::move(handlers));
+        if (!udp_->ok()) udp_.reset();
+    }
 }
 
-game::Room* WebSocketServer::get_or_create_room(const std::string& room_id) {
+game::Room* WebSocketServer::get_or_create_room(const std::string& room_id, game::RoomMode mode) {
     auto it = rooms_.find(room_id);
     if (it != rooms_.end()) {
         return it->second.get();
     }
 
-    if (static_cast<int>(rooms_.size()) >= cfg_.max_rooms) {
-        logger::warn("max rooms reached (" + std::to_string(cfg_.max_rooms) + "), rejecting");
+    if (!load_shedder_.admit_room(rooms_.size())) {
+        logger::warn("not admitting room " + room_id + " (" + std::to_string(rooms_.size()) + " rooms, load "
+                     + std::to_string(static_cast<int>(load_shedder_.load() * 100)) + "% of tick budget)");
         return nullptr;
     }
 
-    auto room = std::make_unique<game::Room>(room_id, cfg_.max_players_per_room);
+    utils::PooledPtr<game::Room> room(
+        room_pool_.acquire(room_id, cfg_.max_players_per_room, maps_.get(cfg_.map_name)),
+        utils::PoolDeleter<game::Room>{&room_pool_});
     auto* ptr = room.get();
     rooms_.emplace(room_id, std::move(room));
-    logger::info("created room " + room_id);
+    setup_room_broadcast(ptr);
+    ptr->set_change_fn([this](const game::Room& r) { directory_.upsert(r); });
+    ptr->configure_spectators(cfg_.tick_rate / cfg_.spectator_rate,
+                              cfg_.spectator_delay_ms * cfg_.tick_rate / 1000);
+    ptr->set_stats(stats_.get());
+    ptr->set_rollback_window(cfg_.rollback_ticks);
+    ptr->set_spectator_fn([this](const game::Room& r, std::string_view frame) {
+        publish_spectator_frame(r, frame);
+    });
+    if (mode == game::RoomMode::LOCKSTEP
+        && !ptr->enable_lockstep(tick_dt_, cfg_.lockstep_checksum_ticks)) {
+        logger::warn("room " + room_id + " can't run lockstep with "
+                     + std::to_string(cfg_.max_players_per_room) + " players, using snapshots");
+    }
+    directory_.upsert(*ptr);
+    logger::info("created room " + room_id + " (" + game::room_mode_str(ptr->mode()) + ")");
     return ptr;
 }
 
+double WebSocketServer::local_load() const {
+    return static_cast<double>(rooms_.size()) / std::max(1, cfg_.max_rooms);
+}
+
+void WebSocketServer::cluster_heartbeat() {
+    std::vector<std::string> local_rooms;
+    local_rooms.reserve(rooms_.size());
+    int players = 0;
+    for (const auto& [id, room] : rooms_) {
+        local_rooms.push_back(id);
+        players += room->player_count();
+    }
+    registry_->heartbeat(std::move(local_rooms), players, local_load());
+}
+
 game::Room* WebSocketServer::get_room(const std::string& room_id) {
     auto it = rooms_.find(room_id);
     if (it == rooms_.end()) return nullptr;
     return it->second.get();
 }
 
+// pub/sub topic of a room's spectator stream
+static std::string spectator_topic(std::string_view room_id, bool deflate) {
+    std::string topic = "spectate/";
+    topic += room_id;
+    if (deflate) topic += "/deflate";
+    return topic;
+}
+
+template <typename F>
+void WebSocketServer::detach_spectators(const game::Room* room, F&& f) {
+    // Collected first: f closes sockets, and a close edits the set
+    std::vector<void*> detached;
+    for (auto* raw : spectator_sockets_) {
+        with_spectator(raw, [&](auto* ws) {
+            auto* data = ws->getUserData();
+            if (room && data->room != room) return;
+            data->room->remove_spectator();
+            data->room = nullptr;
+            detached.push_back(raw);
+        });
+    }
+    for (auto* raw : detached) {
+        spectator_sockets_.erase(raw);
+        with_spectator(raw, f);
+    }
+}
+
 void WebSocketServer::cleanup_empty_rooms() {
     for (auto it = rooms_.begin(); it != rooms_.end();) {
         if (it->second->should_cleanup()) {
             logger::info("cleaning up room " + it->first);
+            // Close the room's viewers with it: a room created later under the
+            // same code must not stream to them
+            if (it->second->spectator_count() > 0) {
+                auto closed = network::make_error(410, "Room closed");
+                detach_spectators(it->second.get(), [&](auto* ws) {
+                    ws->send(closed, uWS::OpCode::TEXT);
+                    ws->end(4004, "room closed");
+                });
+            }
+            metrics_.rtt_retired.merge(it->second->rtt_histogram());
+            metrics_.lockstep_resyncs_retired += it->second->lockstep_resyncs();
+            metrics_.rollback_retired.merge(it->second->rollback_stats());
+            directory_.remove(it->first);
+            if (registry_) registry_->release(it->first);
             it = rooms_.erase(it);
         } else {
             ++it;
@@ -134,40 +306,657 @@ void WebSocketServer::cleanup_empty_rooms() {
 
 void WebSocketServer::setup_room_broadcast(game::Room* room) {
     room->set_broadcast_fn(
-        [this](const std::string& pid, const std::string& message) {
-            auto it = player_sockets_.find(pid);
-            if (it == player_sockets_.end()) return;
+        [this](const std::string& pid, std::string_view message, game::Room::Payload kind) {
+            deliver(pid, message, kind);
+        }
+    );
+}
 
-            auto* ws = static_cast<uWS::WebSocket<false, true, PerSocketData>*>(it->second);
+void WebSocketServer::deliver(const std::string& player_id, std::string_view message,
+                              game::Room::Payload kind) {
+    auto it = player_sockets_.find(player_id);
+    if (it == player_sockets_.end()) return;
 
-            // Check backpressure before sending
-            auto bp = ws->getBufferedAmount();
-            if (bp > 128 * 1024) {
-                logger::warn("high backpressure for player " + pid + ": " + std::to_string(bp) + " bytes, dropping message");
-                return;  // Drop message instead of overwhelming the socket
-            }
+    auto* data = socket_data(it->second);
+    if (kind == game::Room::Payload::SNAPSHOT && udp_ && udp_->send_snapshot(player_id, message)) {
+        data->usage.bytes_out += message.size();
+        return;
+    }
+    enqueue(it->second, data, message, kind == game::Room::Payload::BINARY);
+}
+
+void WebSocketServer::handle_udp_input(const std::string& player_id, const network::datagrams::Input& in) {
+    auto it = player_sockets_.find(player_id);
+    if (it == player_sockets_.end()) return;
+    auto* data = socket_data(it->second);
+
+    auto now = std::chrono::steady_clock::now();
+    data->usage.messages++;
+    data->usage.bytes_in += network::datagrams::INPUT_SIZE;
+    auto cls = network::msg::MessageClass::INPUT;
+    if (data->inbound.check(cls, network::datagrams::INPUT_SIZE, now) != InboundLimiter::Verdict::ACCEPT) {
+        // No error frames or disconnects for datagrams: they are simply dropped
+        data->usage.limited++;
+        metrics_.inbound_limited[static_cast<std::size_t>(cls)]++;
+        return;
+    }
+    if (auto* room = get_room(data->room_id)) {
+        room->queue_input(player_id, static_cast<int>(in.tick), in.actions & game::input::ALL);
+    }
+}
+
+// ── Spectators ──────────────────────────────────────
 
-            auto status = ws->send(message, uWS::OpCode::TEXT);
-            if (status == uWS::WebSocket<false, true, PerSocketData>::DROPPED) {
-                logger::warn("message dropped for player " + pid + " (socket closing)");
+void WebSocketServer::publish_spectator_frame(const game::Room& room, std::string_view frame) {
+    with_app([&](auto* app) {
+        TRACE_SCOPE_ARG("net", "spectate.publish", frame.size());
+
+        // One publish per topic; uWS copies the frame into each viewer's cork
+        // buffer, so a viewer costs a memcpy and its share of a write
+        auto topic = spectator_topic(room.id(), false);
+        if (app->numSubscribers(topic) > 0) {
+            app->publish(topic, frame, uWS::OpCode::TEXT);
+            metrics_.spectator_frames++;
+            metrics_.spectator_bytes += frame.size();
+        }
+        topic += "/deflate";
+        if (app->numSubscribers(topic) > 0) {
+            auto deflated = spectator_deflater_.compress(frame);
+            if (deflated.empty()) return;
+            app->publish(topic, deflated, uWS::OpCode::BINARY);
+            metrics_.spectator_frames++;
+            metrics_.spectator_deflated_bytes += deflated.size();
+        }
+    });
+}
+
+// ── Outbound queues ─────────────────────────────────
+
+// Socket send buffer above which queued output is dropped, not written
+static constexpr unsigned int MAX_BACKPRESSURE = 128 * 1024;
+// Outboxes that grew past this give their memory back after a flush
+static constexpr std::size_t OUTBOX_SHRINK_BYTES = 64 * 1024;
+// Emptied outboxes kept for reuse; a burst beyond this frees the rest
+static constexpr std::size_t MAX_SPARE_OUTBOXES = 1024;
+
+void WebSocketServer::enqueue(void* ws, PerSocketData* data, std::string_view message, bool binary) {
+    if (!data->outbox) {
+        if (spare_outboxes_.empty()) {
+            data->outbox = std::make_unique<Outbox>();
+        } else {
+            data->outbox = std::move(spare_outboxes_.back());
+            spare_outboxes_.pop_back();
+        }
+    }
+    auto& box = *data->outbox;
+    if (data->batch && !binary) {
+        box.bytes.push_back(box.frame_ends.empty() ? '[' : ',');
+    }
+    box.bytes.append(message);
+    box.frame_ends.push_back(static_cast<uint32_t>(box.bytes.size()) | (binary ? Outbox::BINARY_FRAME : 0));
+    box.binary_frames += binary;
+    data->usage.bytes_out += message.size();
+    metrics_.ws_messages_queued++;
+
+    if (!data->queued) {
+        data->queued = true;
+        dirty_sockets_.push_back(ws);
+    }
+}
+
+void WebSocketServer::release_outbox(std::unique_ptr<Outbox> box) {
+    if (!box || spare_outboxes_.size() >= MAX_SPARE_OUTBOXES) return;
+    box->bytes.clear();
+    box->frame_ends.clear();
+    box->binary_frames = 0;
+    if (box->bytes.capacity() > OUTBOX_SHRINK_BYTES) {
+        box->bytes.shrink_to_fit();
+    }
+    spare_outboxes_.push_back(std::move(box));
+}
+
+// One socket's share of flush_outboxes()
+template <typename Socket>
+void WebSocketServer::flush_socket(Socket* ws) {
+    auto* data = ws->getUserData();
+    data->queued = false;
+    if (!data->outbox) return;
+    auto& box = *data->outbox;
+
+    // Check backpressure before sending
+    auto bp = ws->getBufferedAmount();
+    if (bp > MAX_BACKPRESSURE) {
+        logger::warn("high backpressure for player " + data->player_id + ": " + std::to_string(bp)
+                     + " bytes, dropping " + std::to_string(box.frame_ends.size()) + " messages");
+        metrics_.ws_dropped_backpressure += box.frame_ends.size();
+        TRACE_INSTANT("net", "ws.backpressure_drop");
+    } else {
+        // One corked write for everything queued this iteration
+        bool dropped = false;
+        ws->cork([&] {
+            std::string_view out = box.bytes;
+            bool batched = data->batch && box.binary_frames == 0;
+            if (batched && box.frame_ends.size() > 1) {
+                box.bytes.push_back(']');
+                dropped |= ws->send(box.bytes, uWS::OpCode::TEXT) == Socket::DROPPED;
+                metrics_.ws_frames_sent++;
+            } else if (batched) {
+                dropped |= ws->send(out.substr(1), uWS::OpCode::TEXT) == Socket::DROPPED;
+                metrics_.ws_frames_sent++;
+            } else {
+                // One frame per message; batch-mode text still carries its '[' / ','
+                uint32_t start = 0;
+                for (uint32_t entry : box.frame_ends) {
+                    uint32_t end = entry & ~Outbox::BINARY_FRAME;
+                    bool binary = entry & Outbox::BINARY_FRAME;
+                    if (!binary && data->batch) start++;
+                    dropped |= ws->send(out.substr(start, end - start),
+                                        binary ? uWS::OpCode::BINARY : uWS::OpCode::TEXT) == Socket::DROPPED;
+                    start = end;
+                }
+                metrics_.ws_frames_sent += box.frame_ends.size();
             }
+        });
+        metrics_.ws_flushes++;
+        if (dropped) {
+            logger::warn("message dropped for player " + data->player_id + " (socket closing)");
         }
-    );
+    }
+
+    release_outbox(std::move(data->outbox));
+}
+
+// A socket about to be closed can't wait for the iteration's flush: its
+// queue, including a parting message, goes out now and in order
+template <typename Socket>
+void WebSocketServer::flush_now(Socket* ws) {
+    if (ws->getUserData()->queued) {
+        dirty_sockets_.erase(std::remove(dirty_sockets_.begin(), dirty_sockets_.end(), static_cast<void*>(ws)),
+                             dirty_sockets_.end());
+    }
+    flush_socket(ws);
+}
+
+void WebSocketServer::flush_outboxes() {
+    if (dirty_sockets_.empty()) return;
+    TRACE_SCOPE_ARG("net", "ws.flush", dirty_sockets_.size());
+
+    for (void* raw : dirty_sockets_) {
+        with_socket(raw, [this](auto* ws) { flush_socket(ws); });
+    }
+    dirty_sockets_.clear();
+}
+
+// ── Latency ─────────────────────────────────────────
+
+network::RttHistogram WebSocketServer::shard_rtt() const {
+    network::RttHistogram h = metrics_.rtt_retired;
+    for (const auto& [_, room] : rooms_) {
+        h.merge(room->rtt_histogram());
+    }
+    return h;
+}
+
+// ── Inbound ─────────────────────────────────────────
+
+nlohmann::json WebSocketServer::heaviest_players(std::size_t n) const {
+    std::vector<const PerSocketData*> sockets;
+    sockets.reserve(player_sockets_.size());
+    for (const auto& [_, raw] : player_sockets_) {
+        sockets.push_back(socket_data(raw));
+    }
+    n = std::min(n, sockets.size());
+    std::partial_sort(sockets.begin(), sockets.begin() + static_cast<std::ptrdiff_t>(n), sockets.end(),
+                      [](const PerSocketData* a, const PerSocketData* b) { return a->usage.cpu_ns > b->usage.cpu_ns; });
+
+    auto out = nlohmann::json::array();
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto* d = sockets[i];
+        out.push_back({
+            {"player_id", d->player_id},
+            {"room_id", d->room_id},
+            {"cpu_ms", d->usage.cpu_ns / 1e6},
+            {"messages", d->usage.messages},
+            {"bytes_in", d->usage.bytes_in},
+            {"bytes_out", d->usage.bytes_out},
+            {"limited", d->usage.limited}
+        });
+    }
+    return out;
+}
+
+// ── Memory ──────────────────────────────────────────
+
+nlohmann::json WebSocketServer::memory_json() const {
+    using memory::heap_bytes;
+
+    auto outbox_bytes = [](const Outbox& b) {
+        return sizeof(Outbox) + heap_bytes(b.bytes) + heap_bytes(b.frame_ends);
+    };
+
+    // Connections: our per-socket data and index entry. uWS allocates the
+    // data inside its own socket struct and doesn't say how big that is;
+    // the gap between this and RSS is uWS, the allocator and the kernel.
+    std::size_t connections = memory::hash_map_bytes(player_sockets_);
+    std::size_t outboxes = heap_bytes(dirty_sockets_) + heap_bytes(spare_outboxes_);
+    for (const auto& [id, raw] : player_sockets_) {
+        const auto* d = socket_data(raw);
+        connections += sizeof(PerSocketData) + heap_bytes(id) + heap_bytes(d->player_id) + heap_bytes(d->room_id);
+        if (d->pending) {
+            connections += sizeof(PendingOpen) + heap_bytes(d->pending->player_name)
+                         + heap_bytes(d->pending->redirect_url);
+        }
+        if (d->outbox) outboxes += outbox_bytes(*d->outbox);
+    }
+    for (const auto& box : spare_outboxes_) outboxes += outbox_bytes(*box);
+
+    int players = 0, spectators = 0;
+    game::Room::MemoryUse rooms;
+    rooms.room = memory::hash_map_bytes(rooms_)
+               + (room_pool_.capacity() - room_pool_.in_use()) * sizeof(game::Room);
+    for (const auto& [id, room] : rooms_) {
+        auto m = room->memory_use();
+        rooms.room += m.room + heap_bytes(id);
+        rooms.players += m.players;
+        rooms.buffers += m.buffers;
+        players += room->player_count();
+        spectators += room->spectator_count();
+    }
+    std::size_t spectator_bytes = static_cast<std::size_t>(spectators) * sizeof(SpectatorData);
+
+    nlohmann::json caches = {
+        {"room_directory", directory_.memory_bytes()},
+        {"maps", maps_.memory_bytes()},
+        {"admission", admission_.memory_bytes()}
+    };
+    if (stats_) caches["stats_writer"] = stats_->memory_bytes();
+    if (udp_) caches["udp_sessions"] = udp_->memory_bytes();
+    std::size_t cache_bytes = 0;
+    for (const auto& [_, v] : caches.items()) cache_bytes += v.get<std::size_t>();
+
+    auto n = player_sockets_.size();
+    std::size_t accounted = connections + spectator_bytes + rooms.room + rooms.players
+                          + outboxes + rooms.buffers + cache_bytes;
+    return {
+        {"rss_bytes", memory::rss_bytes()},
+        {"accounted_bytes", accounted},
+        {"connections", {
+            {"count", n},
+            {"bytes", connections},
+            {"bytes_per_connection", n ? connections / n : 0},
+            {"socket_data_size", sizeof(PerSocketData)},
+            {"spectators", spectators},
+            {"spectator_bytes", spectator_bytes}
+        }},
+        {"rooms", {
+            {"count", rooms_.size()},
+            {"pooled", room_pool_.capacity()},
+            {"bytes", rooms.room}
+        }},
+        {"players", {
+            {"count", players},
+            {"bytes", rooms.players}
+        }},
+        {"outbound", {
+            {"outboxes_in_use", dirty_sockets_.size()},
+            {"outboxes_spare", spare_outboxes_.size()},
+            {"outbox_bytes", outboxes},
+            {"snapshot_bytes", rooms.buffers}
+        }},
+        {"caches", {
+            {"bytes", cache_bytes},
+            {"by_cache", std::move(caches)}
+        }}
+    };
+}
+
+// ── Tracing ─────────────────────────────────────────
+
+void WebSocketServer::write_trace_dump() {
+    static int dumps = 0;
+    std::string path = cfg_.trace_dir + "/wombocombo-trace-" + std::to_string(::getpid())
+                       + "-" + std::to_string(++dumps) + ".json";
+    if (trace::write_chrome_json(path)) {
+        logger::info("trace written to " + path);
+    } else {
+        logger::error("could not write trace to " + path);
+    }
+}
+
+// ── Hot restart ─────────────────────────────────────
+
+// Clients wait this long before reconnecting, giving the successor time to
+// restore the rooms (it is already listening; they queue until then)
+static constexpr int RESTART_RETRY_MS = 250;
+static constexpr auto DRAIN_TIMEOUT = std::chrono::seconds(3);
+
+nlohmann::json WebSocketServer::export_state() const {
+    nlohmann::json rooms = nlohmann::json::array();
+    for (const auto& [_, room] : rooms_) {
+        if (room->state() == game::RoomState::FINISHED) continue;
+        rooms.push_back(room->to_handoff_json());
+    }
+    nlohmann::json state = {
+        {"tick_count", tick_count_},
+        {"rooms", rooms}
+    };
+    if (registry_) state["node_id"] = registry_->node_id();
+    return state;
+}
+
+void WebSocketServer::import_state(const nlohmann::json& state) {
+    tick_count_ = state.value("tick_count", 0);
+
+    int restored = 0;
+    for (const auto& rj : state.value("rooms", nlohmann::json::array())) {
+        // restore_handoff() brings the lockstep state back
+        auto* room = get_or_create_room(rj.value("id", ""), game::RoomMode::SNAPSHOT);
+        if (!room) continue;
+        room->restore_handoff(rj);
+        restored++;
+    }
+
+    // Take over the predecessor's room leases right away
+    if (registry_) {
+        registry_->adopt(state.value("node_id", ""));
+        cluster_heartbeat();
+    }
+
+    logger::info("hot restart: restored " + std::to_string(restored) + " rooms at tick "
+                 + std::to_string(tick_count_));
+}
+
+void WebSocketServer::take_over() {
+    auto started = std::chrono::steady_clock::now();
+    if (auto state = hot_restart_->request_takeover()) {
+        import_state(*state);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        logger::info("hot restart: takeover completed in " + std::to_string(ms) + "ms");
+    }
+    hot_restart_->listen();
+}
+
+void WebSocketServer::begin_handoff() {
+    logger::info("hot restart: successor connected, handing off");
+    draining_ = true;
+
+    // The successor is already listening on the port: stop accepting here
+    // before the snapshot so no new player lands on this process after it
+    if (listen_socket_) {
+        us_listen_socket_close(tls_, static_cast<us_listen_socket_t*>(listen_socket_));
+        listen_socket_ = nullptr;
+    }
+
+    hot_restart_->send_state(export_state());
+
+    // Send everyone to the new process, after whatever was already queued
+    // for them; copy since close callbacks edit the map
+    flush_outboxes();
+    auto sockets = player_sockets_;
+    for (const auto& [pid, raw] : sockets) {
+        with_socket(raw, [this](auto* ws) {
+            auto* data = ws->getUserData();
+            enqueue(ws, data, network::make_server_restart(data->room_id, RESTART_RETRY_MS));
+            flush_now(ws);
+            ws->end(1012, "server restart");
+        });
+    }
+    detach_spectators(nullptr, [](auto* ws) {
+        auto* data = ws->getUserData();
+        ws->send(network::make_server_restart(data->room_id, RESTART_RETRY_MS), uWS::OpCode::TEXT);
+        ws->end(1012, "server restart");
+    });
+
+    drain_deadline_ = std::chrono::steady_clock::now() + DRAIN_TIMEOUT;
+}
+
+void WebSocketServer::finish_drain() {
+    if (!player_sockets_.empty() && std::chrono::steady_clock::now() < drain_deadline_) return;
+
+    logger::info("hot restart: drained, exiting (" + std::to_string(player_sockets_.size())
+                 + " sockets still closing)");
+    // With the listener and timer gone the event loop runs dry and run() returns
+    if (timer_) {
+        us_timer_close(static_cast<us_timer_t*>(timer_));
+        timer_ = nullptr;
+    }
 }
 
 void WebSocketServer::tick() {
+    if (draining_) {
+        // State now belongs to the successor — don't simulate it twice
+        finish_drain();
+        return;
+    }
+
+    if (hot_restart_ && hot_restart_->poll_takeover()) {
+        begin_handoff();
+        return;
+    }
+
+    TRACE_SCOPE_ARG("tick", "tick", rooms_.size());
+    alloc_stats::Scope allocs;
+    auto tick_started = std::chrono::steady_clock::now();
     tick_count_++;
 
+    // Inputs that arrived over UDP since the last tick
+    if (udp_) udp_->poll(tick_started);
+
+    playing_rooms_.clear();
     for (auto& [id, room] : rooms_) {
-        if (room->state() == game::RoomState::PLAYING) {
-            room->update(tick_dt_);
+        if (room->state() == game::RoomState::PLAYING) playing_rooms_.push_back(room.get());
+    }
+
+    // Simulate and serialize every room in parallel — rooms share nothing
+    // but read-only maps — then queue the snapshots here on the loop thread.
+    // They go out in the same corked flush as everything else this iteration.
+    {
+        TRACE_SCOPE_ARG("tick", "tick.simulate", playing_rooms_.size());
+        sim_pool_.parallel_for(playing_rooms_.size(), [this](std::size_t i) {
+            playing_rooms_[i]->simulate(tick_dt_);
+        });
+    }
+    {
+        TRACE_SCOPE("tick", "tick.publish");
+        for (auto* room : playing_rooms_) {
+            room->publish();
+        }
+    }
+
+    // Re-plan snapshot throttling once per second, from the rooms' tick costs
+    if (tick_count_ % cfg_.tick_rate == 0) {
+        load_shedder_.adjust(playing_rooms_);
+    }
+
+    // Reap finished and abandoned rooms once per second
+    if (tick_count_ % cfg_.tick_rate == 0) {
+        cleanup_empty_rooms();
+    }
+
+    // Windowed per-player rates for /metrics
+    if (tick_count_ % cfg_.tick_rate == 0) {
+        auto now = std::chrono::steady_clock::now();
+        metrics_.sample(static_cast<int>(player_sockets_.size()),
+                        std::chrono::duration<double>(now - last_metrics_sample_).count());
+        last_metrics_sample_ = now;
+    }
+
+    // Forget quiet addresses every 10s
+    if (tick_count_ % (cfg_.tick_rate * 10) == 0) {
+        admission_.prune(std::chrono::steady_clock::now());
+    }
+
+    if (registry_ && tick_count_ % (cfg_.tick_rate * registry_->heartbeat_interval_seconds()) == 0) {
+        cluster_heartbeat();
+    }
+
+    // kill -USR1: dump the trace rings to a file
+    if (trace::dump_requested()) {
+        write_trace_dump();
+    }
+
+    last_tick_allocs_ = allocs.allocations();
+    load_shedder_.record_tick(std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - tick_started).count());
+}
+
+// Cluster routing, once the token checks out (loop thread). A room served
+// here or with a cached owner is answered inline; otherwise the registry
+// thread looks it up (claiming it if it comes here) and the upgrade resumes
+// via defer, like the JWT check.
+template <typename Response>
+void WebSocketServer::route_upgrade(Response* res, const std::shared_ptr<UpgradeRequest>& up) {
+    if (!registry_ || up->auth_failed || draining_ || rooms_.count(up->room_id)) {
+        complete_upgrade(res, *up);
+        return;
+    }
+    if (auto peer = registry_->cached_owner(up->room_id)) {
+        redirect_upgrade(res, *up, *peer);
+        return;
+    }
+
+    auto* loop = uWS::Loop::get();
+    bool queued = registry_->route(up->room_id, up->redirected, local_load(),
+                                   [this, up, loop, res](std::optional<std::string> peer) {
+        loop->defer([this, up, res, peer = std::move(peer)] {
+            if (up->aborted) return;
+            res->cork([&] {
+                if (peer) redirect_upgrade(res, *up, *peer);
+                else complete_upgrade(res, *up);
+            });
+        });
+    });
+    if (!queued) {
+        res->writeStatus("503 Service Unavailable")
+           ->writeHeader("Retry-After", "1")
+           ->end("Handshake backlog full");
+    }
+}
+
+// Browsers can't follow a redirect on a WebSocket handshake, so accept it
+// and tell the client where to go in the first frame. Only reached with a
+// verified token (or none needed).
+template <typename Response>
+void WebSocketServer::redirect_upgrade(Response* res, UpgradeRequest& up, const std::string& peer) {
+    PerSocketData redirect;
+    redirect.pending = std::make_unique<PendingOpen>();
+    // One redirect=1 however many nodes the client has been bounced through
+    auto query = strip_query_param(up.query, "redirect");
+    redirect.pending->redirect_url = peer + "/ws/" + up.room_id + "?" + query
+                                     + (query.empty() ? "" : "&") + "redirect=1";
+    logger::info("room " + up.room_id + " served by another node, redirecting to " + peer);
+    res->template upgrade<PerSocketData>(
+        std::move(redirect),
+        up.key,
+        up.protocol,
+        up.extensions,
+        static_cast<struct us_socket_context_t*>(up.context)
+    );
+}
+
+// Room checks and the actual upgrade — runs on the loop thread, either inline
+// or deferred after off-loop JWT verification
+template <typename Response>
+void WebSocketServer::complete_upgrade(Response* res, UpgradeRequest& up) {
+    TRACE_SCOPE("net", "ws.complete_upgrade");
+    if (up.auth_failed) {
+        res->writeStatus("401 Unauthorized")
+           ->end("Invalid or expired token");
+        return;
+    }
+    if (!up.token.empty()) {
+        logger::info("JWT validated | player=" + up.player_id + " name=" + up.player_name);
+    }
+    if (draining_) {
+        res->writeStatus("503 Service Unavailable")
+           ->end("Server restarting");
+        return;
+    }
+
+    // Check room availability
+    auto* room = get_or_create_room(up.room_id, up.mode);
+    if (!room) {
+        res->writeStatus("503 Service Unavailable")
+           ->end("Server at capacity");
+        return;
+    }
+
+    // Check if player is already in this room (reconnect scenario)
+    if (room->has_player(up.player_id)) {
+        auto sock_it = player_sockets_.find(up.player_id);
+        if (sock_it != player_sockets_.end()) {
+            with_socket(sock_it->second, [](auto* old_ws) {
+                old_ws->getUserData()->player_id = "";  // prevent double-remove
+                old_ws->close();
+            });
+        }
+        room->remove_player(up.player_id);
+    }
+
+    if (room->is_full()) {
+        // Allow if player is reconnecting (saved in disconnected list)
+        bool is_reconnect = (room->state() == game::RoomState::PLAYING);
+        if (!is_reconnect) {
+            res->writeStatus("403 Forbidden")
+               ->end("Room is full");
+            return;
         }
     }
+    if (room->state() == game::RoomState::FINISHED) {
+        res->writeStatus("403 Forbidden")
+           ->end("Room is finished");
+        return;
+    }
+
+    res->template upgrade<PerSocketData>(
+        {
+            .player_id = std::move(up.player_id),
+            .room_id = std::move(up.room_id),
+            .pending = std::make_unique<PendingOpen>(PendingOpen{.player_name = std::move(up.player_name),
+                                                                 .udp = up.udp}),
+            .batch = up.batch
+        },
+        up.key,
+        up.protocol,
+        up.extensions,
+        static_cast<struct us_socket_context_t*>(up.context)
+    );
 }
 
 void WebSocketServer::run() {
-    uWS::App()
-        .ws<PerSocketData>("/ws/*", {
+    TRACE_THREAD_NAME("loop");
+    if (trace::enabled) {
+        trace::install_dump_signal();
+    }
+
+    // Everything queued during a loop iteration (events + tick) goes out in one flush
+    uWS::Loop::get()->addPostHandler(this, [this](uWS::Loop* /*loop*/) {
+        flush_outboxes();
+        if (udp_) udp_->flush();
+    });
+
+    if (!tls_) {
+        uWS::App app;
+        serve(app);
+        return;
+    }
+
+    // wss:// in process: uSockets built with OpenSSL (ENABLE_TLS)
+    const auto& key = cfg_.tls_key_file.empty() ? cfg_.tls_cert_file : cfg_.tls_key_file;
+    uWS::SSLApp app({.key_file_name = key.c_str(), .cert_file_name = cfg_.tls_cert_file.c_str()});
+    if (app.constructorFailed()) {
+        logger::error("tls: cannot load certificate " + cfg_.tls_cert_file + " / key " + key);
+        return;
+    }
+    if (!tls_sessions_.configure(app.getNativeHandle(), cfg_)) return;
+    serve(app);
+}
+
+template <typename App>
+void WebSocketServer::serve(App& app) {
+    app_ = &app;
+    app.template ws<PerSocketData>("/ws/*", {
             .compression = uWS::DISABLED,
             .maxPayloadLength = 16 * 1024,
             .idleTimeout = 120,
@@ -175,120 +964,124 @@ void WebSocketServer::run() {
 
             // ── Upgrade (HTTP → WS handshake) ────────────────
             .upgrade = [this](auto* res, auto* req, auto* context) {
-                auto url = std::string(req->getUrl());
-                auto query_str = std::string(req->getQuery());
-                auto full_url = url + "?" + query_str;
-                auto params = parse_query(full_url);
+                TRACE_SCOPE("net", "ws.upgrade");
+                // ── Admission ───────────────────────────────
+                // Before anything else: shed floods with a cheap 429
+                if (!admission_.admit(res->getRemoteAddress(), std::chrono::steady_clock::now())) {
+                    res->writeStatus("429 Too Many Requests")
+                       ->writeHeader("Retry-After", "1")
+                       ->end();
+                    return;
+                }
+
+                // Views into the request buffer — nothing is copied until
+                // the handshake is known to be worth the work
+                std::string_view url = req->getUrl();
+                std::string_view query_str = req->getQuery();
 
                 // Extract room code from path: /ws/{roomCode}
-                std::string room_id;
-                if (url.rfind("/ws/", 0) == 0 && url.size() > 4) {
-                    room_id = url.substr(4);
+                std::string_view room_code;
+                if (url.size() > 4 && url.substr(0, 4) == "/ws/") {
+                    room_code = url.substr(4);
                 }
 
-                std::string token = params.count("token") ? params["token"] : "";
+                std::string_view token = find_query_param(query_str, "token");
 
                 // Validate room_id
-                if (room_id.empty()) {
+                if (room_code.empty()) {
                     res->writeStatus("400 Bad Request")
                        ->end("Missing room code in path");
                     return;
                 }
 
-                // ── JWT validation ──────────────────────────
-                std::string player_id;
-                std::string player_name = "Player";
-
-                if (!jwt_secret_.empty() && !token.empty()) {
-                    auto payload = auth::validate_jwt(token, jwt_secret_);
-                    if (!payload) {
-                        res->writeStatus("401 Unauthorized")
-                           ->end("Invalid or expired token");
-                        return;
-                    }
-                    player_id = payload->sub;
-                    player_name = payload->username;
-                    logger::info("JWT validated | player=" + player_id + " name=" + player_name);
-                } else {
-                    // Dev mode fallback: generate random ID
-                    player_id = generate_id();
-                    logger::debug("no JWT — generated player_id " + player_id);
+                auto up = std::make_shared<UpgradeRequest>();
+                up->room_id = room_code;
+                up->key = req->getHeader("sec-websocket-key");
+                up->protocol = req->getHeader("sec-websocket-protocol");
+                up->extensions = req->getHeader("sec-websocket-extensions");
+                up->context = context;
+                up->batch = find_query_param(query_str, "batch") == "1";
+                up->udp = find_query_param(query_str, "udp") == "1";
+                auto mode = game::parse_room_mode(find_query_param(query_str, "mode"));
+                up->mode = mode ? *mode : cfg_.lockstep_rooms ? game::RoomMode::LOCKSTEP
+                                                              : game::RoomMode::SNAPSHOT;
+                if (registry_) {
+                    up->redirected = has_query_param(query_str, "redirect");
+                    up->query = query_str;
                 }
+                // Both the JWT check and cluster routing may finish off-loop
+                res->onAborted([up] { up->aborted = true; });
 
-                // Check room availability
-                auto* room = get_or_create_room(room_id);
-                if (!room) {
-                    res->writeStatus("503 Service Unavailable")
-                       ->end("Server at max room capacity");
+                if (jwt_secret_.empty() || token.empty()) {
+                    // Dev mode fallback: generate random ID
+                    up->player_id = generate_id();
+                    logger::debug("no JWT — generated player_id " + up->player_id);
+                    route_upgrade(res, up);
                     return;
                 }
 
-                // Check if player is already in this room (reconnect scenario)
-                if (room->has_player(player_id)) {
-                    auto sock_it = player_sockets_.find(player_id);
-                    if (sock_it != player_sockets_.end()) {
-                        auto* old_ws = static_cast<uWS::WebSocket<false, true, PerSocketData>*>(sock_it->second);
-                        old_ws->getUserData()->player_id = "";  // prevent double-remove
-                        old_ws->close();
+                // ── JWT validation (off-loop) ───────────────
+                // Verified on the crypto pool; the upgrade resumes on the loop
+                // thread via defer, unless the client hung up meanwhile.
+                up->token = token;
+
+                auto* loop = uWS::Loop::get();
+                bool queued = crypto_pool_.try_submit([this, up, loop, res] {
+                    TRACE_SCOPE("auth", "jwt.verify");
+                    if (auto payload = auth::validate_jwt(up->token, jwt_secret_)) {
+                        up->player_id = std::move(payload->sub);
+                        up->player_name = std::move(payload->username);
+                    } else {
+                        up->auth_failed = true;
                     }
-                    room->remove_player(player_id);
-                }
-
-                if (room->is_full()) {
-                    // Allow if player is reconnecting (saved in disconnected list)
-                    bool is_reconnect = (room->state() == game::RoomState::PLAYING);
-                    if (!is_reconnect) {
-                        res->writeStatus("403 Forbidden")
-                           ->end("Room is full");
-                        return;
-                    }
-                }
-                if (room->state() == game::RoomState::FINISHED) {
-                    res->writeStatus("403 Forbidden")
-                       ->end("Room is finished");
-                    return;
+                    loop->defer([this, up, res] {
+                        if (up->aborted) return;
+                        res->cork([this, up, res] { route_upgrade(res, up); });
+                    });
+                });
+                if (!queued) {
+                    res->writeStatus("503 Service Unavailable")
+                       ->writeHeader("Retry-After", "1")
+                       ->end("Handshake backlog full");
                 }
-
-                res->template upgrade<PerSocketData>(
-                    {
-                        .player_id = player_id,
-                        .player_name = player_name,
-                        .room_id = room_id
-                    },
-                    req->getHeader("sec-websocket-key"),
-                    req->getHeader("sec-websocket-protocol"),
-                    req->getHeader("sec-websocket-extensions"),
-                    context
-                );
             },
 
             // ── Connection opened ────────────────────────────
             .open = [this](auto* ws) {
                 auto* data = ws->getUserData();
+                auto pending = std::move(data->pending);
+
+                if (!pending->redirect_url.empty()) {
+                    enqueue(ws, data, network::make_redirect(pending->redirect_url));
+                    flush_now(ws);
+                    ws->end(4001, "room on another node");
+                    return;
+                }
+                const std::string& player_name = pending->player_name;
+
+                data->inbound = InboundLimiter(inbound_limits_, std::chrono::steady_clock::now());
+
                 logger::info("ws open | player=" + data->player_id
-                             + " name=" + data->player_name
+                             + " name=" + player_name
                              + " room=" + data->room_id);
 
                 player_sockets_[data->player_id] = ws;
 
                 auto* room = get_room(data->room_id);
                 if (!room) {
-                    ws->send(network::make_error(500, "Room disappeared").dump(),
-                             uWS::OpCode::TEXT);
+                    enqueue(ws, data, network::make_error(500, "Room disappeared"));
+                    flush_now(ws);
                     ws->close();
                     return;
                 }
 
-                setup_room_broadcast(room);
-
                 game::Player player;
                 player.id = data->player_id;
-                player.name = data->player_name;
-                player.display_name = data->player_name;
+                player.name = player_name;
 
                 if (!room->add_player(player)) {
-                    ws->send(network::make_error(403, "Could not join room").dump(),
-                             uWS::OpCode::TEXT);
+                    enqueue(ws, data, network::make_error(403, "Could not join room"));
+                    flush_now(ws);
                     ws->close();
                     return;
                 }
@@ -296,29 +1089,35 @@ void WebSocketServer::run() {
                 // Send "connected" to the new player (include room state so frontend knows phase)
                 auto room_state_str = game::room_state_str(room->state());
                 room->send_to(data->player_id,
-                              network::make_connected(data->player_id, data->player_name,
+                              network::make_connected(data->player_id, player_name,
                                                       room->current_tick(), room_state_str));
 
+                // A new connection never inherits an old one's UDP binding
+                if (udp_) {
+                    udp_->remove(data->player_id);
+                    if (pending->udp) {
+                        auto token = udp_->offer(data->player_id);
+                        room->send_to(data->player_id,
+                                      network::make_udp_offer(udp_->port(), network::datagrams::token_hex(token),
+                                                              cfg_.udp_timeout_ms));
+                    }
+                }
+
                 // Notify others
                 room->broadcast_except(data->player_id,
-                    network::make_player_joined(data->player_id, data->player_name));
+                    network::make_player_joined(data->player_id, player_name));
 
                 // Send appropriate state based on room phase
                 if (room->state() == game::RoomState::PLAYING) {
                     // Player reconnected during gameplay — send rejoin info (NOT game_start!)
                     // The frontend should handle "game_rejoin" differently from "game_start"
                     // and just resume receiving game_state without re-navigating
-                    room->send_to(data->player_id, {
-                        {"type", "game_rejoin"},
-                        {"tick", room->current_tick()},
-                        {"round", 1},
-                        {"map_data", {
-                            {"width", game::physics::MAP_WIDTH},
-                            {"height", game::physics::MAP_HEIGHT},
-                            {"ground_y", game::physics::GROUND_Y}
-                        }}
-                    });
+                    room->send_to(data->player_id, room->game_rejoin_message());
                     logger::info("sent game_rejoin to reconnected player " + data->player_id);
+                    // Its body is back in the simulation: everyone takes the same state
+                    if (room->mode() == game::RoomMode::LOCKSTEP) {
+                        room->broadcast(room->lockstep_state());
+                    }
                 } else {
                     // Send lobby state to everyone
                     room->broadcast(room->lobby_state());
@@ -326,24 +1125,51 @@ void WebSocketServer::run() {
             },
 
             // ── Message received ─────────────────────────────
-            .message = [this](auto* ws, std::string_view message, uWS::OpCode /*opCode*/) {
+            .message = [this](auto* ws, std::string_view message, uWS::OpCode opCode) {
+                TRACE_SCOPE_ARG("net", "ws.message", message.size());
+                bool binary = opCode == uWS::OpCode::BINARY;
                 auto* data = ws->getUserData();
-
-                auto parsed = network::parse_message(message);
-                if (!parsed) {
-                    ws->send(network::make_error(400, "Invalid JSON").dump(),
-                             uWS::OpCode::TEXT);
+                auto start = std::chrono::steady_clock::now();
+                data->usage.messages++;
+                data->usage.bytes_in += message.size();
+                metrics_.ws_messages_received++;
+                metrics_.ws_bytes_received += message.size();
+
+                // ── Inbound budget ──────────────────────────
+                // Before the parse: classify by the sniffed type only
+                auto cls = binary ? network::msg::MessageClass::INPUT : network::classify(message);
+                auto verdict = data->inbound.check(cls, message.size(), start);
+                if (verdict != InboundLimiter::Verdict::ACCEPT) {
+                    data->usage.limited++;
+                    metrics_.inbound_limited[static_cast<std::size_t>(cls)]++;
+                    if (verdict == InboundLimiter::Verdict::NOTIFY) {
+                        static const std::string notice = network::make_error(429, "Rate limit exceeded");
+                        enqueue(ws, data, notice);
+                    } else if (verdict == InboundLimiter::Verdict::DISCONNECT) {
+                        logger::warn("inbound budget exhausted, disconnecting player " + data->player_id);
+                        metrics_.inbound_disconnects++;
+                        ws->end(4008, "rate limit exceeded");
+                    }
                     return;
                 }
 
                 auto* room = get_room(data->room_id);
                 if (!room) {
-                    ws->send(network::make_error(404, "Room not found").dump(),
-                             uWS::OpCode::TEXT);
+                    static const std::string not_found = network::make_error(404, "Room not found");
+                    enqueue(ws, data, not_found);
                     return;
                 }
 
-                network::handle_message(*room, data->player_id, *parsed);
+                if (binary) {
+                    network::handle_binary(*room, data->player_id, message);
+                } else {
+                    network::handle_message(*room, data->player_id, message);
+                }
+
+                auto spent = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+                data->usage.cpu_ns += spent;
+                metrics_.inbound_dispatch_ns += spent;
             },
 
             // ── Drain (backpressure relieved) ────────────────
@@ -359,8 +1185,24 @@ void WebSocketServer::run() {
             .close = [this](auto* ws, int code, std::string_view /*reason*/) {
                 auto* data = ws->getUserData();
 
+                // Never flush into a dead socket
+                if (data->queued) {
+                    dirty_sockets_.erase(std::remove(dirty_sockets_.begin(), dirty_sockets_.end(),
+                                                     static_cast<void*>(ws)),
+                                         dirty_sockets_.end());
+                    data->queued = false;
+                }
+                release_outbox(std::move(data->outbox));
+
                 // Skip if already cleaned up (reconnect scenario)
                 if (data->player_id.empty()) return;
+                if (udp_) udp_->remove(data->player_id);
+
+                // Handing off: the room state already lives in the successor
+                if (draining_) {
+                    player_sockets_.erase(data->player_id);
+                    return;
+                }
 
                 logger::info("ws close | player=" + data->player_id
                              + " room=" + data->room_id
@@ -382,6 +1224,85 @@ void WebSocketServer::run() {
             }
         })
 
+        // ── Spectators ───────────────────────────────────
+        // Not players: no JWT, no slot, nothing they send is read. They
+        // subscribe to the room's delayed stream and that's all they cost.
+        .template ws<SpectatorData>("/spectate/*", {
+            .compression = uWS::DISABLED,       // see network::Deflater
+            .maxPayloadLength = 512,
+            .idleTimeout = 120,
+            .maxBackpressure = 1024 * 1024,
+            .closeOnBackpressureLimit = true,   // a viewer that can't keep up is dropped
+
+            .upgrade = [this](auto* res, auto* req, auto* context) {
+                TRACE_SCOPE("net", "spectate.upgrade");
+                if (!admission_.admit(res->getRemoteAddress(), std::chrono::steady_clock::now())) {
+                    res->writeStatus("429 Too Many Requests")
+                       ->writeHeader("Retry-After", "1")
+                       ->end();
+                    return;
+                }
+
+                // /spectate/{roomCode}; only rooms served by this node
+                std::string_view url = req->getUrl();
+                constexpr std::string_view prefix = "/spectate/";
+                auto* room = url.size() > prefix.size()
+                    ? get_room(std::string(url.substr(prefix.size()))) : nullptr;
+                if (!room) {
+                    res->writeStatus("404 Not Found")->end("Room not found");
+                    return;
+                }
+                if (room->spectator_count() >= cfg_.max_spectators_per_room) {
+                    res->writeStatus("503 Service Unavailable")->end("Room at spectator capacity");
+                    return;
+                }
+
+                res->template upgrade<SpectatorData>(
+                    SpectatorData{room->id(), find_query_param(req->getQuery(), "deflate") == "1"},
+                    req->getHeader("sec-websocket-key"),
+                    req->getHeader("sec-websocket-protocol"),
+                    req->getHeader("sec-websocket-extensions"),
+                    context
+                );
+            },
+
+            .open = [this](auto* ws) {
+                auto* data = ws->getUserData();
+                auto* room = get_room(data->room_id);
+                if (!room) {
+                    ws->end(4004, "room closed");
+                    return;
+                }
+                room->add_spectator();
+                data->room = room;
+                spectator_sockets_.insert(ws);
+                ws->subscribe(spectator_topic(data->room_id, data->deflate));
+
+                const auto& stream = room->spectator_stream();
+                int tick_ms = 1000 / cfg_.tick_rate;
+                ws->send(network::make_spectating(data->room_id, game::room_state_str(room->state()),
+                                                  room->current_tick(), stream.delay_ticks() * tick_ms,
+                                                  stream.interval_ticks() * tick_ms, data->deflate),
+                         uWS::OpCode::TEXT);
+                // Mid-match: the map now, snapshots once the delayed stream catches up
+                if (room->state() == game::RoomState::PLAYING) {
+                    ws->send(room->game_rejoin_message(), uWS::OpCode::TEXT);
+                }
+            },
+
+            .message = [](auto* /*ws*/, std::string_view /*message*/, uWS::OpCode /*opCode*/) {},
+
+            .close = [this](auto* ws, int /*code*/, std::string_view /*reason*/) {
+                // The room it joined, not whatever now has its code; null once reaped
+                auto* data = ws->getUserData();
+                if (data->room) {
+                    data->room->remove_spectator();
+                    data->room = nullptr;
+                    spectator_sockets_.erase(ws);
+                }
+            }
+        })
+
         // ── Health check ─────────────────────────────────
         .get("/health", [](auto* res, auto* /*req*/) {
             res->writeHeader("Content-Type", "application/json")
@@ -400,18 +1321,192 @@ void WebSocketServer::run() {
                 {"rooms_active", rooms_.size()},
                 {"rooms_playing", playing_rooms},
                 {"players_online", total_players},
-                {"tick", tick_count_}
+                {"tick", tick_count_},
+                {"event_loop", EVENT_LOOP}
             };
+            if (registry_) {
+                info["node_id"] = registry_->node_id();
+                info["cluster"] = registry_->to_json();
+            }
+            info["admission"] = {
+                {"rejected_ip", admission_.rejected_ip()},
+                {"rejected_global", admission_.rejected_global()},
+                {"tracked_addresses", admission_.tracked_addresses()},
+                {"jwt_queue", crypto_pool_.queued()}
+            };
+            if (alloc_stats::enabled) {
+                info["tick_allocs"] = last_tick_allocs_;
+            }
             res->writeHeader("Content-Type", "application/json")
                ->end(info.dump());
         })
 
+        // ── Metrics ──────────────────────────────────────
+        .get("/metrics", [this](auto* res, auto* /*req*/) {
+            auto body = metrics_.to_json();
+            body["players_online"] = player_sockets_.size();
+            body["tick"] = load_shedder_.to_json();
+            body["rtt"] = shard_rtt().to_json();
+            if (stats_) body["stats"] = stats_->to_json();
+            body["inbound"]["heaviest_players"] = heaviest_players(5);
+            int spectators = 0, lockstep_rooms = 0;
+            uint64_t resyncs = metrics_.lockstep_resyncs_retired;
+            game::RollbackStats rollback = metrics_.rollback_retired;
+            for (const auto& [_, room] : rooms_) {
+                spectators += room->spectator_count();
+                if (room->mode() == game::RoomMode::LOCKSTEP) lockstep_rooms++;
+                resyncs += room->lockstep_resyncs();
+                rollback.merge(room->rollback_stats());
+            }
+            body["spectators"]["connected"] = spectators;
+            body["lockstep"] = {{"rooms", lockstep_rooms}, {"resyncs", resyncs}};
+            body["rollback"] = rollback.to_json();
+            body["rollback"]["window_ticks"] = cfg_.rollback_ticks;
+            if (udp_) body["udp"] = udp_->to_json();
+            if (tls_) body["tls"] = tls_sessions_.to_json();
+            res->writeHeader("Content-Type", "application/json")
+               ->end(body.dump());
+        })
+
+        // ── Memory ───────────────────────────────────────
+        // Live bytes per subsystem (walked on request) next to RSS
+        .get("/memory", [this](auto* res, auto* /*req*/) {
+            res->writeHeader("Content-Type", "application/json")
+               ->end(memory_json().dump());
+        })
+
+        // ── Latency ──────────────────────────────────────
+        // Shard RTT histogram and per-room percentiles; ?room=CODE for one
+        // room's histogram and its players' smoothed RTT/jitter
+        .get("/rtt", [this](auto* res, auto* req) {
+            nlohmann::json body;
+            auto room_id = find_query_param(req->getQuery(), "room");
+            if (!room_id.empty()) {
+                auto* room = get_room(std::string(room_id));
+                if (!room) {
+                    res->writeStatus("404 Not Found")->end("Room not found");
+                    return;
+                }
+                body = room->rtt_json();
+            } else {
+                nlohmann::json rooms = nlohmann::json::array();
+                for (const auto& [id, room] : rooms_) {
+                    const auto& h = room->rtt_histogram();
+                    if (h.count() == 0) continue;
+                    rooms.push_back({{"room_id", id}, {"count", h.count()},
+                                     {"p50_ms", h.percentile(50)}, {"p99_ms", h.percentile(99)}});
+                }
+                body = {{"shard", shard_rtt().to_json()}, {"rooms", std::move(rooms)}};
+            }
+            res->writeHeader("Content-Type", "application/json")
+               ->end(body.dump());
+        })
+
+        // ── Trace dump ───────────────────────────────────
+        // Chrome trace-event JSON of recent tick phases and network events;
+        // open in ui.perfetto.dev or chrome://tracing
+        .get("/trace", [](auto* res, auto* /*req*/) {
+            if (!trace::enabled) {
+                res->writeStatus("404 Not Found")
+                   ->end("Tracing not compiled in (build with -DENABLE_TRACE=ON)");
+                return;
+            }
+            res->writeHeader("Content-Type", "application/json")
+               ->end(trace::chrome_json());
+        })
+
+        // ── Room directory ───────────────────────────────
+        // ?state=waiting|playing&open=1&offset=0&limit=50
+        .get("/rooms", [this](auto* res, auto* req) {
+            game::RoomQuery query;
+            std::string_view qs = req->getQuery();
+            auto state = find_query_param(qs, "state");
+            if (state == "waiting") query.state = game::RoomState::WAITING;
+            else if (state == "playing") query.state = game::RoomState::PLAYING;
+            query.open_only = find_query_param(qs, "open") == "1";
+
+            auto parse_int = [](std::string_view v, int fallback) {
+                int out = fallback;
+                std::from_chars(v.data(), v.data() + v.size(), out);
+                return out;
+            };
+            query.offset = parse_int(find_query_param(qs, "offset"), 0);
+            query.limit = parse_int(find_query_param(qs, "limit"), query.limit);
+
+            res->writeHeader("Content-Type", "application/json")
+               ->writeHeader("Cache-Control", "max-age=1")
+               ->end(directory_.listing(query));
+        })
+
+        // ── Quick match: a joinable WAITING room, or a fresh one ──
+        .get("/rooms/quickmatch", [this](auto* res, auto* /*req*/) {
+            auto reply = [](auto* res, const std::string& room_id) {
+                nlohmann::json body = {{"room_id", room_id}};
+                res->writeHeader("Content-Type", "application/json")
+                   ->end(body.dump());
+            };
+            auto create = [this, reply](auto* res, const std::string& room_id) {
+                auto* room = get_or_create_room(room_id, cfg_.lockstep_rooms ? game::RoomMode::LOCKSTEP
+                                                                              : game::RoomMode::SNAPSHOT);
+                if (!room) {
+                    res->writeStatus("503 Service Unavailable")
+                       ->end("Server at capacity");
+                    return;
+                }
+                room->start_grace_period();  // the caller may never connect
+                reply(res, room_id);
+            };
+
+            if (const auto* open = directory_.quick_match()) {
+                reply(res, *open);
+                return;
+            }
+            std::string room_id;
+            do { room_id = generate_id(6); } while (rooms_.count(room_id));
+            if (!registry_) {
+                create(res, room_id);
+                return;
+            }
+
+            // Claimed on the registry thread; the response resumes on the loop
+            auto aborted = std::make_shared<bool>(false);
+            res->onAborted([aborted] { *aborted = true; });
+            auto* loop = uWS::Loop::get();
+            bool queued = registry_->claim(room_id, [this, loop, res, aborted, create, room_id](bool claimed) {
+                loop->defer([this, res, aborted, create, room_id, claimed] {
+                    if (*aborted) return;
+                    res->cork([&] {
+                        if (!claimed || rooms_.count(room_id)) {
+                            res->writeStatus("503 Service Unavailable")
+                               ->end("Room code collision, retry");
+                            return;
+                        }
+                        create(res, room_id);
+                    });
+                });
+            });
+            if (!queued) {
+                res->writeStatus("503 Service Unavailable")
+                   ->writeHeader("Retry-After", "1")
+                   ->end("Cluster registry backlog full");
+            }
+        })
+
         .listen(cfg_.port, [this](auto* listen_socket) {
             if (listen_socket) {
-                logger::info("game server listening on port " + std::to_string(cfg_.port));
+                listen_socket_ = listen_socket;
+                logger::info("game server listening on port " + std::to_string(cfg_.port)
+                             + (tls_ ? " (wss)" : ""));
                 logger::info("tick_rate=" + std::to_string(cfg_.tick_rate)
                              + " tick_dt=" + std::to_string(tick_dt_) + "s"
-                             + " jwt=" + (jwt_secret_.empty() ? "disabled" : "enabled"));
+                             + " jwt=" + (jwt_secret_.empty() ? "disabled" : "enabled")
+                             + " event_loop=" + EVENT_LOOP);
+
+                // Listening first (uSockets sets SO_REUSEPORT, so the port is
+                // shared with a predecessor): connections that arrive during
+                // the handoff queue here instead of being refused. The loop
+                // isn't running yet, so they wait until the state is in.
+                if (hot_restart_) take_over();
 
                 // ── Start game loop timer ────────────────
                 int tick_ms = static_cast<int>(tick_dt_ * 1000.0f);
@@ -419,6 +1514,7 @@ void WebSocketServer::run() {
                     (struct us_loop_t*) uWS::Loop::get(), 0, sizeof(WebSocketServer*));
                 WebSocketServer* self = this;
                 memcpy(us_timer_ext(timer), &self, sizeof(WebSocketServer*));
+                timer_ = timer;
                 us_timer_set(timer, [](struct us_timer_t* t) {
                     WebSocketServer* srv;
                     memcpy(&srv, us_timer_ext(t), sizeof(WebSocketServer*));
@@ -432,6 +1528,7 @@ void WebSocketServer::run() {
         })
 
         .run();
+    app_ = nullptr;
 }
 
 } // namespace server
@@ -2,56 +2,276 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <chrono>
 
 #include "utils/config.h"
 #include "game/room.h"
+#include "game/room_directory.h"
+#include "game/tilemap.h"
+#include "network/deflate.h"
 #include "storage/redis_client.h"
+#include "storage/room_registry.h"
+#include "storage/stats_writer.h"
+#include "server/hot_restart.h"
+#include "server/admission.h"
+#include "server/crypto_pool.h"
+#include "server/inbound_limiter.h"
+#include "server/load_shedder.h"
+#include "server/work_pool.h"
+#include "server/metrics.h"
+#include "server/tls.h"
+#include "server/udp_channel.h"
+#include "utils/object_pool.h"
 
 namespace server {
 
-// Per-socket data attached to each WebSocket connection
+// Output queued for one socket during a loop iteration. Borrowed from the
+// server's spares on the first enqueue and handed back after the flush, so
+// an idle connection holds no buffer at all.
+// In batch mode (?batch=1) queued messages go out as one JSON array frame,
+// unless binary lockstep frames are queued too: then each goes on its own.
+struct Outbox {
+    static constexpr uint32_t BINARY_FRAME = 1u << 31;  // flag in frame_ends
+
+    std::string bytes;
+    std::vector<uint32_t> frame_ends;   // end offset of each message in bytes, | BINARY_FRAME
+    uint32_t binary_frames = 0;
+};
+
+// Handshake results only .open needs; dropped once the player has joined
+struct PendingOpen {
+    std::string player_name;
+    std::string redirect_url{};  // set when the room lives on another node
+    bool udp = false;            // ?udp=1: offer the UDP channel
+};
+
+// Per-socket data attached to each WebSocket connection. One per connected
+// player for the life of the connection, so it stays small: see /memory.
 struct PerSocketData {
     std::string player_id;
-    std::string player_name;
     std::string room_id;
+    std::unique_ptr<PendingOpen> pending{};
+
+    // Outbound queue, flushed once per loop iteration under cork
+    std::unique_ptr<Outbox> outbox{};
+
+    // Inbound budgets (armed in .open) and what this connection has cost
+    InboundLimiter inbound{};
+    ConnectionUsage usage{};
+
+    bool batch = false;
+    bool queued = false;                  // listed in dirty_sockets_
+};
+
+// Per-socket data of a spectator (/spectate/{room}); everything it receives
+// comes through the room's pub/sub topic
+struct SpectatorData {
+    std::string room_id;
+    bool deflate = false;     // ?deflate=1: snapshots as raw-deflate binary frames
+    game::Room* room = nullptr;  // counted in from .open until .close or the room is reaped
+};
+
+// Handshake state carried across the off-loop JWT check and registry lookup
+struct UpgradeRequest {
+    std::string room_id;
+    std::string token;
+    std::string key;
+    std::string protocol;
+    std::string extensions;
+    void* context = nullptr;  // us_socket_context_t*
+
+    // Cluster routing: ?redirect=1 and the query a redirect passes on
+    bool redirected = false;
+    std::string query;
+
+    // Filled by verification
+    std::string player_id;
+    std::string player_name = "Player";
+    bool auth_failed = false;
+    bool batch = false;
+    bool udp = false;
+    game::RoomMode mode = game::RoomMode::SNAPSHOT;  // if this creates the room
+
+    // Set by onAborted (loop thread only)
+    bool aborted = false;
 };
 
 class WebSocketServer {
 public:
     explicit WebSocketServer(const config::ServerConfig& cfg);
 
-    // Start listening — blocks the calling thread
+    // Start listening (wss:// when TLS_CERT_FILE is set) — blocks the calling thread
     void run();
 
     // Called by the game loop timer every tick
     void tick();
 
 private:
+    // run()'s routes and event loop, for uWS::App or uWS::SSLApp
+    template <typename App>
+    void serve(App& app);
+
+    // Calls f with a player socket or the app cast back to their uWS type,
+    // which depends on tls_
+    template <typename F>
+    decltype(auto) with_socket(void* raw, F&& f) const;
+    template <typename F>
+    void with_app(F&& f) const;
+    PerSocketData* socket_data(void* raw) const;
+    template <typename F>
+    void with_spectator(void* raw, F&& f) const;
+
+    // Calls f with each spectator of `room` (every spectator when null),
+    // already uncounted from the room so its .close leaves the room alone
+    template <typename F>
+    void detach_spectators(const game::Room* room, F&& f);
+
     // Room management
-    game::Room* get_or_create_room(const std::string& room_id);
+    game::Room* get_or_create_room(const std::string& room_id, game::RoomMode mode);
     game::Room* get_room(const std::string& room_id);
     void cleanup_empty_rooms();
 
+    // Finish a handshake once the player is known (loop thread)
+    template <typename Response>
+    void complete_upgrade(Response* res, UpgradeRequest& up);
+
+    // Multi-node routing after verification: upgrade here, or redirect the
+    // client to the node that owns (or should take) the room
+    template <typename Response>
+    void route_upgrade(Response* res, const std::shared_ptr<UpgradeRequest>& up);
+    template <typename Response>
+    void redirect_upgrade(Response* res, UpgradeRequest& up, const std::string& peer);
+    double local_load() const;
+    void cluster_heartbeat();
+
+    // Hot restart: hand state to a successor and drain, or adopt a predecessor's state
+    nlohmann::json export_state() const;
+    void import_state(const nlohmann::json& state);
+    void take_over();
+    void begin_handoff();
+    void finish_drain();
+
+    // Outbound queues: enqueue() marks the socket dirty, flush_outboxes()
+    // writes everything once per loop iteration; flush_now() writes one
+    // socket's queue right before it is closed
+    void enqueue(void* ws, PerSocketData* data, std::string_view message, bool binary = false);
+    void flush_outboxes();
+    template <typename Socket>
+    void flush_socket(Socket* ws);
+    template <typename Socket>
+    void flush_now(Socket* ws);
+    void release_outbox(std::unique_ptr<Outbox> box);
+
+    // Live bytes per subsystem, estimated by walking the structures (/memory)
+    nlohmann::json memory_json() const;
+
+    // Connections that cost the most loop time, heaviest first
+    nlohmann::json heaviest_players(std::size_t n) const;
+
+    // Fans a room's delayed spectator frame out to its topic(s)
+    void publish_spectator_frame(const game::Room& room, std::string_view frame);
+
+    // Every RTT sample on this node: live rooms plus closed ones
+    network::RttHistogram shard_rtt() const;
+
+    // SIGUSR1 handler's work: trace rings → <trace_dir>/wombocombo-trace-<pid>-<n>.json
+    void write_trace_dump();
+
     // Setup broadcast callback for a room
     void setup_room_broadcast(game::Room* room);
 
-    // Parse query string params from URL
-    static std::unordered_map<std::string, std::string> parse_query(std::string_view url);
+    // Queues a message for a connected player; snapshots go over UDP when
+    // the player has it bound
+    void deliver(const std::string& player_id, std::string_view message, game::Room::Payload kind);
+
+    // Inputs from the UDP channel, under the same inbound budget as the WebSocket's
+    void handle_udp_input(const std::string& player_id, const network::datagrams::Input& in);
 
     config::ServerConfig cfg_;
-    std::unordered_map<std::string, std::unique_ptr<game::Room>> rooms_;
 
-    // Map player_id → their raw WebSocket pointer (void* to avoid template in header)
+    // Loaded tilemaps, shared by every room on the same map
+    game::MapRegistry maps_;
+
+    // Rooms are recycled through a pool that grows a chunk at a time as rooms
+    // are created; declared before rooms_ so it outlives them
+    utils::ObjectPool<game::Room> room_pool_;
+    std::unordered_map<std::string, utils::PooledPtr<game::Room>> rooms_;
+
+    // Searchable index of rooms_ for /rooms and quick-match
+    game::RoomDirectory directory_;
+
+    // Map player_id → their raw WebSocket pointer (void* to avoid template in header;
+    // cast back with with_socket())
     std::unordered_map<std::string, void*> player_sockets_;
 
+    // Spectator sockets counted in a room, for closing them with it (cast
+    // back with with_spectator())
+    std::unordered_set<void*> spectator_sockets_;
+
+    // Sockets with queued output this loop iteration, and emptied outboxes
+    // waiting for the next one
+    std::vector<void*> dirty_sockets_;
+    std::vector<std::unique_ptr<Outbox>> spare_outboxes_;
+
+    // Spectator frames are deflated once per room for every ?deflate=1 viewer
+    network::Deflater spectator_deflater_;
+
+    Metrics metrics_;
+    std::chrono::steady_clock::time_point last_metrics_sample_ = std::chrono::steady_clock::now();
+
+    // Tick budget: throttles expensive rooms, decides whether new rooms fit
+    LoadShedder load_shedder_;
+    std::vector<game::Room*> playing_rooms_;  // rebuilt each tick
+
+    // Per-IP and global handshake rate limits
+    AdmissionControl admission_;
+
+    // Per-connection message budgets, referenced by every socket's limiter
+    InboundLimits inbound_limits_;
+
+    // Off-loop JWT verification
+    CryptoPool crypto_pool_;
+
+    // Parallel room simulation within a tick (the loop thread joins in)
+    WorkPool sim_pool_;
+
     // Redis for JWT secret and room config
     storage::RedisClient redis_;
     std::string jwt_secret_;
 
+    // Write-behind player stats (null when STATS_ENABLED=0); its own
+    // Redis connection, on its own thread
+    std::unique_ptr<storage::StatsWriter> stats_;
+
+    // Cluster room registry (null when running single-node); its own Redis
+    // connection, on its own thread
+    std::unique_ptr<storage::RoomRegistry> registry_;
+
+    // UDP snapshot channel (null when UDP_PORT is unset)
+    std::unique_ptr<UdpChannel> udp_;
+
+    // Hot restart (null when disabled)
+    std::unique_ptr<HotRestart> hot_restart_;
+    bool draining_ = false;
+    std::chrono::steady_clock::time_point drain_deadline_;
+
+    // uSockets handles, void to keep uWS out of the header. A node serves
+    // either TLS or plain sockets, never both: tls_ picks the type.
+    bool tls_ = false;
+    TlsSessions tls_sessions_;
+    void* app_ = nullptr;            // uWS::App* / uWS::SSLApp* while serve() is live (pub/sub)
+    void* listen_socket_ = nullptr;  // us_listen_socket_t*
+    void* timer_ = nullptr;          // us_timer_t*
+
     // Game loop state
     int tick_count_ = 0;
     float tick_dt_ = 0.05f;  // 1/20 = 50ms
+    uint64_t last_tick_allocs_ = 0;  // heap allocations in the last tick (ENABLE_ALLOC_STATS)
 };
 
 } // namespace server
@@ -0,0 +1,134 @@
+#include "server/work_pool.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+
+namespace server {
+
+WorkPool::WorkPool(int threads)
+    : lane_count_(std::max(0, threads) + 1),
+      lanes_(std::make_unique<Lane[]>(lane_count_)) {
+    threads_.reserve(lane_count_ - 1);
+    for (int i = 1; i < lane_count_; ++i) {
+        threads_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+WorkPool::~WorkPool() {
+    stopping_.store(true, std::memory_order_release);
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void WorkPool::parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn) {
+    if (lane_count_ == 1 || n < MIN_PARALLEL) {
+        for (std::size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+
+    fn_ = &fn;
+    for (base_ = 0; base_ < n; base_ += MAX_BATCH) {
+        auto count = static_cast<uint32_t>(std::min(n - base_, MAX_BATCH));
+
+        // Contiguous slices; neighbours in rooms_ order tend to be similar
+        for (int i = 0; i < lane_count_; ++i) {
+            auto b = static_cast<uint32_t>(uint64_t(count) * i / lane_count_);
+            auto e = static_cast<uint32_t>(uint64_t(count) * (i + 1) / lane_count_);
+            auto& range = lanes_[i].range;
+            range.store(pack(tag_of(range.load(std::memory_order_relaxed)) + 1, b, e),
+                        std::memory_order_relaxed);
+        }
+
+        busy_.store(lane_count_ - 1, std::memory_order_relaxed);
+        epoch_.fetch_add(1, std::memory_order_release);
+        epoch_.notify_all();
+
+        run_lane(0);
+
+        // Helpers may still be finishing their last item
+        for (int b = busy_.load(std::memory_order_acquire); b != 0;
+             b = busy_.load(std::memory_order_acquire)) {
+            busy_.wait(b, std::memory_order_acquire);
+        }
+    }
+    fn_ = nullptr;
+}
+
+// Owner takes from the front of its own range
+bool WorkPool::pop(Lane& lane, uint32_t& index) {
+    uint64_t r = lane.range.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t b = begin_of(r), e = end_of(r);
+        if (b >= e) return false;
+        if (lane.range.compare_exchange_weak(r, pack(tag_of(r) + 1, b + 1, e),
+                                             std::memory_order_acq_rel)) {
+            index = b;
+            return true;
+        }
+    }
+}
+
+// Take the back half of the largest range left, run its first item now and
+// publish the rest as our own range (so it can be stolen onwards)
+bool WorkPool::steal(int self, uint32_t& index) {
+    for (;;) {
+        int victim = -1;
+        uint64_t victim_range = 0;
+        uint32_t most = 0;
+        for (int k = 1; k < lane_count_; ++k) {
+            int i = (self + k) % lane_count_;
+            uint64_t r = lanes_[i].range.load(std::memory_order_acquire);
+            uint32_t b = begin_of(r), e = end_of(r);
+            if (b < e && e - b > most) {
+                most = e - b;
+                victim = i;
+                victim_range = r;
+            }
+        }
+        if (victim < 0) return false;
+
+        uint32_t b = begin_of(victim_range), e = end_of(victim_range);
+        uint32_t mid = b + (e - b) / 2;     // victim keeps [b, mid), we take [mid, e)
+        if (!lanes_[victim].range.compare_exchange_strong(
+                victim_range, pack(tag_of(victim_range) + 1, b, mid), std::memory_order_acq_rel)) {
+            continue;
+        }
+
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        auto& own = lanes_[self].range;
+        own.store(pack(tag_of(own.load(std::memory_order_relaxed)) + 1, mid + 1, e),
+                  std::memory_order_release);
+        index = mid;
+        return true;
+    }
+}
+
+void WorkPool::run_lane(int self) {
+    uint32_t index;
+    for (;;) {
+        if (pop(lanes_[self], index) || steal(self, index)) {
+            (*fn_)(base_ + index);
+        } else {
+            return;
+        }
+    }
+}
+
+void WorkPool::worker_loop(int self) {
+    TRACE_THREAD_NAME("sim");
+    uint32_t seen = 0;
+    for (;;) {
+        epoch_.wait(seen, std::memory_order_acquire);
+        seen = epoch_.load(std::memory_order_acquire);
+        if (stopping_.load(std::memory_order_acquire)) return;
+
+        run_lane(self);
+
+        if (busy_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            busy_.notify_one();
+        }
+    }
+}
+
+} // namespace server
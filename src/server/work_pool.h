@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace server {
+
+// Fork-join pool for the tick's parallel phase: parallel_for() splits [0, n)
+// into one contiguous range per worker (the calling thread is worker 0),
+// and a worker that runs dry steals the back half of the largest remaining
+// range. Rooms cost very different amounts to simulate, so static slicing
+// alone would leave cores idle behind the one holding the big matches.
+//
+// Ranges live in one 64-bit word per worker (tag | begin | end) so both the
+// owner's pop and a thief's split are a single CAS; the tag rules out ABA.
+class WorkPool {
+public:
+    // `threads` helpers on top of the caller; 0 runs everything inline
+    explicit WorkPool(int threads);
+    ~WorkPool();
+
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    // Calls fn(i) for every i in [0, n) and returns once all have finished.
+    // fn must be safe to run concurrently for different i.
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn);
+
+    int workers() const { return lane_count_; }
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t INDEX_BITS = 24;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr std::size_t MAX_BATCH = INDEX_MASK;
+
+    // Below this many items waking the helpers costs more than it saves
+    static constexpr std::size_t MIN_PARALLEL = 4;
+
+    struct alignas(64) Lane {
+        std::atomic<uint64_t> range{0};
+    };
+
+    static uint64_t pack(uint64_t tag, uint32_t begin, uint32_t end) {
+        return (tag & 0xFFFF) << (2 * INDEX_BITS) | uint64_t(begin) << INDEX_BITS | end;
+    }
+    static uint64_t tag_of(uint64_t r) { return r >> (2 * INDEX_BITS); }
+    static uint32_t begin_of(uint64_t r) { return static_cast<uint32_t>(r >> INDEX_BITS) & INDEX_MASK; }
+    static uint32_t end_of(uint64_t r) { return static_cast<uint32_t>(r) & INDEX_MASK; }
+
+    bool pop(Lane& lane, uint32_t& index);
+    bool steal(int self, uint32_t& index);
+    void run_lane(int self);
+    void worker_loop(int self);
+
+    int lane_count_;
+    std::unique_ptr<Lane[]> lanes_;
+    std::vector<std::thread> threads_;
+
+    const std::function<void(std::size_t)>* fn_ = nullptr;
+    std::size_t base_ = 0;                    // offset of the current batch
+
+    std::atomic<uint32_t> epoch_{0};          // bumped to start a batch
+    std::atomic<int> busy_{0};                // helpers still inside the batch
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> steals_{0};
+};
+
+} // namespace server
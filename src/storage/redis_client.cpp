@@ -12,14 +12,65 @@ RedisClient::~RedisClient() {
     }
 }
 
-bool RedisClient::connect(const std::string& host, int port, const std::string& password) {
-    // Clean up previous connection if any
+namespace {
+
+constexpr timeval IO_TIMEOUT = {0, 500 * 1000};  // keep loop stalls bounded
+
+RedisReply convert_reply(const redisReply* r) {
+    RedisReply out;
+    switch (r->type) {
+        case REDIS_REPLY_STRING:
+            out.type = RedisReply::Type::STRING;
+            out.str.assign(r->str, r->len);
+            break;
+        case REDIS_REPLY_STATUS:
+            out.type = RedisReply::Type::STATUS;
+            out.str.assign(r->str, r->len);
+            break;
+        case REDIS_REPLY_ERROR:
+            out.type = RedisReply::Type::ERROR;
+            out.str.assign(r->str, r->len);
+            break;
+        case REDIS_REPLY_INTEGER:
+            out.type = RedisReply::Type::INTEGER;
+            out.integer = r->integer;
+            break;
+        case REDIS_REPLY_ARRAY:
+            out.type = RedisReply::Type::ARRAY;
+            out.elements.reserve(r->elements);
+            for (size_t i = 0; i < r->elements; ++i) {
+                out.elements.push_back(convert_reply(r->element[i]));
+            }
+            break;
+        default:
+            break;
+    }
+    return out;
+}
+
+} // namespace
+
+void RedisClient::drop() {
     if (ctx_) {
         redisFree(static_cast<redisContext*>(ctx_));
         ctx_ = nullptr;
     }
+}
+
+bool RedisClient::reconnect() {
+    if (host_.empty()) return false;
+    return connect(host_, port_, password_);
+}
 
-    auto* c = redisConnect(host.c_str(), port);
+bool RedisClient::connect(const std::string& host, int port, const std::string& password) {
+    // Clean up previous connection if any
+    drop();
+
+    host_ = host;
+    port_ = port;
+    password_ = password;
+
+    auto* c = redisConnectWithTimeout(host.c_str(), port, IO_TIMEOUT);
     if (!c) {
         logger::error("redis: failed to allocate context");
         return false;
@@ -54,6 +105,7 @@ bool RedisClient::connect(const std::string& host, int port, const std::string&
     }
     freeReplyObject(reply);
 
+    redisSetTimeout(c, IO_TIMEOUT);
     ctx_ = c;
     logger::info("redis: connected to " + host + ":" + std::to_string(port)
                  + (password.empty() ? " (no auth)" : " (authenticated)"));
@@ -102,4 +154,65 @@ bool RedisClient::set_ex(const std::string& key, const std::string& value, int t
     return ok;
 }
 
+std::optional<RedisReply> RedisClient::command(const std::vector<std::string>& argv) {
+    if (!ctx_ || argv.empty()) return std::nullopt;
+    auto* c = static_cast<redisContext*>(ctx_);
+
+    std::vector<const char*> args;
+    std::vector<size_t> lens;
+    args.reserve(argv.size());
+    lens.reserve(argv.size());
+    for (const auto& a : argv) {
+        args.push_back(a.data());
+        lens.push_back(a.size());
+    }
+
+    auto* reply = static_cast<redisReply*>(
+        redisCommandArgv(c, static_cast<int>(args.size()), args.data(), lens.data()));
+    if (!reply) {
+        logger::warn("redis: " + argv[0] + " failed: " + std::string(c->errstr));
+        drop();
+        return std::nullopt;
+    }
+
+    auto result = convert_reply(reply);
+    freeReplyObject(reply);
+    return result;
+}
+
+std::size_t RedisClient::pipeline(const std::vector<std::vector<std::string>>& cmds,
+                                  std::vector<RedisReply>* replies) {
+    if (replies) replies->clear();
+    if (!ctx_ || cmds.empty()) return 0;
+    auto* c = static_cast<redisContext*>(ctx_);
+
+    std::vector<const char*> args;
+    std::vector<size_t> lens;
+    for (const auto& argv : cmds) {
+        args.clear();
+        lens.clear();
+        for (const auto& a : argv) {
+            args.push_back(a.data());
+            lens.push_back(a.size());
+        }
+        redisAppendCommandArgv(c, static_cast<int>(args.size()), args.data(), lens.data());
+    }
+
+    std::size_t ok = 0;
+    for (size_t i = 0; i < cmds.size(); ++i) {
+        void* raw = nullptr;
+        if (redisGetReply(c, &raw) != REDIS_OK || !raw) {
+            logger::warn("redis: pipeline failed after " + std::to_string(i) + " replies: "
+                         + std::string(c->errstr));
+            drop();
+            return ok;
+        }
+        auto* reply = static_cast<redisReply*>(raw);
+        if (reply->type != REDIS_REPLY_ERROR) ok++;
+        if (replies) replies->push_back(convert_reply(reply));
+        freeReplyObject(reply);
+    }
+    return ok;
+}
+
 } // namespace storage
@@ -2,9 +2,21 @@
 
 #include <string>
 #include <optional>
+#include <vector>
 
 namespace storage {
 
+// Generic reply for command()/pipeline() — mirrors hiredis' redisReply
+struct RedisReply {
+    enum class Type { NIL, STRING, STATUS, INTEGER, ARRAY, ERROR };
+    Type type = Type::NIL;
+    std::string str;                   // STRING, STATUS, ERROR
+    long long integer = 0;             // INTEGER
+    std::vector<RedisReply> elements;  // ARRAY
+
+    bool ok() const { return type != Type::ERROR; }
+};
+
 class RedisClient {
 public:
     RedisClient() = default;
@@ -22,10 +34,28 @@ public:
     bool set(const std::string& key, const std::string& value);
     bool set_ex(const std::string& key, const std::string& value, int ttl_seconds);
 
+    // Arbitrary binary-safe command, e.g. {"ZADD", "nodes:load", "0.5", "node-a"}.
+    // Returns nullopt on I/O failure (the connection is then dropped).
+    std::optional<RedisReply> command(const std::vector<std::string>& argv);
+
+    // Sends all commands in one round trip. Returns the number that succeeded;
+    // with `replies`, also their replies in order (fewer if the connection broke).
+    std::size_t pipeline(const std::vector<std::vector<std::string>>& cmds,
+                         std::vector<RedisReply>* replies = nullptr);
+
+    // Re-establish a dropped connection with the last connect() parameters
+    bool reconnect();
+
     bool is_connected() const { return ctx_ != nullptr; }
 
 private:
+    void drop();
+
     void* ctx_ = nullptr;  // redisContext*, void to avoid hiredis include in header
+
+    std::string host_;
+    int port_ = 0;
+    std::string password_;
 };
 
 } // namespace storage
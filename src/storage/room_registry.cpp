@@ -0,0 +1,341 @@
+#include "storage/room_registry.h"
+#include "utils/logger.h"
+
+#include <cstdlib>
+#include <utility>
+
+namespace storage {
+
+namespace {
+
+std::string node_key(const std::string& id) { return "node:" + id; }
+std::string room_key(const std::string& id) { return "room:" + id; }
+
+constexpr const char* LOAD_KEY = "nodes:load";
+
+// Delete KEYS[1] only if it still holds ARGV[1]
+constexpr const char* RELEASE_SCRIPT =
+    "if redis.call('get', KEYS[1]) == ARGV[1] then return redis.call('del', KEYS[1]) end return 0";
+
+// Renew the lease KEYS[1] for ARGV[1] for ARGV[2] seconds: extend it if we
+// (or ARGV[3], the predecessor of a hot restart) hold it, take it with SET NX
+// if it lapsed. Returns 1 if renewed, 2 if re-taken, else the other owner.
+constexpr const char* LEASE_SCRIPT =
+    "local owner = redis.call('get', KEYS[1]) "
+    "if owner == ARGV[1] then redis.call('expire', KEYS[1], ARGV[2]) return 1 end "
+    "if owner and ARGV[3] ~= '' and owner == ARGV[3] then "
+    "redis.call('set', KEYS[1], ARGV[1], 'EX', ARGV[2]) return 1 end "
+    "if redis.call('set', KEYS[1], ARGV[1], 'NX', 'EX', ARGV[2]) then return 2 end "
+    "return owner";
+
+// New rooms only move to a peer if it is meaningfully less loaded
+constexpr double LOAD_MARGIN = 0.1;
+
+// Reconnect attempts back off between these while Redis is down
+constexpr int MIN_BACKOFF_MS = 250;
+constexpr int MAX_BACKOFF_MS = 30'000;
+
+// The url in a node:{id} value, if the reply is one
+std::optional<std::string> node_url(const RedisReply& reply) {
+    if (reply.type != RedisReply::Type::STRING) return std::nullopt;
+    auto info = nlohmann::json::parse(reply.str, nullptr, false);
+    if (info.is_discarded() || !info.is_object()) return std::nullopt;
+    return info.value("url", "");
+}
+
+} // namespace
+
+RoomRegistry::RoomRegistry(RegistryConfig cfg) : cfg_(std::move(cfg)) {
+    thread_ = std::thread([this] { run(); });
+}
+
+RoomRegistry::~RoomRegistry() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+// ── Loop side ───────────────────────────────────────────────────
+
+bool RoomRegistry::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jobs_.size() >= cfg_.max_queue) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        jobs_.push_back(std::move(job));
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void RoomRegistry::heartbeat(std::vector<std::string> local_rooms, int players, double load) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        heartbeat_ = Heartbeat{std::move(local_rooms), players, load};
+    }
+    wake_.notify_one();
+}
+
+void RoomRegistry::adopt(std::string previous_node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    predecessor_ = std::move(previous_node);
+}
+
+bool RoomRegistry::route(std::string room_id, bool redirected, double load,
+                         std::function<void(std::optional<std::string>)> done) {
+    return submit([this, room_id = std::move(room_id), redirected, load, done = std::move(done)] {
+        done(resolve(room_id, redirected, load));
+    });
+}
+
+bool RoomRegistry::claim(std::string room_id, std::function<void(bool)> done) {
+    return submit([this, room_id = std::move(room_id), done = std::move(done)] {
+        done(try_claim(room_id));
+    });
+}
+
+void RoomRegistry::release(std::string room_id) {
+    // Dropped with a full queue: the lease then lapses after the TTL
+    submit([this, room_id = std::move(room_id)] {
+        if (!ensure_connected()) return;
+        redis_.command({"EVAL", RELEASE_SCRIPT, "1", room_key(room_id), cfg_.node_id});
+    });
+}
+
+std::optional<std::string> RoomRegistry::cached_owner(const std::string& room_id) const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = owners_.find(room_id);
+    if (it == owners_.end() || it->second.expires < Clock::now()) return std::nullopt;
+    auto node = nodes_.find(it->second.node_id);
+    if (node == nodes_.end()) return std::nullopt;
+    return node->second.url;
+}
+
+nlohmann::json RoomRegistry::to_json() const {
+    std::size_t queued, peers, owners;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued = jobs_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        peers = nodes_.size();
+        owners = owners_.size();
+    }
+    return {
+        {"node_id", cfg_.node_id},
+        {"connected", connected_.load(std::memory_order_relaxed)},
+        {"queued", queued},
+        {"live_peers", peers},
+        {"cached_owners", owners},
+        {"reconnects", reconnects_.load(std::memory_order_relaxed)},
+        {"lease_conflicts", lease_conflicts_.load(std::memory_order_relaxed)},
+        {"dropped", dropped_.load(std::memory_order_relaxed)}
+    };
+}
+
+// ── Registry thread ─────────────────────────────────────────────
+
+void RoomRegistry::run() {
+    for (;;) {
+        std::optional<Heartbeat> hb;
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || heartbeat_ || !jobs_.empty(); });
+            if (stopping_) return;
+            if (heartbeat_) {
+                hb = std::exchange(heartbeat_, std::nullopt);
+            } else {
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+        }
+        if (hb) send_heartbeat(*hb);
+        else job();
+        connected_.store(redis_.is_connected(), std::memory_order_relaxed);
+    }
+}
+
+bool RoomRegistry::ensure_connected() {
+    if (redis_.is_connected()) return true;
+
+    auto now = Clock::now();
+    if (now < next_connect_) return false;
+    if (redis_.connect(cfg_.host, cfg_.port, cfg_.password)) {
+        if (backoff_ms_ > 0) {
+            reconnects_.fetch_add(1, std::memory_order_relaxed);
+            logger::info("cluster: reconnected to Redis");
+        }
+        backoff_ms_ = 0;
+        return true;
+    }
+    backoff_ms_ = std::clamp(backoff_ms_ * 2, MIN_BACKOFF_MS, MAX_BACKOFF_MS);
+    next_connect_ = now + std::chrono::milliseconds(backoff_ms_);
+    return false;
+}
+
+void RoomRegistry::send_heartbeat(const Heartbeat& hb) {
+    if (!ensure_connected()) return;
+
+    std::string predecessor;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        predecessor = predecessor_;
+    }
+
+    nlohmann::json info = {
+        {"url", cfg_.public_url},
+        {"rooms", hb.rooms.size()},
+        {"players", hb.players}
+    };
+    auto ttl = std::to_string(cfg_.ttl_seconds);
+
+    std::vector<std::vector<std::string>> cmds;
+    cmds.reserve(hb.rooms.size() + 2);
+    cmds.push_back({"SET", node_key(cfg_.node_id), info.dump(), "EX", ttl});
+    cmds.push_back({"ZADD", LOAD_KEY, std::to_string(hb.load), cfg_.node_id});
+    for (const auto& room_id : hb.rooms) {
+        // Only our own leases are extended; one that lapsed during an outage
+        // is re-taken only if nobody else claimed it meanwhile
+        cmds.push_back({"EVAL", LEASE_SCRIPT, "1", room_key(room_id), cfg_.node_id, ttl, predecessor});
+    }
+    std::vector<RedisReply> replies;
+    redis_.pipeline(cmds, &replies);
+    if (replies.size() != cmds.size()) return;  // connection lost, next heartbeat retries
+
+    for (std::size_t i = 0; i < hb.rooms.size(); ++i) {
+        const auto& reply = replies[i + 2];
+        if (reply.type != RedisReply::Type::STRING) continue;
+        // Both nodes now serve the room; its lease stays with the other one
+        lease_conflicts_.fetch_add(1, std::memory_order_relaxed);
+        logger::warn("cluster: room " + hb.rooms[i] + " is also served by node " + reply.str
+                     + ", which holds its lease");
+    }
+    if (!predecessor.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (predecessor_ == predecessor) predecessor_.clear();
+    }
+
+    // Reap nodes whose heartbeat has lapsed and cache the live ones: every
+    // node:{id} in one round trip
+    auto members = redis_.command({"ZRANGE", LOAD_KEY, "0", "-1", "WITHSCORES"});
+    if (!members || members->type != RedisReply::Type::ARRAY) return;
+
+    std::vector<NodeInfo> peers;
+    cmds.clear();
+    const auto& el = members->elements;
+    for (std::size_t i = 0; i + 1 < el.size(); i += 2) {
+        if (el[i].str == cfg_.node_id) continue;
+        peers.push_back({el[i].str, "", std::strtod(el[i + 1].str.c_str(), nullptr)});
+        cmds.push_back({"GET", node_key(el[i].str)});
+    }
+    replies.clear();
+    redis_.pipeline(cmds, &replies);
+    if (replies.size() != cmds.size()) return;
+
+    std::unordered_map<std::string, NodeInfo> live;
+    cmds.clear();
+    for (std::size_t i = 0; i < peers.size(); ++i) {
+        if (auto url = node_url(replies[i])) {
+            peers[i].url = std::move(*url);
+            live.emplace(peers[i].id, std::move(peers[i]));
+        } else if (replies[i].type == RedisReply::Type::NIL) {
+            cmds.push_back({"ZREM", LOAD_KEY, peers[i].id});
+            logger::warn("cluster: node " + peers[i].id + " missed its heartbeat, removed");
+        }
+    }
+    if (!cmds.empty()) redis_.pipeline(cmds);
+
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    nodes_ = std::move(live);
+    for (auto it = owners_.begin(); it != owners_.end();) {
+        if (it->second.expires < now || !nodes_.count(it->second.node_id)) it = owners_.erase(it);
+        else ++it;
+    }
+}
+
+void RoomRegistry::remember_owner(const std::string& room_id, const std::string& node_id) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    owners_[room_id] = {node_id, Clock::now() + std::chrono::seconds(heartbeat_interval_seconds())};
+}
+
+std::optional<NodeInfo> RoomRegistry::lookup_node(const std::string& node_id) {
+    auto reply = redis_.command({"GET", node_key(node_id)});
+    if (!reply) return std::nullopt;
+    auto url = node_url(*reply);
+    if (!url) return std::nullopt;
+    return NodeInfo{node_id, std::move(*url), 0.0};
+}
+
+std::optional<NodeInfo> RoomRegistry::owner(const std::string& room_id) {
+    auto reply = redis_.command({"GET", room_key(room_id)});
+    if (!reply || reply->type != RedisReply::Type::STRING) return std::nullopt;
+
+    const auto& owner_id = reply->str;
+    if (owner_id == cfg_.node_id) return NodeInfo{cfg_.node_id, cfg_.public_url, 0.0};
+
+    auto node = lookup_node(owner_id);
+    if (!node && redis_.is_connected()) {
+        // Owner is dead — free the room for whoever gets it next
+        logger::warn("cluster: room " + room_id + " owned by dead node " + owner_id + ", releasing");
+        redis_.command({"EVAL", RELEASE_SCRIPT, "1", room_key(room_id), owner_id});
+    }
+    return node;
+}
+
+std::optional<std::string> RoomRegistry::resolve(const std::string& room_id, bool redirected, double load) {
+    if (!ensure_connected()) return std::nullopt;  // Redis down — serve it here
+
+    if (auto current = owner(room_id)) {
+        if (current->id == cfg_.node_id) return std::nullopt;
+        remember_owner(room_id, current->id);
+        return current->url;
+    }
+
+    // Unowned — place it on the least-loaded peer, unless a peer already sent the client here
+    if (!redirected) {
+        std::optional<NodeInfo> best;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            for (const auto& [id, node] : nodes_) {
+                if (!best || node.load < best->load) best = node;
+            }
+        }
+        // The cache is a heartbeat old: make sure it is still alive
+        if (best && best->load + LOAD_MARGIN < load && lookup_node(best->id)) {
+            return best->url;
+        }
+    }
+
+    if (!try_claim(room_id)) {
+        // Lost the race to another node
+        auto current = owner(room_id);
+        if (current && current->id != cfg_.node_id) {
+            remember_owner(room_id, current->id);
+            return current->url;
+        }
+    }
+    return std::nullopt;
+}
+
+bool RoomRegistry::try_claim(const std::string& room_id) {
+    if (!ensure_connected()) return true;  // Redis down — degrade to single-node
+
+    auto reply = redis_.command({"SET", room_key(room_id), cfg_.node_id, "NX", "EX",
+                                 std::to_string(cfg_.ttl_seconds)});
+    if (!reply) return true;
+    if (reply->type == RedisReply::Type::STATUS) return true;
+
+    // Already held — fine if it's us
+    auto current = redis_.command({"GET", room_key(room_id)});
+    return current && current->type == RedisReply::Type::STRING && current->str == cfg_.node_id;
+}
+
+} // namespace storage
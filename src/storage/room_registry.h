@@ -0,0 +1,150 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "storage/redis_client.h"
+
+namespace storage {
+
+// A gameserver process registered in Redis
+struct NodeInfo {
+    std::string id;
+    std::string url;    // public ws(s):// base URL clients are redirected to
+    double load = 0.0;  // 0 = idle, 1 = at capacity
+};
+
+struct RegistryConfig {
+    std::string host = "localhost";
+    int port = 6379;
+    std::string password;
+    std::string node_id;
+    std::string public_url;
+    int ttl_seconds = 10;
+    std::size_t max_queue = 4096;  // lookups waiting for the registry thread
+};
+
+// Cluster-wide room ownership, kept in Redis so several gameserver
+// processes can share one room namespace:
+//
+//   node:{id}     → {"url":...,"rooms":N,"players":M}   (EX ttl, heartbeat)
+//   nodes:load    → ZSET id → load
+//   room:{code}   → owning node id                      (EX ttl, heartbeat)
+//
+// A node whose heartbeat key has expired is dead: it is dropped from
+// nodes:load and its rooms become claimable once their keys lapse.
+//
+// Redis is only touched from the registry's own thread, on its own
+// connection; the loop never waits on it. Calls queue work and return.
+// Lookups answer through a callback on the registry thread (hand the
+// result back with uWS::Loop::defer). Each heartbeat refreshes a cache of
+// live nodes, and owners found by lookups are kept for a heartbeat
+// interval, so the loop can send a client on to a known owner without a
+// round trip. While Redis is unreachable reconnects back off, and rooms
+// are served locally (single-node).
+class RoomRegistry {
+public:
+    explicit RoomRegistry(RegistryConfig cfg);
+    ~RoomRegistry();  // drops queued work
+
+    RoomRegistry(const RoomRegistry&) = delete;
+    RoomRegistry& operator=(const RoomRegistry&) = delete;
+
+    const std::string& node_id() const { return cfg_.node_id; }
+    int heartbeat_interval_seconds() const { return std::max(1, cfg_.ttl_seconds / 3); }
+
+    // Refresh this node's liveness, load and room leases; reap dead nodes.
+    // Only the latest state is sent if the registry thread falls behind.
+    // A lease is only extended while this node holds it, and re-taken once
+    // it has lapsed; a room another node claimed meanwhile is reported (log,
+    // lease_conflicts) rather than taken back.
+    void heartbeat(std::vector<std::string> local_rooms, int players, double load);
+
+    // Hot restart: the next heartbeat also takes over leases still held by
+    // the predecessor's node id
+    void adopt(std::string previous_node);
+
+    // Where a client for room_id should go: the URL of the live node that
+    // owns it or, unless `redirected`, of a peer meaningfully less loaded
+    // than `load` for a room nobody owns yet. nullopt means serve it here,
+    // and the room is then claimed. False if the queue is full.
+    bool route(std::string room_id, bool redirected, double load,
+               std::function<void(std::optional<std::string> peer_url)> done);
+
+    // Take ownership of a room. Idempotent; false if another live node
+    // holds it. False (without calling done) if the queue is full.
+    bool claim(std::string room_id, std::function<void(bool claimed)> done);
+
+    // Drop ownership of a room (only if we still hold it)
+    void release(std::string room_id);
+
+    // URL of the peer known to own room_id, from the cache; any thread
+    std::optional<std::string> cached_owner(const std::string& room_id) const;
+
+    nlohmann::json to_json() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Heartbeat {
+        std::vector<std::string> rooms;
+        int players = 0;
+        double load = 0.0;
+    };
+
+    struct CachedOwner {
+        std::string node_id;
+        Clock::time_point expires;
+    };
+
+    bool submit(std::function<void()> job);
+    void run();
+
+    // Registry thread only
+    bool ensure_connected();
+    void send_heartbeat(const Heartbeat& hb);
+    std::optional<std::string> resolve(const std::string& room_id, bool redirected, double load);
+    bool try_claim(const std::string& room_id);
+    std::optional<NodeInfo> lookup_node(const std::string& node_id);
+    std::optional<NodeInfo> owner(const std::string& room_id);
+    void remember_owner(const std::string& room_id, const std::string& node_id);
+
+    RegistryConfig cfg_;
+
+    // Registry thread only
+    RedisClient redis_;
+    int backoff_ms_ = 0;
+    Clock::time_point next_connect_{};
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()>> jobs_;    // guarded by mutex_
+    std::optional<Heartbeat> heartbeat_;        // guarded by mutex_
+    std::string predecessor_;                   // guarded by mutex_
+    bool stopping_ = false;                     // guarded by mutex_
+
+    // Written by the registry thread, read by anyone
+    mutable std::mutex cache_mutex_;
+    std::unordered_map<std::string, NodeInfo> nodes_;      // live peers, as of the last heartbeat
+    std::unordered_map<std::string, CachedOwner> owners_;  // rooms on peers
+
+    std::atomic<bool> connected_{false};
+    std::atomic<uint64_t> reconnects_{0};
+    std::atomic<uint64_t> lease_conflicts_{0};  // our rooms leased to another node
+    std::atomic<uint64_t> dropped_{0};   // lookups refused, queue full
+
+    std::thread thread_;
+};
+
+} // namespace storage
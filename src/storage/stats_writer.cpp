@@ -0,0 +1,184 @@
+#include "storage/stats_writer.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace storage {
+
+namespace {
+
+// Players per pipelined round trip (a handful of commands each)
+constexpr std::size_t PLAYERS_PER_PIPELINE = 256;
+// Reconnect attempts back off up to this while Redis is down
+constexpr int MAX_BACKOFF_MS = 30'000;
+
+} // namespace
+
+StatsWriter::StatsWriter(StatsConfig cfg)
+    : cfg_(std::move(cfg)), queue_(cfg_.queue_size) {
+    thread_ = std::thread([this] { run(); });
+}
+
+StatsWriter::~StatsWriter() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+bool StatsWriter::record(std::string_view player_id, Stat stat, int64_t value) {
+    if (player_id.empty() || player_id.size() > MAX_ID || value == 0) return false;
+
+    Delta d;
+    std::memcpy(d.id.data(), player_id.data(), player_id.size());
+    d.id_len = static_cast<uint8_t>(player_id.size());
+    d.stat = stat;
+    d.value = value;
+    if (!queue_.try_push(d)) {
+        dropped_queue_full_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void StatsWriter::run() {
+    if (redis_.connect(cfg_.host, cfg_.port, cfg_.password)) {
+        connected_.store(true, std::memory_order_relaxed);
+    }
+
+    auto next_flush = std::chrono::steady_clock::now();
+    for (;;) {
+        // Drain often so the queue stays short; flush on the interval
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait_for(lock, std::chrono::milliseconds(std::min(cfg_.flush_ms, 100)),
+                           [this] { return stopping_; });
+            stop = stopping_;
+        }
+        drain();
+
+        auto now = std::chrono::steady_clock::now();
+        if (stop || now >= next_flush) {
+            bool ok = flush();
+            backoff_ms_ = ok ? 0 : std::clamp(backoff_ms_ * 2, cfg_.flush_ms, MAX_BACKOFF_MS);
+            next_flush = now + std::chrono::milliseconds(ok ? cfg_.flush_ms : backoff_ms_);
+        }
+        if (stop) break;
+    }
+
+    if (!pending_.empty()) {
+        logger::warn("stats: " + std::to_string(pending_.size()) + " players' stats not written at shutdown");
+    }
+}
+
+void StatsWriter::drain() {
+    Delta d;
+    uint64_t n = 0;
+    while (queue_.try_pop(d)) {
+        n++;
+        std::string id(d.id.data(), d.id_len);
+        auto it = pending_.find(id);
+        if (it == pending_.end()) {
+            if (pending_.size() >= cfg_.max_pending) {
+                dropped_overflow_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            it = pending_.emplace(std::move(id), Totals{}).first;
+        }
+
+        auto i = static_cast<std::size_t>(d.stat);
+        auto& v = it->second.value[i];
+        v = d.stat == Stat::BEST_MATCH_GOLD ? std::max(v, d.value) : v + d.value;
+        it->second.touched |= static_cast<uint8_t>(1u << i);
+    }
+    pending_players_.store(pending_.size(), std::memory_order_relaxed);
+    drained_.fetch_add(n, std::memory_order_release);
+}
+
+void StatsWriter::append_commands(const std::string& id, const Totals& t,
+                                  std::vector<std::vector<std::string>>& cmds) const {
+    std::string hash = "player:" + id + ":stats";
+    for (std::size_t i = 0; i < t.value.size(); ++i) {
+        if (!(t.touched & (1u << i))) continue;
+        auto stat = static_cast<Stat>(i);
+        auto value = std::to_string(t.value[i]);
+
+        if (stat == Stat::BEST_MATCH_GOLD) {
+            cmds.push_back({"ZADD", "leaderboard:best_match_gold", "GT", value, id});
+            continue;
+        }
+        cmds.push_back({"HINCRBY", hash, std::string(stat_name(stat)), value});
+        if (stat == Stat::GOLD_EARNED) {
+            cmds.push_back({"ZINCRBY", "leaderboard:gold", value, id});
+        }
+    }
+}
+
+bool StatsWriter::flush() {
+    if (pending_.empty()) return true;
+    if (!redis_.is_connected()) {
+        if (!redis_.reconnect()) {
+            connected_.store(false, std::memory_order_relaxed);
+            flush_failures_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        logger::info("stats: reconnected to Redis, writing " + std::to_string(pending_.size()) + " players");
+    }
+    connected_.store(true, std::memory_order_relaxed);
+
+    std::vector<std::vector<std::string>> cmds;
+    auto it = pending_.begin();
+    while (it != pending_.end()) {
+        cmds.clear();
+        auto end = it;
+        for (std::size_t n = 0; end != pending_.end() && n < PLAYERS_PER_PIPELINE; ++end, ++n) {
+            append_commands(end->first, end->second, cmds);
+        }
+
+        auto ok = redis_.pipeline(cmds);
+        if (!redis_.is_connected()) {
+            // Cut off mid-batch: keep it and everything after for the retry
+            connected_.store(false, std::memory_order_relaxed);
+            flush_failures_.fetch_add(1, std::memory_order_relaxed);
+            pending_players_.store(pending_.size(), std::memory_order_relaxed);
+            return false;
+        }
+        commands_sent_.fetch_add(ok, std::memory_order_relaxed);
+        // Error replies (wrong type, ZADD GT before Redis 6.2) won't succeed on retry
+        command_errors_.fetch_add(cmds.size() - ok, std::memory_order_relaxed);
+        it = pending_.erase(it, end);
+    }
+    pending_players_.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+std::size_t StatsWriter::memory_bytes() const {
+    // pending_ belongs to the writer thread; size it from the published count
+    using Node = std::unordered_map<std::string, Totals>::value_type;
+    auto players = pending_players_.load(std::memory_order_relaxed);
+    return queue_.memory_bytes() + players * (sizeof(Node) + 2 * sizeof(void*));
+}
+
+nlohmann::json StatsWriter::to_json() const {
+    auto get = [](const auto& a) { return a.load(std::memory_order_relaxed); };
+    return {
+        {"connected", get(connected_)},
+        {"recorded", get(recorded_)},
+        {"drained", drained_.load(std::memory_order_acquire)},
+        {"queued", queue_.size()},
+        {"pending_players", get(pending_players_)},
+        {"commands_sent", get(commands_sent_)},
+        {"command_errors", get(command_errors_)},
+        {"flush_failures", get(flush_failures_)},
+        {"dropped_queue_full", get(dropped_queue_full_)},
+        {"dropped_overflow", get(dropped_overflow_)}
+    };
+}
+
+} // namespace storage
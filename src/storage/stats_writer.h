@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "storage/redis_client.h"
+#include "utils/mpmc_queue.h"
+
+namespace storage {
+
+// What a delta adds to. Counters go to the player's hash; GOLD_EARNED also
+// feeds the lifetime leaderboard, BEST_MATCH_GOLD keeps the maximum.
+//
+//   player:{id}:stats              → HASH  gold_earned, damage_taken, ... (HINCRBY)
+//   leaderboard:gold               → ZSET  id → lifetime gold             (ZINCRBY)
+//   leaderboard:best_match_gold    → ZSET  id → best single match         (ZADD GT)
+enum class Stat : uint8_t {
+    GOLD_EARNED,
+    DAMAGE_TAKEN,
+    ENEMIES_KILLED,
+    DEATHS,
+    MATCHES_PLAYED,
+    BEST_MATCH_GOLD,
+    COUNT
+};
+
+inline constexpr std::string_view stat_name(Stat s) {
+    switch (s) {
+        case Stat::GOLD_EARNED:     return "gold_earned";
+        case Stat::DAMAGE_TAKEN:    return "damage_taken";
+        case Stat::ENEMIES_KILLED:  return "enemies_killed";
+        case Stat::DEATHS:          return "deaths";
+        case Stat::MATCHES_PLAYED:  return "matches_played";
+        case Stat::BEST_MATCH_GOLD: return "best_match_gold";
+        default:                    return "unknown";
+    }
+}
+
+struct StatsConfig {
+    std::string host = "localhost";
+    int port = 6379;
+    std::string password;
+    int flush_ms = 1000;
+    std::size_t queue_size = 65536;     // deltas in flight between the game and the writer
+    std::size_t max_pending = 100000;   // players aggregated while Redis is unreachable
+};
+
+// Write-behind player stats. Game threads (the loop and the simulation
+// workers) record() deltas into a lock-free queue; a background thread
+// drains it, sums deltas per player and every flush_ms sends the totals as
+// one pipelined batch of HINCRBY / ZINCRBY / ZADD — a tick never waits on
+// Redis.
+//
+// During an outage totals keep accumulating, bounded by max_pending players
+// (deltas for further players are dropped and counted) and retried with
+// backoff. A batch cut off mid-pipeline is resent whole, so after a
+// connection loss a delta may be applied twice: at-least-once.
+class StatsWriter {
+public:
+    static constexpr std::size_t MAX_ID = 64;  // longer player ids are refused
+
+    explicit StatsWriter(StatsConfig cfg);
+    ~StatsWriter();  // stops the writer after a last flush attempt
+
+    StatsWriter(const StatsWriter&) = delete;
+    StatsWriter& operator=(const StatsWriter&) = delete;
+
+    // Any thread, never blocks; false if the delta was dropped (queue full)
+    bool record(std::string_view player_id, Stat stat, int64_t value);
+
+    nlohmann::json to_json() const;
+
+    // The queue plus an estimate of the per-player totals awaiting a flush
+    std::size_t memory_bytes() const;
+
+private:
+    // Fixed-size so the queue never allocates
+    struct Delta {
+        std::array<char, MAX_ID> id;
+        uint8_t id_len;
+        Stat stat;
+        int64_t value;
+    };
+
+    struct Totals {
+        std::array<int64_t, static_cast<std::size_t>(Stat::COUNT)> value{};
+        uint8_t touched = 0;  // bit per Stat
+    };
+
+    void run();
+    void drain();
+    bool flush();
+    void append_commands(const std::string& id, const Totals& t,
+                         std::vector<std::vector<std::string>>& cmds) const;
+
+    StatsConfig cfg_;
+    utils::MpmcQueue<Delta> queue_;
+
+    // Writer thread only
+    RedisClient redis_;
+    std::unordered_map<std::string, Totals> pending_;
+    int backoff_ms_ = 0;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;               // guarded by wake_mutex_
+    std::thread thread_;
+
+    // Counters for /metrics
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> drained_{0};      // taken off the queue into pending_
+    std::atomic<uint64_t> dropped_queue_full_{0};
+    std::atomic<uint64_t> dropped_overflow_{0};
+    std::atomic<uint64_t> commands_sent_{0};
+    std::atomic<uint64_t> command_errors_{0};
+    std::atomic<uint64_t> flush_failures_{0};
+    std::atomic<std::size_t> pending_players_{0};
+    std::atomic<bool> connected_{false};
+};
+
+} // namespace storage
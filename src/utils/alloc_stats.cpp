@@ -0,0 +1,37 @@
+#include "utils/alloc_stats.h"
+
+#ifdef WOMBO_ALLOC_STATS
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local alloc_stats::Counters tl_counters;
+
+void* counted_alloc(std::size_t size) {
+    tl_counters.allocations++;
+    tl_counters.bytes += size;
+    if (size == 0) size = 1;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void counted_free(void* p) noexcept {
+    if (!p) return;
+    tl_counters.deallocations++;
+    std::free(p);
+}
+} // namespace
+
+namespace alloc_stats {
+Counters thread_counters() { return tl_counters; }
+} // namespace alloc_stats
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+
+#endif // WOMBO_ALLOC_STATS
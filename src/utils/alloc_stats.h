@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+namespace alloc_stats {
+
+// Heap allocation counters for the calling thread.
+// Only live when built with -DENABLE_ALLOC_STATS=ON (which replaces the global
+// operator new/delete); otherwise every counter reads zero.
+struct Counters {
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes = 0;
+};
+
+#ifdef WOMBO_ALLOC_STATS
+constexpr bool enabled = true;
+Counters thread_counters();
+#else
+constexpr bool enabled = false;
+inline Counters thread_counters() { return {}; }
+#endif
+
+// Measures allocations made by the current thread within a scope
+class Scope {
+public:
+    Scope() : start_(thread_counters()) {}
+
+    uint64_t allocations() const { return thread_counters().allocations - start_.allocations; }
+    uint64_t bytes() const { return thread_counters().bytes - start_.bytes; }
+
+private:
+    Counters start_;
+};
+
+} // namespace alloc_stats
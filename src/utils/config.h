@@ -1,7 +1,10 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdlib>
+#include <algorithm>
+#include <thread>
 
 namespace config {
 
@@ -15,6 +18,94 @@ struct ServerConfig {
     std::string redis_password;
     std::string log_level = "info";
 
+    // Multi-node (Redis room registry)
+    bool cluster_enabled = false;
+    std::string node_id;        // defaults to hostname-pid
+    std::string public_url;     // defaults to ws://localhost:{port}
+    int node_ttl = 10;          // seconds before a silent node is considered dead
+
+    // Handshake admission (token buckets, connections per second)
+    double admit_per_ip_rate = 5.0;
+    double admit_per_ip_burst = 20.0;
+    double admit_global_rate = 500.0;
+    double admit_global_burst = 1000.0;
+
+    // Spectators (/spectate/{room}): snapshots per second, how far behind
+    // the players they run, and how many may watch one room
+    int spectator_rate = 5;
+    int spectator_delay_ms = 2000;
+    int max_spectators_per_room = 10000;
+
+    // Per-connection inbound rate limits (messages/s per class, bytes/s) and
+    // what happens to a client over them: INBOUND_POLICY is "drop" (silently),
+    // "throttle" (drop, with a 429 error at most once a second) or
+    // "disconnect" (throttle, then close after inbound_strikes violations
+    // within 10 s)
+    double inbound_rate_input = 60.0;
+    double inbound_rate_chat = 2.0;
+    double inbound_rate_control = 10.0;
+    double inbound_rate_action = 10.0;
+    double inbound_rate_other = 5.0;
+    double inbound_bytes_per_sec = 32768.0;
+    std::string inbound_policy = "throttle";
+    int inbound_strikes = 20;
+
+    // Write-behind player stats to Redis (opt in with STATS_ENABLED=1):
+    // flush interval, queue between the game and the writer thread, and how
+    // many players' totals are held while Redis is unreachable
+    bool stats_enabled = false;
+    int stats_flush_ms = 1000;
+    int stats_queue_size = 65536;
+    int stats_max_pending = 100000;
+
+    // Threads verifying JWTs off the event loop
+    int crypto_threads = 2;
+
+    // Helper threads simulating rooms alongside the loop thread each tick
+    // (0 = serial on the loop thread, -1 = one per remaining core)
+    int sim_threads = 0;
+
+    // Zero-downtime restart control socket (empty = disabled)
+    std::string hot_restart_socket;
+
+    // Tick budget (percent of the tick interval) and what to give up when
+    // the loop runs over it: OVERLOAD_POLICY is a comma list of
+    // "throttle" (fewer snapshots from expensive rooms) and "reject" (no new
+    // rooms), or "none"
+    int tick_budget_pct = 80;
+    bool overload_throttle_snapshots = true;
+    bool overload_reject_rooms = true;
+    int max_snapshot_stride = 4;
+
+    // Where SIGUSR1 trace dumps go (ENABLE_TRACE builds)
+    std::string trace_dir = "/tmp";
+
+    // Compiled tilemaps (<maps_dir>/<map_name>.wmap); empty name = built-in arena
+    std::string maps_dir = "maps";
+    std::string map_name;
+
+    // Mode of rooms created without ?mode= ("snapshot" or "lockstep"), and
+    // ticks between lockstep CHECKSUM frames
+    bool lockstep_rooms = false;
+    int lockstep_checksum_ticks = 20;
+
+    // How many ticks back a late player_input may still be applied where it
+    // belongs (snapshot rooms; 0 = apply late inputs at the next tick)
+    int rollback_ticks = 0;
+
+    // UDP snapshot channel for clients connecting with ?udp=1 (0 = off), and
+    // how long a client may stay silent before it falls back to the WebSocket
+    int udp_port = 0;
+    int udp_timeout_ms = 2000;
+
+    // In-process TLS (wss://, ENABLE_TLS builds) when a certificate is set,
+    // with session resumption for reconnect storms: see server/tls.h
+    std::string tls_cert_file;
+    std::string tls_key_file;
+    std::string tls_ticket_key_file;
+    int tls_session_cache = 20480;     // session-ID cache entries
+    int tls_session_lifetime_s = 3600;
+
     static ServerConfig from_env() {
         ServerConfig cfg;
 
@@ -41,6 +132,100 @@ struct ServerConfig {
             cfg.redis_password = v;
         if (auto* v = std::getenv("LOG_LEVEL"))
             cfg.log_level = v;
+        if (auto* v = std::getenv("CLUSTER_ENABLED"))
+            cfg.cluster_enabled = std::string(v) == "1" || std::string(v) == "true";
+        if (auto* v = std::getenv("NODE_ID"))
+            cfg.node_id = v;
+        if (auto* v = std::getenv("PUBLIC_URL"))
+            cfg.public_url = v;
+        if (auto* v = std::getenv("NODE_TTL"))
+            cfg.node_ttl = std::stoi(v);
+
+        if (auto* v = std::getenv("ADMIT_PER_IP_RATE"))
+            cfg.admit_per_ip_rate = std::stod(v);
+        if (auto* v = std::getenv("ADMIT_PER_IP_BURST"))
+            cfg.admit_per_ip_burst = std::stod(v);
+        if (auto* v = std::getenv("ADMIT_GLOBAL_RATE"))
+            cfg.admit_global_rate = std::stod(v);
+        if (auto* v = std::getenv("ADMIT_GLOBAL_BURST"))
+            cfg.admit_global_burst = std::stod(v);
+        if (auto* v = std::getenv("SPECTATOR_RATE"))
+            cfg.spectator_rate = std::max(1, std::stoi(v));
+        if (auto* v = std::getenv("SPECTATOR_DELAY_MS"))
+            cfg.spectator_delay_ms = std::max(0, std::stoi(v));
+        if (auto* v = std::getenv("MAX_SPECTATORS_PER_ROOM"))
+            cfg.max_spectators_per_room = std::max(0, std::stoi(v));
+        if (auto* v = std::getenv("INBOUND_RATE_INPUT"))
+            cfg.inbound_rate_input = std::stod(v);
+        if (auto* v = std::getenv("INBOUND_RATE_CHAT"))
+            cfg.inbound_rate_chat = std::stod(v);
+        if (auto* v = std::getenv("INBOUND_RATE_CONTROL"))
+            cfg.inbound_rate_control = std::stod(v);
+        if (auto* v = std::getenv("INBOUND_RATE_ACTION"))
+            cfg.inbound_rate_action = std::stod(v);
+        if (auto* v = std::getenv("INBOUND_RATE_OTHER"))
+            cfg.inbound_rate_other = std::stod(v);
+        if (auto* v = std::getenv("INBOUND_BYTES_PER_SEC"))
+            cfg.inbound_bytes_per_sec = std::stod(v);
+        if (auto* v = std::getenv("INBOUND_POLICY"))
+            cfg.inbound_policy = v;
+        if (auto* v = std::getenv("INBOUND_STRIKES"))
+            cfg.inbound_strikes = std::max(1, std::stoi(v));
+        if (auto* v = std::getenv("STATS_ENABLED"))
+            cfg.stats_enabled = std::string(v) == "1" || std::string(v) == "true";
+        if (auto* v = std::getenv("STATS_FLUSH_MS"))
+            cfg.stats_flush_ms = std::max(10, std::stoi(v));
+        if (auto* v = std::getenv("STATS_QUEUE_SIZE"))
+            cfg.stats_queue_size = std::max(1024, std::stoi(v));
+        if (auto* v = std::getenv("STATS_MAX_PENDING"))
+            cfg.stats_max_pending = std::max(1, std::stoi(v));
+        if (auto* v = std::getenv("CRYPTO_THREADS"))
+            cfg.crypto_threads = std::max(1, std::stoi(v));
+        if (auto* v = std::getenv("SIM_THREADS"))
+            cfg.sim_threads = std::stoi(v);
+        if (auto* v = std::getenv("HOT_RESTART_SOCKET"))
+            cfg.hot_restart_socket = v;
+        if (auto* v = std::getenv("TICK_BUDGET_PCT"))
+            cfg.tick_budget_pct = std::clamp(std::stoi(v), 10, 100);
+        if (auto* v = std::getenv("OVERLOAD_POLICY")) {
+            std::string policy = v;
+            cfg.overload_throttle_snapshots = policy.find("throttle") != std::string::npos;
+            cfg.overload_reject_rooms = policy.find("reject") != std::string::npos;
+        }
+        if (auto* v = std::getenv("MAX_SNAPSHOT_STRIDE"))
+            cfg.max_snapshot_stride = std::max(1, std::stoi(v));
+        if (auto* v = std::getenv("TRACE_DIR"))
+            cfg.trace_dir = v;
+        if (auto* v = std::getenv("MAPS_DIR"))
+            cfg.maps_dir = v;
+        if (auto* v = std::getenv("MAP_NAME"))
+            cfg.map_name = v;
+        if (auto* v = std::getenv("ROOM_MODE"))
+            cfg.lockstep_rooms = std::string_view(v) == "lockstep";
+        if (auto* v = std::getenv("LOCKSTEP_CHECKSUM_TICKS"))
+            cfg.lockstep_checksum_ticks = std::max(1, std::stoi(v));
+        if (auto* v = std::getenv("ROLLBACK_TICKS"))
+            cfg.rollback_ticks = std::clamp(std::stoi(v), 0, 15);
+        if (auto* v = std::getenv("UDP_PORT"))
+            cfg.udp_port = std::stoi(v);
+        if (auto* v = std::getenv("UDP_TIMEOUT_MS"))
+            cfg.udp_timeout_ms = std::max(100, std::stoi(v));
+        if (auto* v = std::getenv("TLS_CERT_FILE"))
+            cfg.tls_cert_file = v;
+        if (auto* v = std::getenv("TLS_KEY_FILE"))
+            cfg.tls_key_file = v;
+        if (auto* v = std::getenv("TLS_TICKET_KEY_FILE"))
+            cfg.tls_ticket_key_file = v;
+        if (auto* v = std::getenv("TLS_SESSION_CACHE"))
+            cfg.tls_session_cache = std::max(0, std::stoi(v));
+        if (auto* v = std::getenv("TLS_SESSION_LIFETIME"))
+            cfg.tls_session_lifetime_s = std::max(1, std::stoi(v));
+
+        if (cfg.sim_threads < 0)
+            cfg.sim_threads = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+        if (cfg.public_url.empty())
+            cfg.public_url = "ws://localhost:" + std::to_string(cfg.port);
 
         return cfg;
     }
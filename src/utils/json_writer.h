@@ -0,0 +1,210 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <charconv>
+#include <nlohmann/json.hpp>
+
+namespace utils {
+
+// Appends JSON straight into a caller-owned buffer — no DOM, no temporaries.
+// The caller is responsible for structure (braces, commas, keys); hot paths
+// pass pre-built key fragments through raw(). Output is byte-compatible with
+// nlohmann::json::dump() for the value types written here
+// (tests/snapshot_golden checks it).
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    JsonWriter& raw(std::string_view s) {
+        out_.append(s);
+        return *this;
+    }
+
+    JsonWriter& raw(char c) {
+        out_.push_back(c);
+        return *this;
+    }
+
+    // Quoted string, escaped the same way nlohmann does (ensure_ascii=false).
+    // Invalid UTF-8 (player names come straight off the upgrade URL) becomes
+    // U+FFFD per bad sequence, as dump() does with error_handler_t::replace;
+    // a plain dump() would throw on it.
+    JsonWriter& string(std::string_view s) {
+        out_.push_back('"');
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < s.size();) {
+            auto c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x80) {
+                std::size_t n = utf8_sequence(s, i);
+                if (n > 0) {
+                    i += n;
+                    continue;
+                }
+                std::size_t bad = utf8_invalid_prefix(s, i);
+                out_.append(s.data() + run, i - run);
+                out_.append("\xEF\xBF\xBD");
+                i += bad;
+                run = i;
+                continue;
+            }
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                ++i;
+                continue;
+            }
+            out_.append(s.data() + run, i - run);
+            run = ++i;
+            switch (c) {
+                case '"':  out_.append("\\\""); break;
+                case '\\': out_.append("\\\\"); break;
+                case '\b': out_.append("\\b"); break;
+                case '\f': out_.append("\\f"); break;
+                case '\n': out_.append("\\n"); break;
+                case '\r': out_.append("\\r"); break;
+                case '\t': out_.append("\\t"); break;
+                default: {
+                    static constexpr char hex[] = "0123456789abcdef";
+                    char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out_.append(esc, sizeof(esc));
+                }
+            }
+        }
+        out_.append(s.data() + run, s.size() - run);
+        out_.push_back('"');
+        return *this;
+    }
+
+    JsonWriter& integer(int64_t v) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.append(buf, res.ptr);
+        return *this;
+    }
+
+    JsonWriter& boolean(bool v) {
+        out_.append(v ? "true" : "false");
+        return *this;
+    }
+
+    // Float rounded to 0.1 precision — the same value as std::round(v * 10) / 10
+    JsonWriter& rounded(float v);
+
+    // Any float, formatted as nlohmann would
+    JsonWriter& number(float v) {
+        out_.append(nlohmann::json(v).dump());
+        return *this;
+    }
+
+    JsonWriter& number(double v) {
+        out_.append(nlohmann::json(v).dump());
+        return *this;
+    }
+
+    std::string& buffer() { return out_; }
+
+    // Builds the rounded-float lookup table up front so the first tick doesn't pay for it
+    static void warm_up();
+
+private:
+    // Second-byte range for a lead byte; the bytes after it are 80..BF.
+    // Excludes overlong forms, surrogates and code points past U+10FFFF.
+    struct Utf8Lead {
+        uint8_t length = 0;  // 0: not a lead byte
+        uint8_t lo = 0x80, hi = 0xBF;
+    };
+
+    static Utf8Lead utf8_lead(unsigned char c) {
+        if (c >= 0xC2 && c <= 0xDF) return {2};
+        if (c == 0xE0) return {3, 0xA0, 0xBF};
+        if (c == 0xED) return {3, 0x80, 0x9F};
+        if (c >= 0xE1 && c <= 0xEF) return {3};
+        if (c == 0xF0) return {4, 0x90, 0xBF};
+        if (c >= 0xF1 && c <= 0xF3) return {4};
+        if (c == 0xF4) return {4, 0x80, 0x8F};
+        return {};
+    }
+
+    // How many bytes of s[i..] are valid continuations of the lead at s[i]
+    static std::size_t utf8_valid_bytes(std::string_view s, std::size_t i, Utf8Lead lead) {
+        std::size_t n = 1;
+        for (; n < lead.length && i + n < s.size(); ++n) {
+            auto b = static_cast<unsigned char>(s[i + n]);
+            if (n == 1 ? b < lead.lo || b > lead.hi : b < 0x80 || b > 0xBF) break;
+        }
+        return n;
+    }
+
+    // Length of the well-formed multi-byte sequence at s[i], or 0
+    static std::size_t utf8_sequence(std::string_view s, std::size_t i) {
+        Utf8Lead lead = utf8_lead(static_cast<unsigned char>(s[i]));
+        if (lead.length == 0) return 0;
+        return utf8_valid_bytes(s, i, lead) == lead.length ? lead.length : 0;
+    }
+
+    // Bytes one U+FFFD replaces: the lead and the continuations that fit it.
+    // The byte that broke the sequence starts the next one.
+    static std::size_t utf8_invalid_prefix(std::string_view s, std::size_t i) {
+        Utf8Lead lead = utf8_lead(static_cast<unsigned char>(s[i]));
+        return lead.length == 0 ? 1 : utf8_valid_bytes(s, i, lead);
+    }
+
+    std::string& out_;
+};
+
+namespace detail {
+
+// nlohmann formats doubles with Grisu2, which picks a different (equally
+// round-trippable) last digit than std::to_chars for a few percent of
+// float-derived values. To stay byte-compatible without a DOM, the text for
+// every 0.1-step value in [-RANGE, RANGE] is generated once and looked up by
+// its tenth count; anything outside falls back to nlohmann's formatter.
+class RoundedFloatTable {
+public:
+    static constexpr int RANGE_TENTHS = 20480;  // ±2048.0
+
+    static const RoundedFloatTable& instance() {
+        static const RoundedFloatTable table;
+        return table;
+    }
+
+    // tenths = std::round(v * 10), as an integer
+    std::string_view lookup(int tenths) const {
+        auto idx = static_cast<std::size_t>(tenths + RANGE_TENTHS);
+        return std::string_view(blob_).substr(offsets_[idx], offsets_[idx + 1] - offsets_[idx]);
+    }
+
+private:
+    RoundedFloatTable() {
+        offsets_.reserve(2 * RANGE_TENTHS + 2);
+        offsets_.push_back(0);
+        for (int t = -RANGE_TENTHS; t <= RANGE_TENTHS; ++t) {
+            blob_ += nlohmann::json(static_cast<float>(t) / 10.0f).dump();
+            offsets_.push_back(static_cast<uint32_t>(blob_.size()));
+        }
+    }
+
+    std::string blob_;
+    std::vector<uint32_t> offsets_;
+};
+
+} // namespace detail
+
+inline JsonWriter& JsonWriter::rounded(float v) {
+    float r = std::round(v * 10.0f);
+    if (r == 0.0f) {
+        return raw(std::signbit(r) ? "-0.0" : "0.0");
+    }
+    if (std::abs(r) <= static_cast<float>(detail::RoundedFloatTable::RANGE_TENTHS)) {
+        return raw(detail::RoundedFloatTable::instance().lookup(static_cast<int>(r)));
+    }
+    return number(r / 10.0f);
+}
+
+inline void JsonWriter::warm_up() {
+    detail::RoundedFloatTable::instance();
+}
+
+} // namespace utils
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace memory {
+
+// Estimates of the heap held behind standard containers, for /memory.
+// They count what the container asked for, not allocator overhead, so they
+// read a little under the truth; rss_bytes() is the number to compare with.
+
+// 0 while the string fits its inline buffer
+inline std::size_t heap_bytes(const std::string& s) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+}
+
+template <typename T, typename A>
+std::size_t heap_bytes(const std::vector<T, A>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// Bucket array plus one node per element (value, next pointer, cached hash)
+template <typename Map>
+std::size_t hash_map_bytes(const Map& m) {
+    return m.bucket_count() * sizeof(void*)
+         + m.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*));
+}
+
+// Red-black tree node: value, three links and the colour
+template <typename Map>
+std::size_t tree_map_bytes(const Map& m) {
+    return m.size() * (sizeof(typename Map::value_type) + 4 * sizeof(void*));
+}
+
+// Resident set of the whole process; 0 where /proc is unavailable
+inline std::size_t rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size = 0, resident = 0;
+    if (!(statm >> size >> resident)) return 0;
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+} // namespace memory
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+// Fixed-size object pool with an intrusive free list.
+// Slots are allocated in chunks and never returned to the heap, so once the
+// pool has grown to its working set, acquire/release are allocation-free.
+// Not thread-safe — owned and used by the loop thread.
+template <typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(std::size_t chunk_size = 16) : chunk_size_(chunk_size) {}
+
+    ~ObjectPool() = default;  // Live objects must be released before the pool dies
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // Pre-allocate slots for at least n objects
+    void reserve(std::size_t n) {
+        while (capacity_ < n) grow();
+    }
+
+    template <typename... Args>
+    T* acquire(Args&&... args) {
+        if (!free_) grow();
+        Slot* slot = free_;
+        free_ = slot->next;
+        T* obj = ::new (static_cast<void*>(slot->storage)) T(std::forward<Args>(args)...);
+        ++in_use_;
+        return obj;
+    }
+
+    void release(T* obj) {
+        if (!obj) return;
+        obj->~T();
+        auto* slot = reinterpret_cast<Slot*>(obj);
+        slot->next = free_;
+        free_ = slot;
+        --in_use_;
+    }
+
+    std::size_t in_use() const { return in_use_; }
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    void grow() {
+        auto chunk = std::make_unique<Slot[]>(chunk_size_);
+        for (std::size_t i = 0; i < chunk_size_; ++i) {
+            chunk[i].next = free_;
+            free_ = &chunk[i];
+        }
+        chunks_.push_back(std::move(chunk));
+        capacity_ += chunk_size_;
+    }
+
+    std::size_t chunk_size_;
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    Slot* free_ = nullptr;
+    std::size_t in_use_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+// unique_ptr deleter that hands the object back to its pool
+template <typename T>
+struct PoolDeleter {
+    ObjectPool<T>* pool = nullptr;
+    void operator()(T* obj) const { if (pool) pool->release(obj); }
+};
+
+template <typename T>
+using PooledPtr = std::unique_ptr<T, PoolDeleter<T>>;
+
+} // namespace utils
@@ -0,0 +1,236 @@
+#include "utils/trace.h"
+
+#include <atomic>
+#include <csignal>
+#include <fstream>
+
+#ifdef WOMBO_TRACE
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#endif
+
+namespace trace {
+
+namespace {
+volatile std::sig_atomic_t dump_flag = 0;
+
+extern "C" void on_dump_signal(int) { dump_flag = 1; }
+} // namespace
+
+void install_dump_signal() {
+    struct sigaction sa{};
+    sa.sa_handler = on_dump_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, nullptr);
+}
+
+bool dump_requested() {
+    if (!dump_flag) return false;
+    dump_flag = 0;
+    return true;
+}
+
+bool write_chrome_json(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out << chrome_json();
+    return static_cast<bool>(out);
+}
+
+#ifdef WOMBO_TRACE
+
+namespace {
+
+// Per thread; ~1.3 MB each, a few seconds of a busy loop thread
+constexpr std::size_t CAPACITY = 1 << 15;
+constexpr std::size_t MASK = CAPACITY - 1;
+
+// Fields are relaxed atomics so a dump can read a ring while its thread keeps
+// writing; entries overwritten mid-copy are discarded afterwards (see collect)
+struct Event {
+    std::atomic<const char*> category{nullptr};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> dur_ns{0};
+    std::atomic<int64_t> arg{Scope::NO_ARG};
+};
+
+struct Snapshot {
+    const char* category;
+    const char* name;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    int64_t arg;
+};
+
+constexpr uint64_t INSTANT = UINT64_MAX;  // dur_ns marker
+
+struct ThreadBuffer {
+    int tid = 0;
+    std::string name;                         // guarded by registry mutex
+    std::atomic<uint64_t> head{0};            // events ever written
+    std::unique_ptr<Event[]> events = std::make_unique<Event[]>(CAPACITY);
+
+    void push(const char* category, const char* name_, uint64_t start, uint64_t dur, int64_t arg) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        // Orders the previous head store before these writes, for collect()
+        std::atomic_thread_fence(std::memory_order_release);
+        Event& e = events[h & MASK];
+        e.category.store(category, std::memory_order_relaxed);
+        e.name.store(name_, std::memory_order_relaxed);
+        e.start_ns.store(start, std::memory_order_relaxed);
+        e.dur_ns.store(dur, std::memory_order_relaxed);
+        e.arg.store(arg, std::memory_order_relaxed);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Copy of what's in the ring, minus anything the writer lapped meanwhile
+    void collect(std::vector<Snapshot>& out) const {
+        uint64_t end = head.load(std::memory_order_acquire);
+        uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+        std::size_t first = out.size();
+        for (uint64_t i = begin; i < end; ++i) {
+            const Event& e = events[i & MASK];
+            out.push_back({e.category.load(std::memory_order_relaxed),
+                           e.name.load(std::memory_order_relaxed),
+                           e.start_ns.load(std::memory_order_relaxed),
+                           e.dur_ns.load(std::memory_order_relaxed),
+                           e.arg.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now = head.load(std::memory_order_relaxed);
+        if (now >= CAPACITY && now - CAPACITY + 1 > begin) {
+            // Slots up to index now - CAPACITY may hold newer, torn data
+            auto lapped = static_cast<std::size_t>(std::min(now - CAPACITY + 1, end) - begin);
+            out.erase(out.begin() + static_cast<std::ptrdiff_t>(first),
+                      out.begin() + static_cast<std::ptrdiff_t>(first + lapped));
+        }
+    }
+};
+
+// Buffers live for the whole process so a dump still shows threads that exited
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+const auto epoch = std::chrono::steady_clock::now();
+
+ThreadBuffer& local_buffer() {
+    thread_local ThreadBuffer* buffer = [] {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto b = std::make_unique<ThreadBuffer>();
+        b->tid = static_cast<int>(reg.buffers.size()) + 1;
+        b->name = "thread-" + std::to_string(b->tid);
+        reg.buffers.push_back(std::move(b));
+        return reg.buffers.back().get();
+    }();
+    return *buffer;
+}
+
+// µs with ns decimals, as the trace-event format expects
+void append_us(std::string& out, uint64_t ns) {
+    out += std::to_string(ns / 1000);
+    uint64_t frac = ns % 1000;
+    if (frac) {
+        char buf[5] = {'.', char('0' + frac / 100), char('0' + frac / 10 % 10), char('0' + frac % 10), 0};
+        out += buf;
+    }
+}
+
+} // namespace
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+void record(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns, int64_t arg) {
+    local_buffer().push(category, name, start_ns, end_ns - start_ns, arg);
+}
+
+void instant(const char* category, const char* name) {
+    local_buffer().push(category, name, now_ns(), INSTANT, Scope::NO_ARG);
+}
+
+void set_thread_name(const char* name) {
+    auto& b = local_buffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    b.name = name;
+}
+
+std::string chrome_json() {
+    std::vector<std::pair<int, std::string>> threads;
+    std::vector<std::pair<int, std::vector<Snapshot>>> events;
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto& b : reg.buffers) {
+            threads.emplace_back(b->tid, b->name);
+            events.emplace_back(b->tid, std::vector<Snapshot>{});
+            events.back().second.reserve(CAPACITY);
+            b->collect(events.back().second);
+        }
+    }
+
+    std::string pid = std::to_string(::getpid());
+    std::string out = R"({"displayTimeUnit":"ms","traceEvents":[)";
+    bool first = true;
+    auto sep = [&] {
+        if (!first) out += ',';
+        first = false;
+    };
+
+    for (const auto& [tid, name] : threads) {
+        sep();
+        out += R"({"ph":"M","name":"thread_name","pid":)" + pid + R"(,"tid":)" + std::to_string(tid)
+             + R"(,"args":{"name":")" + name + R"("}})";
+    }
+    for (const auto& [tid, list] : events) {
+        std::string ids = R"(,"pid":)" + pid + R"(,"tid":)" + std::to_string(tid) + R"(,"ts":)";
+        for (const auto& e : list) {
+            sep();
+            out += R"({"name":")";
+            out += e.name;
+            out += R"(","cat":")";
+            out += e.category;
+            if (e.dur_ns == INSTANT) {
+                out += R"(","ph":"i","s":"t")";
+                out += ids;
+                append_us(out, e.start_ns);
+            } else {
+                out += R"(","ph":"X")";
+                out += ids;
+                append_us(out, e.start_ns);
+                out += R"(,"dur":)";
+                append_us(out, e.dur_ns);
+            }
+            if (e.arg != Scope::NO_ARG) {
+                out += R"(,"args":{"n":)" + std::to_string(e.arg) + "}";
+            }
+            out += '}';
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+#else
+
+std::string chrome_json() {
+    return R"({"displayTimeUnit":"ms","traceEvents":[]})";
+}
+
+#endif // WOMBO_TRACE
+
+} // namespace trace
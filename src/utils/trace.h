@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped timing events for finding where a slow tick went.
+//
+//   TRACE_SCOPE("room", "room.simulate");         // duration of the enclosing scope
+//   TRACE_SCOPE_ARG("net", "ws.flush", sockets);  // same, with one integer arg
+//   TRACE_INSTANT("net", "ws.backpressure_drop");
+//
+// Only live when built with -DENABLE_TRACE=ON; otherwise the macros expand
+// to nothing. Names and categories must be string literals (only the
+// pointer is kept). Each thread writes into its own fixed ring of recent
+// events, without locks; chrome_json() collects every ring into the Chrome
+// trace-event format, which chrome://tracing and ui.perfetto.dev open.
+namespace trace {
+
+#ifdef WOMBO_TRACE
+
+constexpr bool enabled = true;
+
+uint64_t now_ns();
+void record(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns, int64_t arg);
+void instant(const char* category, const char* name);
+
+// Label the calling thread in the trace ("loop", "sim-1", ...)
+void set_thread_name(const char* name);
+
+class Scope {
+public:
+    static constexpr int64_t NO_ARG = INT64_MIN;
+
+    Scope(const char* category, const char* name, int64_t arg = NO_ARG)
+        : category_(category), name_(name), arg_(arg), start_(now_ns()) {}
+    ~Scope() { record(category_, name_, start_, now_ns(), arg_); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    int64_t arg_;
+    uint64_t start_;
+};
+
+#define WOMBO_TRACE_CAT2(a, b) a##b
+#define WOMBO_TRACE_CAT(a, b) WOMBO_TRACE_CAT2(a, b)
+#define TRACE_SCOPE(cat, name) \
+    ::trace::Scope WOMBO_TRACE_CAT(trace_scope_, __LINE__)(cat, name)
+#define TRACE_SCOPE_ARG(cat, name, arg) \
+    ::trace::Scope WOMBO_TRACE_CAT(trace_scope_, __LINE__)(cat, name, static_cast<int64_t>(arg))
+#define TRACE_INSTANT(cat, name) ::trace::instant(cat, name)
+#define TRACE_THREAD_NAME(name) ::trace::set_thread_name(name)
+
+#else
+
+constexpr bool enabled = false;
+
+#define TRACE_SCOPE(cat, name) ((void)0)
+#define TRACE_SCOPE_ARG(cat, name, arg) ((void)0)
+#define TRACE_INSTANT(cat, name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
+
+// Everything still in the per-thread rings as {"traceEvents": [...]}
+// (empty list when tracing is compiled out)
+std::string chrome_json();
+
+// Writes chrome_json() to `path`; false if it couldn't be written
+bool write_chrome_json(const std::string& path);
+
+// SIGUSR1 asks for a dump; the loop polls dump_requested() and writes it
+// outside the signal handler
+void install_dump_signal();
+bool dump_requested();
+
+} // namespace trace
@@ -0,0 +1,472 @@
+// schema_parity — the inbound parser must agree with nlohmann
+//
+//   schema_parity [mutations] [seed]
+//
+// Every frame of a fixed corpus, plus `mutations` (default 200000) seeded
+// byte-level mutations of it, goes through InboundDispatcher::dispatch()
+// and through json::parse(). Checked:
+//   - the verdict: INVALID_JSON exactly when nlohmann rejects the frame,
+//     it nests deeper than Reader::MAX_DEPTH or it holds a NUL byte (which
+//     ends nlohmann's input early); MISSING_TYPE when the frame
+//     is valid but has no non-empty string "type" (non-objects included);
+//     otherwise UNKNOWN_TYPE or OK, with nlohmann's "type"
+//   - on OK, every field of the typed struct against the frame's value for
+//     that key, or the field's default when the value has the wrong type
+//   - sniff_type(): empty or the type dispatch() sees; never empty for a
+//     valid frame without backslashes; plus a list of exact cases
+// The corpus covers malformed and overlong UTF-8, lone and swapped
+// surrogates, control characters, nesting around MAX_DEPTH, duplicate and
+// non-string "type", non-object frames and "type" keys escaped or nested.
+// Integers stay below 2^53, as fields are read through a double.
+// Exits 1 on the first few mismatches (printed).
+
+#include "network/message_handler.h"
+#include "network/messages.h"
+#include "network/schema.h"
+#include "utils/logger.h"
+
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using nlohmann::json;
+using network::InboundDispatcher;
+using network::schema::DispatchStatus;
+using network::schema::Reader;
+
+std::mt19937 rng;
+int failures = 0;
+
+int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+
+const char* status_name(DispatchStatus s) {
+    switch (s) {
+        case DispatchStatus::OK: return "OK";
+        case DispatchStatus::INVALID_JSON: return "INVALID_JSON";
+        case DispatchStatus::MISSING_TYPE: return "MISSING_TYPE";
+        case DispatchStatus::UNKNOWN_TYPE: return "UNKNOWN_TYPE";
+    }
+    return "?";
+}
+
+// Frames may hold anything; print them escaped
+std::string printable(std::string_view raw) {
+    std::string out;
+    for (unsigned char c : raw) {
+        if (c >= 0x20 && c < 0x7f) {
+            out.push_back(static_cast<char>(c));
+        } else {
+            char hex[5];
+            std::snprintf(hex, sizeof(hex), "\\x%02x", c);
+            out += hex;
+        }
+    }
+    return out;
+}
+
+void mismatch(std::string_view raw, const std::string& what) {
+    if (++failures <= 5) {
+        std::printf("MISMATCH %s\n  frame: %s\n", what.c_str(), printable(raw).c_str());
+    }
+}
+
+// Containers nested in a value, itself included
+int depth(const json& j) {
+    if (!j.is_structured()) return 0;
+    int inner = 0;
+    for (const auto& e : j) inner = std::max(inner, depth(e));
+    return inner + 1;
+}
+
+// ── Fields ──────────────────────────────────────────
+
+template <typename M, typename Fn>
+void for_each_field(Fn&& fn) {
+    using S = typename M::schema;
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (fn(std::tuple_element_t<I, typename S::fields>{}), ...);
+    }(std::make_index_sequence<S::size>{});
+}
+
+template <typename T>
+json field_json(const T& v) {
+    if constexpr (std::is_same_v<T, network::msg::ActionMask>) return v.bits;
+    else return v;
+}
+
+// What a field should hold after parsing `frame`: its value for the key if
+// that has the right JSON type, else the default
+template <typename T>
+json want_field(const json& frame, const std::string& key, const T& def) {
+    auto it = frame.find(key);
+    if (it == frame.end()) return field_json(def);
+    const json& v = *it;
+
+    if constexpr (std::is_same_v<T, bool>) {
+        return v.is_boolean() ? v : field_json(def);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        if (!v.is_number()) return field_json(def);
+        double d = v.get<double>();
+        if constexpr (std::is_integral_v<T>) {
+            if (d < static_cast<double>(std::numeric_limits<T>::min())
+                || d > static_cast<double>(std::numeric_limits<T>::max())) {
+                return field_json(def);
+            }
+        }
+        return static_cast<T>(d);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return v.is_string() ? v : field_json(def);
+    } else if constexpr (std::is_same_v<T, network::msg::ActionMask>) {
+        if (!v.is_array()) return field_json(def);
+        uint8_t bits = 0;
+        for (const auto& a : v) {
+            if (a.is_string()) bits = game::input::add_action(bits, a.get_ref<const std::string&>());
+        }
+        return bits;
+    } else {
+        static_assert(sizeof(T) == 0, "no reference reader for this field type");
+    }
+}
+
+template <typename M>
+json parsed_fields(const M& msg) {
+    json out = json::object();
+    for_each_field<M>([&](auto field) {
+        using F = decltype(field);
+        out[std::string(F::name.view())] = field_json(msg.*F::member);
+    });
+    return out;
+}
+
+template <typename M>
+json expected_fields(const json& frame) {
+    [[maybe_unused]] static const M defaults{};
+    json out = json::object();
+    for_each_field<M>([&](auto field) {
+        using F = decltype(field);
+        std::string key(F::name.view());
+        out[key] = want_field(frame, key, defaults.*F::member);
+    });
+    return out;
+}
+
+template <typename... Ms>
+json expected_for(network::schema::Dispatcher<Ms...>*, std::string_view type, const json& frame) {
+    json out;
+    ((Ms::schema::type.view() == type ? (out = expected_fields<Ms>(frame), true) : false) || ...);
+    return out;
+}
+
+// ── One frame ───────────────────────────────────────
+
+void check(std::string_view raw) {
+    json got_fields;
+    auto result = InboundDispatcher::dispatch(raw, [&](const auto& msg) {
+        got_fields = parsed_fields(msg);
+        return true;
+    });
+
+    // nlohmann stops reading at a NUL byte; the reader, like a browser's
+    // JSON.parse, counts what follows as trailing garbage
+    auto ref = json::parse(raw, nullptr, false);
+    bool nul = raw.find('\0') != std::string_view::npos;
+    DispatchStatus want;
+    std::string type;
+    if (ref.is_discarded() || nul || depth(ref) > Reader::MAX_DEPTH) {
+        want = DispatchStatus::INVALID_JSON;
+    } else if (!ref.is_object() || !ref.contains("type") || !ref["type"].is_string()
+               || ref["type"].get_ref<const std::string&>().empty()) {
+        want = DispatchStatus::MISSING_TYPE;
+    } else {
+        type = ref["type"].get<std::string>();
+        want = InboundDispatcher::lookup(type) < 0 ? DispatchStatus::UNKNOWN_TYPE : DispatchStatus::OK;
+    }
+
+    if (result.status != want) {
+        mismatch(raw, std::string("verdict ") + status_name(result.status) + ", nlohmann " + status_name(want));
+        return;
+    }
+    if (result.type != type) {
+        mismatch(raw, "type '" + printable(result.type) + "', nlohmann '" + printable(type) + "'");
+        return;
+    }
+    if (want == DispatchStatus::OK) {
+        auto want_fields = expected_for(static_cast<InboundDispatcher*>(nullptr), type, ref);
+        if (got_fields != want_fields) {
+            mismatch(raw, "fields " + got_fields.dump() + ", nlohmann " + want_fields.dump());
+        }
+    }
+
+    // The sniffed type is a guess, but never a wrong one
+    auto sniffed = network::schema::sniff_type(raw);
+    if (want == DispatchStatus::INVALID_JSON || !ref.is_object()) return;
+    if (!sniffed.empty() && sniffed != type) {
+        mismatch(raw, "sniffed '" + printable(sniffed) + "', dispatched '" + printable(type) + "'");
+    } else if (sniffed.empty() && !type.empty() && raw.find('\\') == std::string_view::npos) {
+        mismatch(raw, "sniffed nothing, dispatched '" + type + "'");
+    }
+}
+
+// ── Corpus ──────────────────────────────────────────
+
+std::vector<std::string> corpus() {
+    std::vector<std::string> frames = {
+        // Every inbound type, well formed
+        R"({"type":"ping"})",
+        R"({"type":"player_ready","ready":true})",
+        R"({"type":"player_ready","ready":false})",
+        R"({"type":"chat_message","message":"héllo \"there\" 😀 \/ \b\f\n\r\t \\"})",
+        "{\"type\":\"chat_message\",\"message\":\"h\xc3\xa9 \xe6\xbc\xa2 \xf0\x9f\x98\x80\"}",
+        R"({"type":"player_input","tick":42,"actions":["left","jump","right"]})",
+        R"({"type":"player_input","tick":-7,"actions":["right","left",5,null,"dance"]})",
+        R"({"actions":["jump"],"tick":7.9,"type":"player_input","extra":{"a":[1,2,{"b":null}]}})",
+        R"({"type":"probe_ack","probe":1700000000123456,"hold_ms":1.25})",
+        R"({"type":"time_sync","client_time":1.7e12})",
+        R"({"type":"resync_request","tick":-3})",
+        R"({"type":"player_action","slot":1})",
+        R"({"type":"buy_item","item":"sword"})",
+        R"({"type":"no_such_type","x":1})",
+        " \n{ \"type\" : \"ping\" , \"t\" : [ ] }\t\r\n",
+
+        // Numbers
+        R"({"type":"resync_request","tick":-0})",
+        R"({"type":"resync_request","tick":1E+2})",
+        R"({"type":"resync_request","tick":2.5e-3})",
+        R"({"type":"resync_request","tick":01})",
+        R"({"type":"resync_request","tick":-})",
+        R"({"type":"resync_request","tick":1.})",
+        R"({"type":"resync_request","tick":.5})",
+        R"({"type":"resync_request","tick":1e})",
+        R"({"type":"resync_request","tick":1e400})",
+        R"({"type":"resync_request","tick":1e-400})",
+        R"({"type":"resync_request","tick":-2.5e-320})",
+        R"({"type":"resync_request","tick":+1})",
+        R"({"type":"resync_request","tick":1e10})",
+        R"({"type":"resync_request","tick":-2147483649})",
+        R"({"type":"time_sync","client_time":NaN})",
+
+        // Wrong field types keep the default
+        R"({"type":"player_input","tick":"5","actions":"left"})",
+        R"({"type":"player_input","tick":true,"actions":{"0":"left"}})",
+        R"({"type":"player_ready","ready":1})",
+        R"({"type":"player_ready","ready":"true"})",
+        R"({"type":"chat_message","message":["hi"]})",
+        R"({"type":"probe_ack","probe":null,"hold_ms":false})",
+
+        // Repeated keys: the last one counts
+        R"({"type":"player_ready","ready":true,"ready":1})",
+        R"({"type":"player_ready","ready":1,"ready":true})",
+        R"({"type":"player_input","actions":["left"],"actions":["jump"]})",
+        R"({"type":"player_input","tick":5,"tick":"x"})",
+        R"({"type":"chat_message","message":"a","message":"b"})",
+        R"({"type":"ping","type":"chat_message","message":"x"})",
+        R"({"type":"ping","type":1})",
+        R"({"type":1,"type":"ping"})",
+        R"({"type":"ping","type":""})",
+        R"({"type":"ping","type":null})",
+        R"({"type":"ping","type":"chat_message","message":"x"})",
+
+        // No usable type
+        R"({})",
+        R"({"type":""})",
+        R"({"type":5})",
+        R"({"type":null})",
+        R"({"type":true})",
+        R"({"type":["ping"]})",
+        R"({"type":{"type":"ping"}})",
+        R"({"Type":"ping"})",
+        R"({"a":{"type":"ping"}})",
+        R"({"a":"{\"type\":\"ping\"}"})",
+
+        // Not objects
+        "",
+        "   ",
+        "[]",
+        R"([{"type":"ping"}])",
+        R"("ping")",
+        "42",
+        "-1.5e3",
+        "null",
+        "true",
+        "nul",
+
+        // Type keys and values escaped or nested
+        R"({"typ\u0065":"ping"})",
+        R"({"type":"pin\u0067"})",
+        R"({"\u0074ype":"p\u0069ng"})",
+        R"({"type":"ping","typ\u0065":"chat_message","message":"x"})",
+        R"({"type":"ping\u0000"})",
+        R"({"a":{"type":"chat_message"},"type":"ping"})",
+        R"({"type":"ping","a":{"type":"chat_message"}})",
+        R"({"type":"ping","a":"type"})",
+        R"({"a":"type","type":"ping"})",
+        R"({"a":"\\","type":"ping"})",
+        R"({"a":"\"type\":","type":"ping"})",
+        R"({"a":["type",{"type":1}],"type":"ping"})",
+
+        // Structure
+        R"({"type":"ping"} x)",
+        R"({"type":"ping"}{})",
+        R"({"type":"ping",})",
+        R"({"type" "ping"})",
+        R"({"type":"ping")",
+        R"({"type":"ping"]})",
+        R"({type:"ping"})",
+        R"({'type':'ping'})",
+        R"({"type":"ping" /* c */})",
+        R"({"type":"ping","a":[1,]})",
+        R"({"type":"ping","a":[,1]})",
+        R"({"type":"ping","a":tru})",
+        R"({"type":"ping","a":nulll})",
+
+        // Escapes and surrogates
+        R"({"type":"chat_message","message":"\ud800"})",
+        R"({"type":"chat_message","message":"\ud800abc"})",
+        R"({"type":"chat_message","message":"\ud800A"})",
+        R"({"type":"chat_message","message":"\ud800\ud800"})",
+        R"({"type":"chat_message","message":"\udc00"})",
+        R"({"type":"chat_message","message":"\udc00\ud800"})",
+        R"({"type":"chat_message","message":"\udbff\udfff"})",
+        R"({"type":"chat_message","message":"\ud83d\ude00 \u00e9 \u6f22 \u0001"})",
+        R"({"type":"chat_message","message":"\uD83D\uDE00"})",
+        R"({"type":"chat_message","message":"\u12g4"})",
+        R"({"type":"chat_message","message":"\u12"})",
+        R"({"type":"chat_message","message":"\x41"})",
+        R"({"type":"chat_message","message":"\'"})",
+        R"({"type":"chat_message","message":"\)",
+
+        // Control characters must be escaped
+        "{\"type\":\"chat_message\",\"message\":\"a\x01" "b\"}",
+        "{\"type\":\"chat_message\",\"message\":\"a\tb\"}",
+        "{\"type\":\"chat_message\",\"message\":\"a\nb\"}",
+        "{\"type\":\"chat_message\",\"message\":\"a\x7f" "b\"}",
+    };
+
+    // Malformed and overlong UTF-8, in a field, in a key and outside strings
+    const std::vector<std::string> bad_utf8 = {
+        "\x80", "\xbf", "\xc0\xaf", "\xc1\xbf", "\xc3", "\xc3\x28", "\xe0\x80\xaf", "\xe0\xa0",
+        "\xed\xa0\x80", "\xed\xbf\xbf", "\xef\xbf", "\xf0\x8f\xbf\xbf", "\xf0\x9f\x98",
+        "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xfe", "\xff",
+    };
+    const std::vector<std::string> good_utf8 = {
+        "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80", "\xed\x9f\xbf", "\xee\x80\x80", "\xef\xbf\xbf",
+        "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf",
+    };
+    for (const auto& bytes : bad_utf8) {
+        frames.push_back("{\"type\":\"chat_message\",\"message\":\"a" + bytes + "b\"}");
+        frames.push_back("{\"type\":\"chat_message\",\"message\":\"\\n" + bytes + "\"}");
+        frames.push_back("{\"type\":\"ping\",\"k" + bytes + "\":1}");
+        frames.push_back("{\"type\":\"ping\"" + bytes + "}");
+    }
+    for (const auto& bytes : good_utf8) {
+        frames.push_back("{\"type\":\"chat_message\",\"message\":\"" + bytes + "\"}");
+        frames.push_back("{\"type\":\"chat_message\",\"message\":\"\\t" + bytes + "\"}");
+    }
+
+    // Nesting on both sides of MAX_DEPTH, in arrays and objects
+    for (int d = Reader::MAX_DEPTH - 2; d <= Reader::MAX_DEPTH + 2; ++d) {
+        int inner = d - 1;  // the frame's object is one level
+        frames.push_back(R"({"type":"ping","a":)" + std::string(inner, '[') + std::string(inner, ']') + "}");
+        frames.push_back(R"({"type":"ping","a":)" + std::string(inner, '[') + "1" + std::string(inner, ']') + "}");
+        std::string obj;
+        for (int i = 0; i < inner; ++i) obj += R"({"k":)";
+        obj += "0";
+        obj += std::string(inner, '}');
+        frames.push_back(R"({"a":)" + obj + R"(,"type":"ping"})");
+        frames.push_back(std::string(d, '[') + std::string(d, ']'));
+    }
+    return frames;
+}
+
+// Exact sniff_type() results, including the cases it gives up on
+void check_sniff() {
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {R"({"type":"ping"})", "ping"},
+        {" { \"type\" :\t\"ping\" } ", "ping"},
+        {R"({"a":1,"type":"player_input","tick":3})", "player_input"},
+        {R"({"type":"ping","type":"chat_message"})", "chat_message"},
+        {R"({"type":"ping","type":1})", ""},
+        {R"({"type":1,"type":"ping"})", "ping"},
+        {R"({"typ\u0065":"ping"})", ""},
+        {R"({"type":"ping","typ\u0065":"chat_message"})", ""},
+        {R"({"type":"pin\u0067"})", ""},
+        {R"({"a":{"type":"chat_message"},"type":"ping"})", "ping"},
+        {R"({"a":{"type":"chat_message"}})", ""},
+        {R"({"a":"{\"type\":\"chat_message\"}"})", ""},
+        {R"({"a":"\\","type":"ping"})", "ping"},
+        {R"({"type":"ping","a":"type"})", "ping"},
+        {R"([{"type":"ping"}])", ""},
+        {R"("type":"ping")", ""},
+        {R"({"type":"ping)", ""},
+        {R"({"type")", ""},
+        {"", ""},
+    };
+    for (const auto& [raw, want] : cases) {
+        auto got = network::schema::sniff_type(raw);
+        if (got != want) mismatch(raw, "sniffed '" + std::string(got) + "', expected '" + want + "'");
+    }
+}
+
+// Byte edits that tend to land on the parser's edge cases
+std::string mutate(std::string s) {
+    static const std::string specials = "\"\\{}[]:, \t0123456789-+.eEuUdDabcfnrt";
+    static const std::vector<std::string> pieces = {
+        "\\u", "\\ud800", "\\udc00", "\\ud83d\\ude00", "\\\"", "\\\\", "\"type\"", "\"type\":",
+        "\xc3", "\xc3\xa9", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xe6\xbc\xa2", "\x01", "\x80", "\xff",
+        "null", "true", "1e999", "[[[[", "]]]]", "{\"a\":", "}}",
+    };
+    int edits = uniform(1, 4);
+    for (int e = 0; e < edits; ++e) {
+        auto at = static_cast<std::size_t>(uniform(0, static_cast<int>(s.size())));
+        switch (uniform(0, 4)) {
+            case 0:  // overwrite a byte
+                if (at < s.size()) s[at] = specials[static_cast<std::size_t>(uniform(0, static_cast<int>(specials.size()) - 1))];
+                break;
+            case 1:  // random byte
+                s.insert(at, 1, static_cast<char>(uniform(0, 255)));
+                break;
+            case 2:  // drop a few bytes
+                s.erase(at, static_cast<std::size_t>(uniform(1, 3)));
+                break;
+            case 3:  // splice in a piece
+                s.insert(at, pieces[static_cast<std::size_t>(uniform(0, static_cast<int>(pieces.size()) - 1))]);
+                break;
+            default: {  // repeat a slice, e.g. a key/value pair
+                auto len = static_cast<std::size_t>(uniform(1, 16));
+                if (at < s.size()) s.insert(at, s.substr(at, len));
+                break;
+            }
+        }
+    }
+    return s;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int mutations = argc > 1 ? std::stoi(argv[1]) : 200000;
+    rng.seed(argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 1u);
+    logger::set_level("warn");
+
+    auto frames = corpus();
+    for (const auto& raw : frames) check(raw);
+    check_sniff();
+    for (int i = 0; i < mutations; ++i) {
+        check(mutate(frames[static_cast<std::size_t>(uniform(0, static_cast<int>(frames.size()) - 1))]));
+    }
+
+    if (failures > 0) {
+        std::printf("FAIL: %d mismatches\n", failures);
+        return 1;
+    }
+    std::printf("ok: %zu frames and %d mutations match nlohmann\n", frames.size(), mutations);
+    return 0;
+}
@@ -0,0 +1,189 @@
+// snapshot_golden — the direct JSON writers must produce nlohmann's bytes
+//
+//   snapshot_golden [ticks] [seed]
+//
+// Compares, byte for byte:
+//   - Room::write_game_state() with game_state().dump() every tick of a
+//     randomized match (default 2000 ticks): players joining, leaving and
+//     moving, enemies and items appearing anywhere, far outside the
+//     ±2048 range of the rounded-float table, RTT probes included
+//   - Player::write_game_json() with to_game_json().dump() for random
+//     players, positions and velocities up to ±1e7
+//   - JsonWriter::string() with dump() on random byte strings: quotes,
+//     control characters, non-ASCII and invalid UTF-8
+//   - JsonWriter::rounded() with nlohmann's rounded float, across the table
+//     and beyond
+// Ids and names mix ASCII, escapes, multi-byte and malformed UTF-8. The
+// reference dumps use error_handler_t::replace, as the writer does.
+// Exits 1 on the first few mismatches (printed).
+
+#include "game/room.h"
+#include "network/messages.h"
+#include "network/schema.h"
+#include "utils/json_writer.h"
+#include "utils/logger.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using nlohmann::json;
+
+std::mt19937 rng;
+int failures = 0;
+
+int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); }
+
+std::string reference(const json& j) {
+    return j.dump(-1, ' ', false, json::error_handler_t::replace);
+}
+
+void expect(const char* what, std::string_view got, const std::string& want) {
+    if (got == want) return;
+    if (++failures <= 5) {
+        std::printf("MISMATCH %s\n  writer: %.*s\n  dump:   %s\n", what,
+                    static_cast<int>(got.size()), got.data(), want.c_str());
+    }
+}
+
+// Bytes a hostile or sloppy client might put in an id or a name
+std::string random_text(int max_len) {
+    static const std::vector<std::string> pieces = {
+        "a", "Z", "0", "-", " ", "\"", "\\", "/", "\n", "\t", "\x01", "\x1f", "\x7f",
+        "é", "ñ", "漢", "字", "😀", " ", " ",
+        "\x80", "\xbf", "\xc0", "\xc1\xbf", "\xc3", "\xe0\x80", "\xe0\xa0", "\xed\xa0\x80",
+        "\xef\xbf", "\xf0\x8f", "\xf0\x9f\x98", "\xf4\x90\x80\x80", "\xf5", "\xff", "\xfe"
+    };
+    std::string s;
+    int len = uniform(0, max_len);
+    for (int i = 0; i < len; ++i) {
+        if (uniform(0, 3) == 0) {
+            s.push_back(static_cast<char>(uniform(0, 255)));
+        } else {
+            s += pieces[static_cast<std::size_t>(uniform(0, static_cast<int>(pieces.size()) - 1))];
+        }
+    }
+    return s;
+}
+
+// Mostly on the map, sometimes far off it
+float random_coord() {
+    switch (uniform(0, 5)) {
+        case 0:  return uniform(-1e7f, 1e7f);
+        case 1:  return uniform(-3000.0f, 3000.0f);
+        case 2:  return uniform(-0.2f, 0.2f);
+        default: return uniform(0.0f, 1280.0f);
+    }
+}
+
+void check_match(int ticks) {
+    game::Room room("golden", 8);
+    room.set_broadcast_fn([](const std::string&, std::string_view, game::Room::Payload) {});
+    room.set_rollback_window(4);
+
+    std::vector<std::string> ids;
+    auto join = [&] {
+        game::Player p;
+        p.id = random_text(12) + std::to_string(ids.size());
+        p.name = random_text(16);
+        if (room.add_player(p)) ids.push_back(p.id);
+    };
+    for (int i = 0; i < 3; ++i) join();
+    for (const auto& id : ids) room.set_player_ready(id, true);
+
+    for (int t = 0; t < ticks; ++t) {
+        int roll = uniform(0, 99);
+        if (roll < 3 && !room.is_full()) {
+            join();
+        } else if (roll < 5 && ids.size() > 2) {
+            auto i = static_cast<std::size_t>(uniform(0, static_cast<int>(ids.size()) - 1));
+            room.remove_player(ids[i]);
+            ids.erase(ids.begin() + static_cast<std::ptrdiff_t>(i));
+        } else if (room.entities().size() >= 300) {
+            // enough to cover every kind; more only slows the DOM down
+        } else if (roll < 15) {
+            room.spawn_enemy(random_coord(), random_coord(), uniform(1, 500), uniform(0, 5));
+        } else if (roll < 25) {
+            room.spawn_item(random_coord(), random_coord(), uniform(0, 1000));
+        } else if (roll < 30) {
+            room.spawn_projectile(random_coord(), random_coord(), uniform(-900.0f, 900.0f),
+                                  uniform(-900.0f, 900.0f), uniform(0, 20));
+        }
+        for (const auto& id : ids) {
+            room.queue_input(id, room.current_tick() + 1, static_cast<uint8_t>(uniform(0, 7)));
+        }
+        room.update(1.0f / 20.0f);
+        expect("game_state", room.write_game_state(), reference(room.game_state()));
+    }
+}
+
+void check_players(int count) {
+    std::string buf;
+    for (int i = 0; i < count; ++i) {
+        game::Player p;
+        p.id = random_text(24);
+        p.x = random_coord();
+        p.y = random_coord();
+        p.vx = uniform(-1e7f, 1e7f);
+        p.vy = uniform(0, 1) ? uniform(-900.0f, 900.0f) : uniform(-0.3f, 0.3f);
+        p.health = uniform(-100, 100);
+        p.state = static_cast<game::PlayerState>(uniform(0, 4));
+        p.facing = static_cast<game::Facing>(uniform(0, 1));
+        buf.clear();
+        utils::JsonWriter w(buf);
+        p.write_game_json(w);
+        expect("player", buf, reference(p.to_game_json()));
+    }
+}
+
+void check_strings(int count) {
+    std::string buf;
+    for (int i = 0; i < count; ++i) {
+        std::string s = random_text(24);
+        buf.clear();
+        utils::JsonWriter(buf).string(s);
+        expect("string", buf, reference(json(s)));
+
+        // Names also reach clients through the generated codecs
+        network::msg::PlayerJoined joined{s, s};
+        expect("player_joined", network::schema::serialize(joined),
+               reference({{"type", "player_joined"}, {"player_id", s}, {"player_name", s}}));
+    }
+}
+
+void check_rounded() {
+    std::string buf;
+    auto one = [&](float v) {
+        buf.clear();
+        utils::JsonWriter(buf).rounded(v);
+        expect("rounded", buf, reference(json(std::round(v * 10.0f) / 10.0f)));
+    };
+    for (int i = -300000; i <= 300000; ++i) one(static_cast<float>(i) / 97.0f);
+    for (int i = 0; i < 200000; ++i) one(random_coord());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int ticks = argc > 1 ? std::stoi(argv[1]) : 2000;
+    rng.seed(argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 1u);
+    logger::set_level("warn");
+
+    check_match(ticks);
+    check_players(100000);
+    check_strings(100000);
+    check_rounded();
+
+    if (failures > 0) {
+        std::printf("FAIL: %d mismatches\n", failures);
+        return 1;
+    }
+    std::printf("ok: writers match dump()\n");
+    return 0;
+}
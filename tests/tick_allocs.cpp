@@ -0,0 +1,105 @@
+// tick_allocs — fails if a room tick touches the heap once a match is under way
+//
+//   tick_allocs [ticks]
+//
+// Plays a full room the way the server drives it: four players with ids and
+// names longer than the small-string buffer, late-input rollback, enemies,
+// items and projectiles, RTT probes, and a spectator on the delayed stream.
+// After a warm-up that lets every ring, buffer and pool reach its working
+// size, it counts heap allocations (ENABLE_ALLOC_STATS's operator new) over
+// `ticks` more calls to update() (default 2000) and exits 1 if there were any.
+
+#include "game/room.h"
+#include "utils/alloc_stats.h"
+#include "utils/logger.h"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef WOMBO_ALLOC_STATS
+#error "tick_allocs needs the counting operator new (WOMBO_ALLOC_STATS)"
+#endif
+
+namespace {
+
+constexpr float DT = 0.05f;
+constexpr int PLAYERS = 4;
+constexpr int WARM_UP_TICKS = 400;
+
+uint8_t actions_for(int tick, int slot) {
+    return ((tick / 40 + slot) % 2 ? game::input::RIGHT : game::input::LEFT)
+         | (tick % 25 == slot ? game::input::JUMP : 0);
+}
+
+// One tick as the server runs it: this tick's inputs, one of them late
+void play_tick(game::Room& room, const std::vector<std::string>& ids) {
+    int tick = room.current_tick();
+    for (int i = 0; i < PLAYERS; ++i) {
+        int target = i == 0 && tick > 3 ? tick - 2 : tick + 1;
+        room.queue_input(ids[static_cast<std::size_t>(i)], target, actions_for(tick, i));
+    }
+    room.update(DT);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int ticks = argc > 1 ? std::stoi(argv[1]) : 2000;
+    logger::set_level("warn");
+
+    game::Room room("tick-allocs", PLAYERS);
+    room.set_rollback_window(8);
+    room.configure_spectators(2, 20);
+
+    // Sinks that only look at the bytes, like a queue that's already sized
+    std::size_t sent_bytes = 0, spectator_bytes = 0;
+    room.set_broadcast_fn([&](const std::string&, std::string_view message, game::Room::Payload) {
+        sent_bytes += message.size();
+    });
+    room.set_spectator_fn([&](const game::Room&, std::string_view frame) { spectator_bytes += frame.size(); });
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < PLAYERS; ++i) {
+        game::Player p;
+        p.id = "player-" + std::to_string(i) + "-0123456789abcdef0123456789";
+        p.name = "Player number " + std::to_string(i) + " (ñ)";
+        ids.push_back(p.id);
+        room.add_player(p);
+    }
+    for (const auto& id : ids) room.set_player_ready(id, true);  // the last one starts the match
+    room.add_spectator();
+
+    for (int i = 0; i < 24; ++i) {
+        float x = 80.0f + 40.0f * static_cast<float>(i);
+        room.spawn_enemy(x, 600.0f, 1000000, 0);
+        room.spawn_item(x + 20.0f, 400.0f, 1);
+        room.spawn_projectile(x, 300.0f, 0.0f, 0.0f, 0);
+    }
+
+    for (int i = 0; i < WARM_UP_TICKS; ++i) play_tick(room, ids);
+
+    alloc_stats::Scope allocs;
+    int worst_tick = -1;
+    uint64_t worst = 0;
+    for (int i = 0; i < ticks; ++i) {
+        alloc_stats::Scope tick_allocs;
+        play_tick(room, ids);
+        if (tick_allocs.allocations() > worst) {
+            worst = tick_allocs.allocations();
+            worst_tick = room.current_tick();
+        }
+    }
+
+    std::printf("%d ticks, %zu entities, %zu bytes sent, %zu to spectators: %llu allocations (%llu bytes)\n",
+                ticks, room.entities().size(), sent_bytes, spectator_bytes,
+                static_cast<unsigned long long>(allocs.allocations()),
+                static_cast<unsigned long long>(allocs.bytes()));
+    if (allocs.allocations() != 0) {
+        std::printf("FAIL: up to %llu allocations in one tick (tick %d)\n",
+                    static_cast<unsigned long long>(worst), worst_tick);
+        return 1;
+    }
+    return 0;
+}
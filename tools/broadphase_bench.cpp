@@ -0,0 +1,160 @@
+// broadphase_bench — how the entity pass scales with the entity count
+//
+//   broadphase_bench [max_entities] [ticks]
+//
+// For 100, 300, 1000, ... up to `max_entities` (default 10000) enemies,
+// items and projectiles in an EntityStore, times what Room::step_entities
+// does per tick, minus the hit handling: integrate the component arrays,
+// rebuild the collider list (4 players plus every entity) and run the grid
+// broadphase. A few entities are destroyed and respawned every tick, so the
+// free list and swap-removal are part of it.
+//
+// Two layouts per count:
+//   - constant density: the world grows with the count, ~0.3 entities per
+//     64 px cell, the way a bigger map holds more NPCs. Time per collider
+//     should stay flat; that's the linear-scaling check.
+//   - built-in map: everything packed into the 1280x720 arena, so cells
+//     fill up and the narrow test grows with density.
+// Defaults to 2000 ticks per case.
+
+#include "game/broadphase.h"
+#include "game/entity_store.h"
+#include "game/tilemap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Same layers, masks and cell size as Room
+enum Layer : uint8_t { LAYER_PLAYER, LAYER_ENEMY, LAYER_ITEM, LAYER_PROJECTILE };
+constexpr float CELL = 64.0f;
+constexpr float DENSITY = 0.3f;  // entities per cell in the constant-density layout
+constexpr int PLAYERS = 4;
+constexpr float DT = 0.05f;
+
+// Keeps the optimizer from discarding the measured work
+template <typename T>
+void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+template <typename Fn>
+double ns_per_op(long iterations, Fn&& fn) {
+    auto started = Clock::now();
+    for (long i = 0; i < iterations; ++i) fn(i);
+    return std::chrono::duration<double, std::nano>(Clock::now() - started).count()
+           / static_cast<double>(iterations);
+}
+
+struct Result {
+    double ns_per_tick;
+    double pairs;  // average per tick
+};
+
+Result run_case(int count, float world_w, float world_h, long ticks) {
+    std::mt19937 rng(7);
+    auto uniform = [&](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); };
+
+    game::EntityStore e;
+    auto spawn = [&](int i) {
+        auto kind = static_cast<game::EntityKind>(i % 3);
+        float half = kind == game::EntityKind::PROJECTILE ? 4.0f : 12.0f;
+        auto h = e.create(kind, uniform(0.0f, world_w), uniform(0.0f, world_h), half, half);
+        auto d = e.index_of(h);
+        if (kind == game::EntityKind::ENEMY) e.vx[d] = uniform(-80.0f, 80.0f);
+        if (kind == game::EntityKind::PROJECTILE) {
+            e.vx[d] = uniform(-400.0f, 400.0f);
+            e.cooldown[d] = 1e9f;
+        }
+    };
+    for (int i = 0; i < count; ++i) spawn(i);
+
+    game::Broadphase broadphase(world_w, world_h, CELL);
+    broadphase.set_layer_mask(LAYER_PLAYER, 1 << LAYER_ENEMY | 1 << LAYER_ITEM | 1 << LAYER_PROJECTILE);
+    broadphase.set_layer_mask(LAYER_ENEMY, 1 << LAYER_PLAYER | 1 << LAYER_PROJECTILE);
+    broadphase.set_layer_mask(LAYER_ITEM, 1 << LAYER_PLAYER);
+    broadphase.set_layer_mask(LAYER_PROJECTILE, 1 << LAYER_PLAYER | 1 << LAYER_ENEMY);
+
+    float players_x[PLAYERS], players_y[PLAYERS];
+    for (int p = 0; p < PLAYERS; ++p) {
+        players_x[p] = uniform(0.0f, world_w);
+        players_y[p] = uniform(0.0f, world_h);
+    }
+
+    std::vector<game::Collider> colliders;
+    std::size_t pairs = 0;
+    auto tick = [&](long t) {
+        auto n = static_cast<uint32_t>(e.size());
+        for (uint32_t i = 0; i < n; ++i) {
+            e.x[i] += e.vx[i] * DT;
+            e.y[i] += e.vy[i] * DT;
+            e.cooldown[i] -= DT;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            if ((e.x[i] < 0.0f && e.vx[i] < 0.0f) || (e.x[i] > world_w && e.vx[i] > 0.0f)) {
+                e.vx[i] = -e.vx[i];
+            }
+        }
+
+        colliders.clear();
+        for (uint32_t p = 0; p < PLAYERS; ++p) {
+            colliders.push_back({players_x[p] - 12.0f, players_y[p] - 16.0f,
+                                 players_x[p] + 12.0f, players_y[p] + 16.0f, p, LAYER_PLAYER});
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            uint8_t layer = e.kind[i] == game::EntityKind::ENEMY ? LAYER_ENEMY
+                          : e.kind[i] == game::EntityKind::ITEM  ? LAYER_ITEM
+                                                                 : LAYER_PROJECTILE;
+            colliders.push_back({e.x[i] - e.half_w[i], e.y[i] - e.half_h[i],
+                                 e.x[i] + e.half_w[i], e.y[i] + e.half_h[i], i, layer});
+        }
+        pairs += broadphase.run(colliders).size();
+
+        // Churn: ~0.5% die and respawn elsewhere
+        for (int k = 0; k < std::max(1, count / 200); ++k) {
+            e.destroy_at(static_cast<uint32_t>((t * 7919 + k * 104729) % static_cast<long>(e.size())));
+            spawn(static_cast<int>(t + k));
+        }
+        keep(e);
+    };
+
+    // Warm up so every vector reaches its working capacity
+    for (long t = 0; t < 50; ++t) tick(t);
+    pairs = 0;
+    double ns = ns_per_op(ticks, tick);
+    return {ns, static_cast<double>(pairs) / static_cast<double>(ticks)};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int max_entities = argc > 1 ? std::max(100, std::stoi(argv[1])) : 10'000;
+    long ticks = argc > 2 ? std::stol(argv[2]) : 2000;
+    auto map = game::Tilemap::builtin();
+
+    std::printf("%d players, %.0f px cells, %ld ticks per case\n\n", PLAYERS, CELL, ticks);
+    std::printf("%8s | %-38s | built-in map (%.0fx%.0f)\n", "", "constant density (world grows)",
+                map->width_px(), map->height_px());
+    std::printf("%8s | %10s %12s %12s | %10s %12s %12s\n", "entities",
+                "tick", "per collider", "pairs/tick", "tick", "per collider", "pairs/tick");
+
+    for (int count : {100, 300, 1000, 3000, 10'000, 30'000, 100'000}) {
+        if (count > max_entities) break;
+        double colliders = count + PLAYERS;
+
+        float side = CELL * std::sqrt(static_cast<float>(count) / DENSITY);
+        auto sparse = run_case(count, side, side, ticks);
+        auto packed = run_case(count, map->width_px(), map->height_px(), ticks);
+
+        std::printf("%8d | %8.1f us %9.1f ns %12.1f | %8.1f us %9.1f ns %12.1f\n", count,
+                    sparse.ns_per_tick / 1e3, sparse.ns_per_tick / colliders, sparse.pairs,
+                    packed.ns_per_tick / 1e3, packed.ns_per_tick / colliders, packed.pairs);
+    }
+    return 0;
+}
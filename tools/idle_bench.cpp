@@ -0,0 +1,275 @@
+// idle_bench — holds many idle player connections open and reports what
+// each one costs the server
+//
+//   idle_bench <host> <port> <connections> [per_room] [seconds]
+//
+// Reads /memory, joins `connections` players `per_room` to a room (default
+// 4) and keeps them idle — answering pings, reading what the lobby sends —
+// for `seconds` (default 10), then reads /memory again. Prints the RSS
+// growth per connection next to the server's own accounting. Needs a node
+// without JWT (dev mode), MAX_ROOMS ≥ connections / per_room, admission
+// rates high enough not to throttle one address (ADMIT_PER_IP_RATE and
+// friends; throttled handshakes are retried) and a file descriptor limit
+// above <connections>.
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+struct Conn {
+    int fd = -1;
+    std::string in;
+};
+
+addrinfo* g_addr = nullptr;
+
+int open_socket() {
+    int fd = ::socket(g_addr->ai_family, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, g_addr->ai_addr, g_addr->ai_addrlen) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void send_all(int fd, const std::string& s) {
+    std::size_t off = 0;
+    while (off < s.size()) {
+        ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        off += static_cast<std::size_t>(n);
+    }
+}
+
+// Blocking read up to the end of the response headers; anything after
+// them is left in `in`. Returns the status line.
+std::string read_headers(int fd, std::string& in) {
+    char buf[4096];
+    std::size_t end;
+    while ((end = in.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return "";
+        in.append(buf, static_cast<std::size_t>(n));
+    }
+    std::string status = in.substr(0, in.find("\r\n"));
+    in.erase(0, end + 4);
+    return status;
+}
+
+nlohmann::json get_memory(const std::string& host) {
+    int fd = open_socket();
+    if (fd < 0) return {};
+    send_all(fd, "GET /memory HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n");
+    std::string body;
+    std::string status = read_headers(fd, body);
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0) body.append(buf, static_cast<std::size_t>(n));
+    ::close(fd);
+    if (status.find(" 200") == std::string::npos) return {};
+    return nlohmann::json::parse(body, nullptr, false);
+}
+
+// Client frames must be masked; an all-zero mask leaves the payload as is
+void send_pong(int fd, std::string_view payload) {
+    std::string f;
+    f.push_back(static_cast<char>(0x8A));
+    f.push_back(static_cast<char>(0x80 | payload.size()));
+    f.append(4, '\0');
+    f.append(payload);
+    send_all(fd, f);
+}
+
+// Consumes complete server frames, answering pings
+void parse_frames(Conn& c) {
+    std::size_t pos = 0;
+    for (;;) {
+        if (c.in.size() - pos < 2) break;
+        auto b0 = static_cast<uint8_t>(c.in[pos]);
+        auto b1 = static_cast<uint8_t>(c.in[pos + 1]);
+        uint64_t len = b1 & 0x7F;
+        std::size_t header = 2;
+        if (len == 126) {
+            if (c.in.size() - pos < 4) break;
+            len = (uint64_t(uint8_t(c.in[pos + 2])) << 8) | uint8_t(c.in[pos + 3]);
+            header = 4;
+        } else if (len == 127) {
+            if (c.in.size() - pos < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; ++i) len = (len << 8) | uint8_t(c.in[pos + 2 + i]);
+            header = 10;
+        }
+        if (c.in.size() - pos < header + len) break;
+        if ((b0 & 0x0F) == 0x9) {
+            send_pong(c.fd, std::string_view(c.in).substr(pos + header, len));
+        }
+        pos += header + len;
+    }
+    c.in.erase(0, pos);
+}
+
+// Reads whatever has arrived for up to `ms`; returns connections lost
+uint64_t pump(int ep, std::vector<Conn>& conns, int ms) {
+    uint64_t closed = 0;
+    std::vector<epoll_event> events(1024);
+    char buf[16 * 1024];
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    do {
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), ms > 0 ? 50 : 0);
+        for (int e = 0; e < n; ++e) {
+            Conn& c = conns[events[e].data.u64];
+            for (;;) {
+                ssize_t r = ::recv(c.fd, buf, sizeof(buf), 0);
+                if (r > 0) {
+                    c.in.append(buf, static_cast<std::size_t>(r));
+                    continue;
+                }
+                if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+                    ::close(c.fd);
+                    c.fd = -1;
+                    closed++;
+                }
+                break;
+            }
+            if (c.fd >= 0) parse_frames(c);
+        }
+    } while (std::chrono::steady_clock::now() < until);
+    return closed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: idle_bench <host> <port> <connections> [per_room] [seconds]\n";
+        return 2;
+    }
+    std::string host = argv[1], port = argv[2];
+    int target = std::stoi(argv[3]);
+    int per_room = argc > 4 ? std::max(1, std::stoi(argv[4])) : 4;
+    int seconds = argc > 5 ? std::stoi(argv[5]) : 10;
+
+    rlimit lim{};
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < rlim_t(target) + 16) {
+        lim.rlim_cur = std::min<rlim_t>(lim.rlim_max, rlim_t(target) + 16);
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &g_addr) != 0 || !g_addr) {
+        std::cerr << "idle_bench: cannot resolve " << host << "\n";
+        return 1;
+    }
+
+    auto before = get_memory(host);
+    if (before.is_discarded() || before.empty()) {
+        std::cerr << "idle_bench: no /memory on " << host << ":" << port << "\n";
+        return 1;
+    }
+
+    // Room codes unique to this run, so every room starts empty
+    std::string run = std::to_string(std::chrono::system_clock::now().time_since_epoch().count() % 1000000);
+    int ep = epoll_create1(0);
+    std::vector<Conn> conns;
+    conns.reserve(static_cast<std::size_t>(target));
+    uint64_t throttled = 0, closed = 0;
+    auto started = std::chrono::steady_clock::now();
+
+    while (static_cast<int>(conns.size()) < target) {
+        int i = static_cast<int>(conns.size());
+        int fd = open_socket();
+        if (fd < 0) {
+            std::cerr << "idle_bench: connect failed after " << i << " connections: " << std::strerror(errno) << "\n";
+            break;
+        }
+        send_all(fd, "GET /ws/idle" + run + "x" + std::to_string(i / per_room) + " HTTP/1.1\r\n"
+                     "Host: " + host + ":" + port + "\r\n"
+                     "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                     "Sec-WebSocket-Version: 13\r\n\r\n");
+        Conn c{fd, {}};
+        std::string status = read_headers(fd, c.in);
+        if (status.find(" 429") != std::string::npos) {
+            // Admission throttled this address; wait for a token
+            ::close(fd);
+            throttled++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            continue;
+        }
+        if (status.compare(0, 12, "HTTP/1.1 101") != 0) {
+            std::cerr << "idle_bench: stopped after " << i << " connections: " << status << "\n";
+            ::close(fd);
+            break;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(i);
+        epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+        conns.push_back(std::move(c));
+
+        // Keep up with lobby broadcasts so the server never sees backpressure
+        if (conns.size() % 256 == 0) {
+            closed += pump(ep, conns, 0);
+            std::printf("\r%zu connections", conns.size());
+            std::fflush(stdout);
+        }
+    }
+    double connect_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::printf("\ropened %zu connections in %zu rooms in %.1fs (%llu throttled handshakes retried)\n",
+                conns.size(), (conns.size() + static_cast<std::size_t>(per_room) - 1) / static_cast<std::size_t>(per_room), connect_s,
+                static_cast<unsigned long long>(throttled));
+
+    // Idle: only pings and whatever the lobby still sends
+    closed += pump(ep, conns, seconds * 1000);
+    auto after = get_memory(host);
+    if (after.is_discarded() || after.empty()) {
+        std::cerr << "idle_bench: /memory failed after connecting\n";
+        return 1;
+    }
+
+    auto n = static_cast<double>(conns.size() - closed);
+    auto delta = [&](const char* section, const char* key) {
+        return (after[section][key].get<double>() - before[section][key].get<double>()) / n;
+    };
+    double rss = (after["rss_bytes"].get<double>() - before["rss_bytes"].get<double>()) / n;
+    double accounted = (after["accounted_bytes"].get<double>() - before["accounted_bytes"].get<double>()) / n;
+
+    std::printf("%.0f connections held (%llu closed by the server)\n", n, static_cast<unsigned long long>(closed));
+    std::printf("RSS growth:     %8.0f bytes per idle connection\n", rss);
+    std::printf("accounted:      %8.0f bytes per idle connection\n", accounted);
+    std::printf("  connection    %8.0f  (PerSocketData %s bytes)\n",
+                delta("connections", "bytes"), after["connections"]["socket_data_size"].dump().c_str());
+    std::printf("  player        %8.0f\n", delta("players", "bytes"));
+    std::printf("  room share    %8.0f  (%d players per room)\n", delta("rooms", "bytes"), per_room);
+    std::printf("  outboxes      %8.0f\n", delta("outbound", "outbox_bytes"));
+    std::printf("unaccounted:    %8.0f bytes (uWS's own socket structs, allocator overhead)\n",
+                rss - accounted);
+
+    for (auto& c : conns) {
+        if (c.fd >= 0) ::close(c.fd);
+    }
+    freeaddrinfo(g_addr);
+    return 0;
+}
@@ -0,0 +1,147 @@
+// lagcomp_bench — what recording and rewinding player positions costs
+//
+//   lagcomp_bench [players] [tick_rate] [iterations]
+//
+// Sets up `players` moving players (default 16, a full set of slots) and a
+// LagCompensation history at `tick_rate` Hz (default 60), fills the ring,
+// then times:
+//   - recording a tick the way Room::update does: begin_frame() and set()
+//     for every live player, walking the room's player map
+//   - the same into a map of positions, the naive history, for scale
+//   - view_tick() for a measured RTT
+//   - position_at() for one slot at a fractional past tick
+//   - overlap() of an attack box against every rewound hitbox
+//   - a whole hit check: view_tick() + overlap(), what
+//     Room::rewind_overlap_for() adds to an attack
+// Query ticks and RTTs vary across the window every iteration. Defaults to
+// 1000000 iterations.
+
+#include "game/lag_compensation.h"
+#include "game/player.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the optimizer from discarding the measured work
+template <typename T>
+void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+template <typename Fn>
+double ns_per_op(long iterations, Fn&& fn) {
+    auto started = Clock::now();
+    for (long i = 0; i < iterations; ++i) fn(i);
+    return std::chrono::duration<double, std::nano>(Clock::now() - started).count()
+           / static_cast<double>(iterations);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int players = argc > 1 ? std::clamp(std::stoi(argv[1]), 1, game::LagCompensation::MAX_SLOTS) : 16;
+    int tick_rate = argc > 2 ? std::clamp(std::stoi(argv[2]), 1, 240) : 60;
+    long iterations = argc > 3 ? std::stol(argv[3]) : 1'000'000;
+    const float dt = 1.0f / static_cast<float>(tick_rate);
+
+    // Ids like the real ones: longer than the inline string buffer
+    std::unordered_map<std::string, game::Player> room;
+    for (int i = 0; i < players; ++i) {
+        game::Player p;
+        p.id = "player-" + std::to_string(i) + "-0123456789abcdef";
+        p.slot = static_cast<uint8_t>(i);
+        p.health = 100;
+        room.emplace(p.id, p);
+    }
+    auto move = [&](long tick) {
+        for (auto& [_, p] : room) {
+            p.x = 640.0f + 500.0f * std::sin(0.02f * static_cast<float>(tick) + p.slot);
+            p.y = 400.0f + 100.0f * std::cos(0.03f * static_cast<float>(tick) + p.slot);
+        }
+    };
+
+    game::LagCompensation history;
+    int tick = 0;
+    auto record = [&] {
+        auto& frame = history.begin_frame(++tick, dt);
+        for (const auto& [_, p] : room) {
+            if (p.slot != game::Player::NO_SLOT && p.health > 0) frame.set(p.slot, p.x, p.y);
+        }
+    };
+    for (int i = 0; i < game::LagCompensation::CAPACITY; ++i) {
+        move(tick);
+        record();
+    }
+
+    double record_ns = ns_per_op(iterations, [&](long) {
+        record();
+        keep(history);
+    });
+
+    std::unordered_map<std::string, std::pair<float, float>> naive;
+    double naive_ns = ns_per_op(iterations, [&](long) {
+        naive.clear();
+        for (const auto& [id, p] : room) naive.emplace(id, std::make_pair(p.x, p.y));
+        keep(naive);
+    });
+
+    // Refill with moving players so queries interpolate between real positions
+    for (int i = 0; i < game::LagCompensation::CAPACITY; ++i) {
+        move(tick);
+        record();
+    }
+
+    // RTTs from 0 to ~600 ms, beyond the 250 ms cap
+    auto rtt_for = [](long i) { return static_cast<float>((i * 37) % 600); };
+    float window = static_cast<float>(history.latest_tick() - history.oldest_tick());
+    auto tick_for = [&](long i) {
+        return static_cast<float>(history.oldest_tick()) + window * static_cast<float>(i % 997) / 997.0f;
+    };
+
+    double view_ns = ns_per_op(iterations, [&](long i) {
+        float v = history.view_tick(rtt_for(i), 50.0f);
+        keep(v);
+    });
+
+    double position_ns = ns_per_op(iterations, [&](long i) {
+        float x = 0.0f, y = 0.0f;
+        bool found = history.position_at(static_cast<int>(i % players), tick_for(i), x, y);
+        keep(found);
+        keep(x);
+        keep(y);
+    });
+
+    // A wide swing: catches a few players each time
+    const game::Hitbox swing{500.0f, 300.0f, 780.0f, 500.0f};
+    long hits = 0;
+    double overlap_ns = ns_per_op(iterations, [&](long i) {
+        auto mask = history.overlap(swing, tick_for(i), game::physics::PLAYER_HALF_W, game::physics::PLAYER_HALF_H);
+        hits += std::popcount(static_cast<unsigned>(mask));
+    });
+
+    double check_ns = ns_per_op(iterations, [&](long i) {
+        float view = history.view_tick(rtt_for(i), 50.0f);
+        auto mask = history.overlap(swing, view, game::physics::PLAYER_HALF_W, game::physics::PLAYER_HALF_H,
+                                    static_cast<game::LagCompensation::SlotMask>(1u << (i % players)));
+        keep(mask);
+    });
+
+    std::printf("%d players, %d Hz, %d-frame ring (%zu bytes), %ld iterations\n", players, tick_rate,
+                game::LagCompensation::CAPACITY, sizeof(game::LagCompensation), iterations);
+    std::printf("record a tick              %8.1f ns   (%.1f ns per player)\n", record_ns, record_ns / players);
+    std::printf("  into a map of positions  %8.1f ns   (naive history)\n", naive_ns);
+    std::printf("view_tick                  %8.1f ns\n", view_ns);
+    std::printf("position_at                %8.1f ns\n", position_ns);
+    std::printf("overlap, %2d hitboxes       %8.1f ns   (%.1f hits on average)\n", players, overlap_ns,
+                static_cast<double>(hits) / static_cast<double>(iterations));
+    std::printf("hit check (view + overlap) %8.1f ns\n", check_ns);
+    return 0;
+}
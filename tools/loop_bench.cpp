@@ -0,0 +1,346 @@
+// loop_bench — drives many connections with request/response traffic and
+// reports what the event loop spends on it, to compare the epoll and
+// io_uring builds (ENABLE_IO_URING) on the same workload
+//
+//   loop_bench <host> <port> <connections> [rate] [seconds] [server_pid]
+//
+// Opens `connections` players, 4 per room, and has each send `rate`
+// time_sync requests a second (default 5; keep it under
+// INBOUND_RATE_CONTROL) for `seconds` (default 20) after a 2 s warm-up.
+// Prints the round-trip latency percentiles of those requests. With
+// `server_pid` (same host) it also samples /proc/<pid> over the run: CPU
+// time per message, read/write-family syscalls (/proc/<pid>/io) and context
+// switches. io_uring submits I/O without read/write syscalls, so for a
+// like-for-like syscall count run the server under
+// `perf stat -e raw_syscalls:sys_enter -p <pid>` as well. Needs a node
+// without JWT (dev mode), admission rates high enough for one address and a
+// file descriptor limit above <connections>.
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Conn {
+    int fd = -1;
+    std::string in;
+};
+
+// Counters of the server process, from /proc
+struct ProcSample {
+    double cpu_s = 0;
+    uint64_t syscr = 0, syscw = 0;
+    uint64_t ctx_voluntary = 0, ctx_involuntary = 0;
+    bool ok = false;
+};
+
+addrinfo* g_addr = nullptr;
+Clock::time_point g_epoch = Clock::now();
+std::vector<double> g_rtt_us;
+uint64_t g_replies = 0, g_frames_in = 0;
+bool g_measuring = false;
+
+ProcSample sample(int pid) {
+    ProcSample s;
+    if (pid <= 0) return s;
+    std::string base = "/proc/" + std::to_string(pid);
+
+    std::ifstream stat(base + "/stat");
+    std::string line;
+    if (!std::getline(stat, line)) return s;
+    // Fields after the parenthesised command name; utime and stime are 14 and 15
+    std::istringstream rest(line.substr(line.rfind(')') + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    for (int i = 3; rest >> field; ++i) {
+        if (i == 14) utime = std::stoull(field);
+        if (i == 15) {
+            stime = std::stoull(field);
+            break;
+        }
+    }
+    s.cpu_s = static_cast<double>(utime + stime) / static_cast<double>(sysconf(_SC_CLK_TCK));
+
+    std::ifstream io(base + "/io");
+    while (io >> field) {
+        if (field == "syscr:") io >> s.syscr;
+        else if (field == "syscw:") io >> s.syscw;
+    }
+    std::ifstream status(base + "/status");
+    while (std::getline(status, line)) {
+        if (line.rfind("voluntary_ctxt_switches:", 0) == 0) s.ctx_voluntary = std::stoull(line.substr(24));
+        if (line.rfind("nonvoluntary_ctxt_switches:", 0) == 0) s.ctx_involuntary = std::stoull(line.substr(27));
+    }
+    s.ok = true;
+    return s;
+}
+
+int open_socket() {
+    int fd = ::socket(g_addr->ai_family, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, g_addr->ai_addr, g_addr->ai_addrlen) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void send_all(int fd, const std::string& s) {
+    std::size_t off = 0;
+    while (off < s.size()) {
+        ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        off += static_cast<std::size_t>(n);
+    }
+}
+
+std::string read_headers(int fd, std::string& in) {
+    char buf[4096];
+    std::size_t end;
+    while ((end = in.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return "";
+        in.append(buf, static_cast<std::size_t>(n));
+    }
+    std::string status = in.substr(0, in.find("\r\n"));
+    in.erase(0, end + 4);
+    return status;
+}
+
+// Client frames must be masked; an all-zero mask leaves the payload as is
+void send_frame(int fd, uint8_t opcode, std::string_view payload) {
+    std::string f;
+    f.push_back(static_cast<char>(0x80 | opcode));
+    f.push_back(static_cast<char>(0x80 | payload.size()));
+    f.append(4, '\0');
+    f.append(payload);
+    send_all(fd, f);
+}
+
+double now_us() {
+    return std::chrono::duration<double, std::micro>(Clock::now() - g_epoch).count();
+}
+
+void on_text(std::string_view text) {
+    // Only time_sync replies matter; skip the parse for everything else
+    if (text.find("\"time_sync\"") == std::string_view::npos) return;
+    auto j = nlohmann::json::parse(text, nullptr, false);
+    if (j.is_discarded() || !j.contains("client_time")) return;
+    if (!g_measuring) return;
+    g_rtt_us.push_back(now_us() - j["client_time"].get<double>());
+    g_replies++;
+}
+
+void parse_frames(Conn& c) {
+    std::size_t pos = 0;
+    for (;;) {
+        if (c.in.size() - pos < 2) break;
+        auto b0 = static_cast<uint8_t>(c.in[pos]);
+        auto b1 = static_cast<uint8_t>(c.in[pos + 1]);
+        uint64_t len = b1 & 0x7F;
+        std::size_t header = 2;
+        if (len == 126) {
+            if (c.in.size() - pos < 4) break;
+            len = (uint64_t(uint8_t(c.in[pos + 2])) << 8) | uint8_t(c.in[pos + 3]);
+            header = 4;
+        } else if (len == 127) {
+            if (c.in.size() - pos < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; ++i) len = (len << 8) | uint8_t(c.in[pos + 2 + i]);
+            header = 10;
+        }
+        if (c.in.size() - pos < header + len) break;
+        auto payload = std::string_view(c.in).substr(pos + header, len);
+        if ((b0 & 0x0F) == 0x9) send_frame(c.fd, 0xA, payload);
+        if ((b0 & 0x0F) == 0x1) on_text(payload);
+        if (g_measuring) g_frames_in++;
+        pos += header + len;
+    }
+    c.in.erase(0, pos);
+}
+
+// Reads whatever is ready, waiting at most `ms`
+void pump(int ep, std::vector<Conn>& conns, int ms) {
+    std::vector<epoll_event> events(1024);
+    char buf[16 * 1024];
+    int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), ms);
+    for (int e = 0; e < n; ++e) {
+        Conn& c = conns[events[e].data.u64];
+        for (;;) {
+            ssize_t r = ::recv(c.fd, buf, sizeof(buf), 0);
+            if (r > 0) {
+                c.in.append(buf, static_cast<std::size_t>(r));
+                continue;
+            }
+            if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+                ::close(c.fd);
+                c.fd = -1;
+            }
+            break;
+        }
+        if (c.fd >= 0) parse_frames(c);
+    }
+}
+
+double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0;
+    auto k = static_cast<std::size_t>(p * static_cast<double>(v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(k), v.end());
+    return v[k];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: loop_bench <host> <port> <connections> [rate] [seconds] [server_pid]\n";
+        return 2;
+    }
+    std::string host = argv[1], port = argv[2];
+    int target = std::stoi(argv[3]);
+    double rate = argc > 4 ? std::stod(argv[4]) : 5.0;
+    int seconds = argc > 5 ? std::stoi(argv[5]) : 20;
+    int pid = argc > 6 ? std::stoi(argv[6]) : 0;
+
+    rlimit lim{};
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < rlim_t(target) + 16) {
+        lim.rlim_cur = std::min<rlim_t>(lim.rlim_max, rlim_t(target) + 16);
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &g_addr) != 0 || !g_addr) {
+        std::cerr << "loop_bench: cannot resolve " << host << "\n";
+        return 1;
+    }
+
+    std::string run = std::to_string(std::chrono::system_clock::now().time_since_epoch().count() % 1000000);
+    int ep = epoll_create1(0);
+    std::vector<Conn> conns;
+    conns.reserve(static_cast<std::size_t>(target));
+    while (static_cast<int>(conns.size()) < target) {
+        int i = static_cast<int>(conns.size());
+        int fd = open_socket();
+        if (fd < 0) {
+            std::cerr << "loop_bench: connect failed after " << i << " connections: " << std::strerror(errno) << "\n";
+            break;
+        }
+        send_all(fd, "GET /ws/loop" + run + "x" + std::to_string(i / 4) + " HTTP/1.1\r\n"
+                     "Host: " + host + ":" + port + "\r\n"
+                     "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                     "Sec-WebSocket-Version: 13\r\n\r\n");
+        Conn c{fd, {}};
+        std::string status = read_headers(fd, c.in);
+        if (status.find(" 429") != std::string::npos) {
+            ::close(fd);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            continue;
+        }
+        if (status.compare(0, 12, "HTTP/1.1 101") != 0) {
+            std::cerr << "loop_bench: stopped after " << i << " connections: " << status << "\n";
+            ::close(fd);
+            break;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(i);
+        epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+        conns.push_back(std::move(c));
+        if (conns.size() % 256 == 0) pump(ep, conns, 0);
+    }
+    std::printf("%zu connections open\n", conns.size());
+
+    // Requests are spread evenly over each second, one connection at a time
+    auto interval = std::chrono::duration<double>(1.0 / (rate * static_cast<double>(conns.size())));
+    auto send_one = [&](std::size_t i) {
+        if (conns[i].fd < 0) return;
+        char msg[96];
+        int len = std::snprintf(msg, sizeof(msg), R"({"type":"time_sync","client_time":%.1f})", now_us());
+        send_frame(conns[i].fd, 0x1, std::string_view(msg, static_cast<std::size_t>(len)));
+    };
+
+    auto run_for = [&](double secs) -> uint64_t {
+        uint64_t sent = 0;
+        auto start = Clock::now();
+        auto until = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(secs));
+        auto next = start;
+        std::size_t i = 0;
+        while (Clock::now() < until) {
+            while (Clock::now() >= next) {
+                send_one(i);
+                i = (i + 1) % conns.size();
+                sent++;
+                next += std::chrono::duration_cast<Clock::duration>(interval);
+            }
+            pump(ep, conns, 1);
+        }
+        return sent;
+    };
+
+    run_for(2.0);  // warm-up: lobby broadcasts settle, caches fill
+
+    g_measuring = true;
+    ProcSample before = sample(pid);
+    auto started = Clock::now();
+    uint64_t sent = run_for(seconds);
+    double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    ProcSample after = sample(pid);
+    g_measuring = false;
+
+    std::size_t open = 0;
+    for (auto& c : conns) open += c.fd >= 0;
+
+    std::printf("%zu connections held, %.0f requests/s sent, %.0f replies/s, %.0f frames/s received\n",
+                open, static_cast<double>(sent) / elapsed, static_cast<double>(g_replies) / elapsed,
+                static_cast<double>(g_frames_in) / elapsed);
+    std::printf("round trip (us): p50 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n",
+                percentile(g_rtt_us, 0.50), percentile(g_rtt_us, 0.99), percentile(g_rtt_us, 0.999),
+                g_rtt_us.empty() ? 0.0 : *std::max_element(g_rtt_us.begin(), g_rtt_us.end()));
+
+    if (before.ok && after.ok) {
+        double messages = static_cast<double>(sent + g_frames_in);
+        double cpu = after.cpu_s - before.cpu_s;
+        std::printf("server CPU: %.1f%% of a core, %.2f us per message (in + out)\n",
+                    100.0 * cpu / elapsed, messages > 0 ? 1e6 * cpu / messages : 0.0);
+        std::printf("server read/write syscalls: %.0f/s (%.0f reads, %.0f writes)\n",
+                    static_cast<double>(after.syscr - before.syscr + after.syscw - before.syscw) / elapsed,
+                    static_cast<double>(after.syscr - before.syscr) / elapsed,
+                    static_cast<double>(after.syscw - before.syscw) / elapsed);
+        std::printf("server context switches: %.0f/s voluntary, %.0f/s involuntary\n",
+                    static_cast<double>(after.ctx_voluntary - before.ctx_voluntary) / elapsed,
+                    static_cast<double>(after.ctx_involuntary - before.ctx_involuntary) / elapsed);
+    } else if (pid > 0) {
+        std::cerr << "loop_bench: cannot read /proc/" << pid << " (other user? other host?)\n";
+    }
+
+    for (auto& c : conns) {
+        if (c.fd >= 0) ::close(c.fd);
+    }
+    freeaddrinfo(g_addr);
+    return 0;
+}
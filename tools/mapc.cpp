@@ -0,0 +1,95 @@
+// mapc — compiles a text map into the binary tilemap format (.wmap)
+//
+//   mapc <input.txt> <output.wmap>
+//
+// Input: optional "tile_size N" line, then one line per row of tiles:
+//   '#' solid, '.' empty, 'S' empty tile with a spawn point
+// A spawn puts the body center on the tile's floor, horizontally centered.
+// Lines starting with ';' are comments. All rows must be the same width.
+
+#include "game/tilemap.h"
+#include "game/player.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "usage: mapc <input.txt> <output.wmap>\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "mapc: cannot open " << argv[1] << "\n";
+        return 1;
+    }
+
+    int tile_size = 16;
+    std::vector<std::string> rows;
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == ';') continue;
+        if (line.rfind("tile_size ", 0) == 0) {
+            tile_size = std::stoi(line.substr(10));
+            continue;
+        }
+        if (line.find_first_not_of("#.S") != std::string::npos) {
+            std::cerr << "mapc: " << argv[1] << ":" << line_no << ": unexpected character\n";
+            return 1;
+        }
+        if (!rows.empty() && line.size() != rows[0].size()) {
+            std::cerr << "mapc: " << argv[1] << ":" << line_no << ": row width "
+                      << line.size() << ", expected " << rows[0].size() << "\n";
+            return 1;
+        }
+        rows.push_back(line);
+    }
+
+    if (rows.empty() || tile_size <= 0 || rows.size() > 0xFFFF || rows[0].size() > 0xFFFF) {
+        std::cerr << "mapc: no usable rows in " << argv[1] << "\n";
+        return 1;
+    }
+
+    int columns = static_cast<int>(rows[0].size());
+    int height = static_cast<int>(rows.size());
+    std::vector<uint8_t> solid(static_cast<std::size_t>(columns) * height, 0);
+    std::vector<game::SpawnPoint> spawns;
+
+    for (int ty = 0; ty < height; ++ty) {
+        for (int tx = 0; tx < columns; ++tx) {
+            char c = rows[ty][tx];
+            if (c == '#') {
+                solid[ty * columns + tx] = 1;
+            } else if (c == 'S') {
+                spawns.push_back({
+                    (static_cast<float>(tx) + 0.5f) * static_cast<float>(tile_size),
+                    static_cast<float>((ty + 1) * tile_size) - game::physics::PLAYER_HALF_H
+                });
+            }
+        }
+    }
+
+    if (spawns.empty()) {
+        std::cerr << "mapc: " << argv[1] << " has no spawn points ('S')\n";
+        return 1;
+    }
+
+    auto bytes = game::Tilemap::encode(tile_size, columns, height, solid, spawns);
+    std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        std::cerr << "mapc: cannot write " << argv[2] << "\n";
+        return 1;
+    }
+
+    std::printf("%s: %dx%d tiles of %dpx, %zu spawns, %zu bytes\n",
+                argv[2], columns, height, tile_size, spawns.size(), bytes.size());
+    return 0;
+}
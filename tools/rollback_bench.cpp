@@ -0,0 +1,141 @@
+// rollback_bench — what saving, restoring and replaying room state costs
+// per tick
+//
+//   rollback_bench [players] [window] [iterations]
+//
+// Sets up `players` moving players on the built-in map (default 4) and a
+// rollback ring of `window` ticks (default 8), then times, per tick:
+//   - copying the room's player map, the naive way to save a tick
+//   - saving a tick into the ring (gathering every player's Motion)
+//   - the memcpy of one saved State on its own
+//   - restoring a saved State onto the players
+//   - replaying the whole window after a late input
+// and one ordinary movement tick for scale. Defaults to 200000 iterations.
+
+#include "game/player.h"
+#include "game/rollback.h"
+#include "game/tilemap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the optimizer from discarding the measured work
+template <typename T>
+void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+template <typename Fn>
+double ns_per_op(long iterations, Fn&& fn) {
+    auto started = Clock::now();
+    for (long i = 0; i < iterations; ++i) fn(i);
+    return std::chrono::duration<double, std::nano>(Clock::now() - started).count()
+           / static_cast<double>(iterations);
+}
+
+uint8_t actions_for(long tick, int slot) {
+    return ((tick / 40 + slot) % 2 ? game::input::RIGHT : game::input::LEFT)
+         | (tick % 25 == slot ? game::input::JUMP : 0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int players = argc > 1 ? std::clamp(std::stoi(argv[1]), 1, game::Rollback::MAX_SLOTS) : 4;
+    int window = argc > 2 ? std::clamp(std::stoi(argv[2]), 1, game::Rollback::CAPACITY - 1) : 8;
+    long iterations = argc > 3 ? std::stol(argv[3]) : 200'000;
+    const float dt = 0.05f;
+
+    auto map = game::Tilemap::builtin();
+
+    // Ids and names like the real ones: longer than the inline string buffer
+    std::unordered_map<std::string, game::Player> room;
+    for (int i = 0; i < players; ++i) {
+        game::Player p;
+        p.id = "player-" + std::to_string(i) + "-0123456789abcdef";
+        p.name = "Player Number " + std::to_string(i);
+        p.slot = static_cast<uint8_t>(i);
+        p.spawn(100.0f + 200.0f * static_cast<float>(i), game::physics::GROUND_Y);
+        room.emplace(p.id, p);
+    }
+
+    game::Rollback rollback(window);
+    long tick = 0;
+    auto save = [&] {
+        auto& f = rollback.begin_tick(static_cast<int>(++tick), dt);
+        f.state.active = 0;
+        f.actions = {};
+        for (auto& [_, p] : room) {
+            p.pending_actions = actions_for(tick, p.slot);
+            f.state.bodies[p.slot] = p.motion();
+            f.state.active |= static_cast<uint16_t>(1u << p.slot);
+            f.actions[p.slot] = p.pending_actions;
+        }
+    };
+    auto simulate = [&] {
+        for (auto& [_, p] : room) p.process_input(dt, *map);
+    };
+
+    // Fill the ring with real ticks
+    for (int i = 0; i < game::Rollback::CAPACITY; ++i) {
+        save();
+        simulate();
+    }
+
+    double tick_ns = ns_per_op(iterations, [&](long) {
+        for (auto& [_, p] : room) p.pending_actions = actions_for(tick, p.slot);
+        simulate();
+    });
+
+    double copy_map_ns = ns_per_op(iterations, [&](long) {
+        auto copy = room;
+        keep(copy);
+    });
+
+    double save_ns = ns_per_op(iterations, [&](long) {
+        save();
+        keep(rollback);
+    });
+    for (auto& [_, p] : room) p.pending_actions = 0;
+
+    game::Rollback::State saved, scratch;
+    for (auto& [_, p] : room) {
+        saved.bodies[p.slot] = p.motion();
+        saved.active |= static_cast<uint16_t>(1u << p.slot);
+    }
+    double memcpy_ns = ns_per_op(iterations, [&](long) {
+        std::memcpy(&scratch, &saved, sizeof(saved));
+        keep(scratch);
+    });
+
+    double restore_ns = ns_per_op(iterations, [&](long) {
+        scratch = saved;
+        for (auto& [_, p] : room) p.set_motion(scratch.bodies[p.slot]);
+        keep(room);
+    });
+
+    // A late input at the far end of the window, every tick
+    int replayed = 0;
+    double replay_ns = ns_per_op(iterations, [&](long) {
+        int newest = rollback.newest_tick();
+        rollback.amend(newest - window + 1, 0, game::input::JUMP);
+        replayed = rollback.replay(*map, scratch);
+        keep(scratch);
+    });
+
+    std::printf("%d players, %d-tick window, %ld iterations\n", players, window, iterations);
+    std::printf("State %zu bytes, ring %zu bytes\n", sizeof(game::Rollback::State), sizeof(game::Rollback));
+    std::printf("movement tick          %8.1f ns\n", tick_ns);
+    std::printf("copy player map        %8.1f ns   (naive save)\n", copy_map_ns);
+    std::printf("save tick into ring    %8.1f ns\n", save_ns);
+    std::printf("  memcpy of a State    %8.1f ns\n", memcpy_ns);
+    std::printf("restore onto players   %8.1f ns\n", restore_ns);
+    std::printf("replay %2d ticks        %8.1f ns   (%.1f ns per tick)\n",
+                replayed, replay_ns, replay_ns / std::max(1, replayed));
+    return 0;
+}
@@ -0,0 +1,91 @@
+// snapshot_bench — what a game_state snapshot costs through the DOM and
+// through the direct writer
+//
+//   snapshot_bench [players] [entities] [iterations]
+//
+// Starts a match with `players` (default 4) and `entities` enemies and items
+// (default 0, what a Phase 2 room sends), plays a few ticks, then times per
+// snapshot:
+//   - game_state().dump(): building the nlohmann DOM and dumping it
+//   - write_game_state(): appending straight into the room's buffer
+// and prints the speedup. Both produce the same bytes (checked once here;
+// tests/snapshot_golden checks it properly). Defaults to 100000 iterations.
+
+#include "game/room.h"
+#include "utils/json_writer.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the optimizer from discarding the measured work
+template <typename T>
+void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+template <typename Fn>
+double ns_per_op(long iterations, Fn&& fn) {
+    auto started = Clock::now();
+    for (long i = 0; i < iterations; ++i) fn(i);
+    return std::chrono::duration<double, std::nano>(Clock::now() - started).count()
+           / static_cast<double>(iterations);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int players = argc > 1 ? std::clamp(std::stoi(argv[1]), 2, 64) : 4;
+    int entities = argc > 2 ? std::max(0, std::stoi(argv[2])) : 0;
+    long iterations = argc > 3 ? std::stol(argv[3]) : 100'000;
+    logger::set_level("warn");
+    utils::JsonWriter::warm_up();
+
+    game::Room room("bench", players);
+    room.set_broadcast_fn([](const std::string&, std::string_view, game::Room::Payload) {});
+
+    // Ids like the real ones: longer than the inline string buffer
+    for (int i = 0; i < players; ++i) {
+        game::Player p;
+        p.id = "player-" + std::to_string(i) + "-0123456789abcdef0123456789";
+        p.name = "Player Number " + std::to_string(i);
+        room.add_player(p);
+    }
+    for (int i = 0; i < players; ++i) {
+        room.set_player_ready("player-" + std::to_string(i) + "-0123456789abcdef0123456789", true);
+    }
+    for (int i = 0; i < entities; ++i) {
+        float x = 20.0f + static_cast<float>(i * 37 % 1240);
+        if (i % 2) room.spawn_enemy(x, 600.0f, 100, 0);
+        else room.spawn_item(x, 400.0f, 5);
+    }
+    for (int i = 0; i < 10; ++i) room.update(0.05f);
+
+    std::string dom = room.game_state().dump();
+    if (std::string(room.write_game_state()) != dom) {
+        std::printf("writer output differs from game_state().dump(); run snapshot_golden\n");
+        return 1;
+    }
+
+    double dom_ns = ns_per_op(iterations, [&](long) {
+        auto s = room.game_state().dump();
+        keep(s);
+    });
+    double writer_ns = ns_per_op(iterations, [&](long) {
+        auto s = room.write_game_state();
+        keep(s);
+    });
+
+    std::printf("%d players, %zu entities, %zu-byte snapshot, %ld iterations\n",
+                players, room.entities().size(), dom.size(), iterations);
+    std::printf("game_state().dump()    %9.1f ns   %7.1f MB/s\n", dom_ns,
+                static_cast<double>(dom.size()) * 1e3 / dom_ns);
+    std::printf("write_game_state()     %9.1f ns   %7.1f MB/s\n", writer_ns,
+                static_cast<double>(dom.size()) * 1e3 / writer_ns);
+    std::printf("speedup                %9.1fx\n", dom_ns / writer_ns);
+    return 0;
+}
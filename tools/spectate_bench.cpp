@@ -0,0 +1,203 @@
+// spectate_bench — opens many spectator connections to one room and reports
+// the fan-out the server sustains
+//
+//   spectate_bench <host> <port> <room> <viewers> [seconds] [--deflate]
+//
+// Each second prints frames and bytes received across all viewers; the
+// server's CPU for that rate (top / pidstat) gives fan-out per core. Run it
+// from another machine, or pin it to other cores, so the two don't compete.
+// Needs a room in PLAYING state on the target node, and a file descriptor
+// limit above <viewers>.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Viewer {
+    int fd = -1;
+    bool upgraded = false;
+    std::string in;
+};
+
+struct Totals {
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t closed = 0;
+};
+
+void send_all(int fd, const std::string& s) {
+    std::size_t off = 0;
+    while (off < s.size()) {
+        ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        off += static_cast<std::size_t>(n);
+    }
+}
+
+// Client frames must be masked; an all-zero mask leaves the payload as is
+void send_pong(int fd, std::string_view payload) {
+    std::string f;
+    f.push_back(static_cast<char>(0x8A));
+    f.push_back(static_cast<char>(0x80 | payload.size()));
+    f.append(4, '\0');
+    f.append(payload);
+    send_all(fd, f);
+}
+
+// Consumes complete server frames from v.in
+void parse_frames(Viewer& v, Totals& t) {
+    std::size_t pos = 0;
+    for (;;) {
+        if (v.in.size() - pos < 2) break;
+        auto b0 = static_cast<uint8_t>(v.in[pos]);
+        auto b1 = static_cast<uint8_t>(v.in[pos + 1]);
+        uint64_t len = b1 & 0x7F;
+        std::size_t header = 2;
+        if (len == 126) {
+            if (v.in.size() - pos < 4) break;
+            len = (uint64_t(uint8_t(v.in[pos + 2])) << 8) | uint8_t(v.in[pos + 3]);
+            header = 4;
+        } else if (len == 127) {
+            if (v.in.size() - pos < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; ++i) len = (len << 8) | uint8_t(v.in[pos + 2 + i]);
+            header = 10;
+        }
+        if (v.in.size() - pos < header + len) break;
+
+        int opcode = b0 & 0x0F;
+        if (opcode == 0x9) {
+            send_pong(v.fd, std::string_view(v.in).substr(pos + header, len));
+        } else if (opcode == 0x1 || opcode == 0x2) {
+            t.frames++;
+            t.bytes += len;
+        }
+        pos += header + len;
+    }
+    v.in.erase(0, pos);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        std::cerr << "usage: spectate_bench <host> <port> <room> <viewers> [seconds] [--deflate]\n";
+        return 2;
+    }
+    std::string host = argv[1], port = argv[2], room = argv[3];
+    int viewers = std::stoi(argv[4]);
+    int seconds = argc > 5 && argv[5][0] != '-' ? std::stoi(argv[5]) : 10;
+    bool deflate = std::string(argv[argc - 1]) == "--deflate";
+
+    rlimit lim{};
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < rlim_t(viewers) + 16) {
+        lim.rlim_cur = std::min<rlim_t>(lim.rlim_max, rlim_t(viewers) + 16);
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    addrinfo hints{}, *addr = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addr) != 0 || !addr) {
+        std::cerr << "spectate_bench: cannot resolve " << host << "\n";
+        return 1;
+    }
+
+    std::string request = "GET /spectate/" + room + (deflate ? "?deflate=1" : "") + " HTTP/1.1\r\n"
+                          "Host: " + host + ":" + port + "\r\n"
+                          "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+
+    int ep = epoll_create1(0);
+    std::vector<Viewer> conns(static_cast<std::size_t>(viewers));
+    for (int i = 0; i < viewers; ++i) {
+        int fd = ::socket(addr->ai_family, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, addr->ai_addr, addr->ai_addrlen) != 0) {
+            std::cerr << "spectate_bench: connect failed after " << i << " viewers: "
+                      << std::strerror(errno) << "\n";
+            if (fd >= 0) ::close(fd);
+            conns.resize(static_cast<std::size_t>(i));
+            break;
+        }
+        send_all(fd, request);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        conns[static_cast<std::size_t>(i)].fd = fd;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(i);
+        epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+    }
+    freeaddrinfo(addr);
+
+    using Clock = std::chrono::steady_clock;
+    Totals total, last;
+    auto start = Clock::now(), report = start + std::chrono::seconds(1);
+    std::vector<epoll_event> events(1024);
+    char buf[64 * 1024];
+
+    while (Clock::now() - start < std::chrono::seconds(seconds)) {
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), 100);
+        for (int e = 0; e < n; ++e) {
+            Viewer& v = conns[events[e].data.u64];
+            for (;;) {
+                ssize_t r = ::recv(v.fd, buf, sizeof(buf), 0);
+                if (r > 0) {
+                    v.in.append(buf, static_cast<std::size_t>(r));
+                    continue;
+                }
+                if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    epoll_ctl(ep, EPOLL_CTL_DEL, v.fd, nullptr);
+                    ::close(v.fd);
+                    total.closed++;
+                }
+                break;
+            }
+            if (!v.upgraded) {
+                auto end = v.in.find("\r\n\r\n");
+                if (end == std::string::npos) continue;
+                if (v.in.compare(0, 12, "HTTP/1.1 101") != 0) {
+                    std::cerr << "spectate_bench: " << v.in.substr(0, v.in.find("\r\n")) << "\n";
+                    return 1;
+                }
+                v.upgraded = true;
+                v.in.erase(0, end + 4);
+            }
+            parse_frames(v, total);
+        }
+
+        if (Clock::now() >= report) {
+            report += std::chrono::seconds(1);
+            uint64_t frames = total.frames - last.frames, bytes = total.bytes - last.bytes;
+            std::printf("%6llu frames/s  %8.2f MB/s  %6.2f frames/s per viewer  (%zu viewers, %llu closed)\n",
+                        static_cast<unsigned long long>(frames), bytes / 1e6,
+                        conns.empty() ? 0.0 : double(frames) / conns.size(), conns.size(),
+                        static_cast<unsigned long long>(total.closed));
+            std::fflush(stdout);
+            last = total;
+        }
+    }
+
+    std::printf("total: %llu frames, %.2f MB in %ds\n",
+                static_cast<unsigned long long>(total.frames), total.bytes / 1e6, seconds);
+    return 0;
+}
@@ -0,0 +1,103 @@
+// stats_bench — pushes stat deltas through StatsWriter into a Redis server
+// and reports end-to-end throughput
+//
+//   stats_bench [host:port] [deltas] [players] [threads] [flush_ms]
+//
+// Producers record `deltas` GOLD_EARNED deltas of 1 spread over `players`
+// fresh player ids (as simulation workers would), then the run waits until
+// the writer has flushed everything. The leaderboard is read back to check
+// every delta landed exactly once. Defaults: localhost:6379, 1000000
+// deltas, 1000 players, 4 threads, 100 ms.
+
+#include "storage/redis_client.h"
+#include "storage/stats_writer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+    std::string addr = argc > 1 ? argv[1] : "localhost:6379";
+    long deltas = argc > 2 ? std::stol(argv[2]) : 1'000'000;
+    int players = argc > 3 ? std::stoi(argv[3]) : 1000;
+    int threads = argc > 4 ? std::stoi(argv[4]) : 4;
+    int flush_ms = argc > 5 ? std::stoi(argv[5]) : 100;
+
+    auto colon = addr.find(':');
+    std::string host = addr.substr(0, colon);
+    int port = colon == std::string::npos ? 6379 : std::stoi(addr.substr(colon + 1));
+
+    // Fresh ids per run, so the read-back below only sees this run's writes
+    std::string run = "bench-" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+    std::vector<std::string> ids;
+    for (int i = 0; i < players; ++i) ids.push_back(run + "-" + std::to_string(i));
+
+    using Clock = std::chrono::steady_clock;
+    auto started = Clock::now();
+    uint64_t dropped = 0;
+    {
+        storage::StatsWriter writer({host, port, "", flush_ms, 1 << 16, static_cast<std::size_t>(players)});
+
+        std::vector<std::thread> producers;
+        std::vector<uint64_t> refused(static_cast<std::size_t>(threads));
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&, t] {
+                for (long i = t; i < deltas; i += threads) {
+                    // Full queue = writer behind. A tick would drop the delta;
+                    // the bench waits so every one is counted.
+                    while (!writer.record(ids[static_cast<std::size_t>(i % players)],
+                                          storage::Stat::GOLD_EARNED, 1)) {
+                        refused[static_cast<std::size_t>(t)]++;
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& p : producers) p.join();
+        auto pushed = Clock::now();
+        for (auto r : refused) dropped += r;
+
+        // Wait for the writer to drain and flush
+        for (;;) {
+            auto s = writer.to_json();
+            if (s["drained"] == s["recorded"] && s["pending_players"] == 0) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        auto done = Clock::now();
+        auto s = writer.to_json();
+
+        double push_s = std::chrono::duration<double>(pushed - started).count();
+        double total_s = std::chrono::duration<double>(done - started).count();
+        std::printf("pushed %ld deltas from %d threads in %.3fs (%.2f M/s, %llu full-queue retries)\n",
+                    deltas, threads, push_s, deltas / push_s / 1e6, static_cast<unsigned long long>(dropped));
+        std::printf("flushed in %.3fs total: %.2f M deltas/s end to end, %s commands, %s errors\n",
+                    total_s, deltas / total_s / 1e6, s["commands_sent"].dump().c_str(),
+                    s["command_errors"].dump().c_str());
+    }
+
+    // Every delta should be in the leaderboard exactly once
+    storage::RedisClient redis;
+    if (!redis.connect(host, port)) {
+        std::cerr << "stats_bench: cannot reconnect to verify\n";
+        return 1;
+    }
+    long long total = 0;
+    for (const auto& id : ids) {
+        if (auto r = redis.command({"ZSCORE", "leaderboard:gold", id}); r && r->type == storage::RedisReply::Type::STRING) {
+            total += std::stoll(r->str);
+        }
+    }
+    std::printf("leaderboard:gold holds %lld of %ld deltas\n", total, deltas);
+
+    // Leave no bench data behind
+    std::vector<std::vector<std::string>> cleanup;
+    for (const auto& id : ids) {
+        cleanup.push_back({"ZREM", "leaderboard:gold", id});
+        cleanup.push_back({"DEL", "player:" + id + ":stats"});
+    }
+    redis.pipeline(cleanup);
+    return total == deltas ? 0 : 1;
+}
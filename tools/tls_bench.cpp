@@ -0,0 +1,179 @@
+// tls_bench — measures TLS handshake throughput against a wss:// node, with
+// and without session resumption
+//
+//   tls_bench <host> <port> <handshakes> [threads] [--tls12]
+//
+// Each of `threads` (default 4) connects, handshakes, sends GET /health and
+// reads the response `handshakes` / threads times: first with full
+// handshakes, then resuming the session from its previous connection, as a
+// reconnecting client does. Prints handshakes/s, latency percentiles and
+// how many resumptions the server accepted. --tls12 caps the client at
+// TLS 1.2, which resumes by session ID instead of tickets. Certificates
+// are not verified, so a self-signed one works (see README → TLS).
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+addrinfo* g_addr = nullptr;
+std::string g_host;
+
+struct Result {
+    std::vector<double> latency_us;
+    uint64_t resumed = 0;
+    uint64_t failed = 0;
+};
+
+// One connection: TCP + TLS + GET /health. Returns false on failure;
+// `session` is what to offer (nullptr = full handshake) and is replaced by
+// the new connection's session.
+bool one(SSL_CTX* ctx, SSL_SESSION*& session, bool& reused) {
+    int fd = ::socket(g_addr->ai_family, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(fd, g_addr->ai_addr, g_addr->ai_addrlen) != 0) {
+        ::close(fd);
+        return false;
+    }
+    SSL* ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, g_host.c_str());
+    if (session) SSL_set_session(ssl, session);
+
+    bool ok = SSL_connect(ssl) == 1;
+    if (ok) {
+        std::string req = "GET /health HTTP/1.1\r\nHost: " + g_host + "\r\nConnection: close\r\n\r\n";
+        ok = SSL_write(ssl, req.data(), static_cast<int>(req.size())) > 0;
+        // Reading the response also takes in the TLS 1.3 session ticket
+        std::string in;
+        char buf[4096];
+        while (ok && in.find("\r\n\r\n") == std::string::npos) {
+            int n = SSL_read(ssl, buf, sizeof(buf));
+            if (n <= 0) break;
+            in.append(buf, static_cast<std::size_t>(n));
+        }
+        ok = ok && in.compare(0, 12, "HTTP/1.1 200") == 0;
+    }
+    if (ok) {
+        reused = SSL_session_reused(ssl);
+        if (session) SSL_SESSION_free(session);
+        session = SSL_get1_session(ssl);
+        SSL_shutdown(ssl);
+    }
+    SSL_free(ssl);
+    ::close(fd);
+    return ok;
+}
+
+void run(SSL_CTX* ctx, int count, bool resume, Result& out) {
+    SSL_SESSION* session = nullptr;
+    bool reused = false;
+    if (resume && !one(ctx, session, reused)) {
+        out.failed += static_cast<uint64_t>(count);
+        return;
+    }
+    out.latency_us.reserve(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        SSL_SESSION* offer = resume ? session : nullptr;
+        auto start = Clock::now();
+        bool ok = one(ctx, offer, reused);
+        auto us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        if (resume) {
+            session = offer;
+        } else if (offer) {
+            SSL_SESSION_free(offer);
+        }
+        if (!ok) {
+            out.failed++;
+            continue;
+        }
+        out.latency_us.push_back(us);
+        out.resumed += reused;
+    }
+    if (session) SSL_SESSION_free(session);
+}
+
+double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0;
+    auto k = static_cast<std::size_t>(p * static_cast<double>(v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(k), v.end());
+    return v[k];
+}
+
+void phase(SSL_CTX* ctx, const char* name, int handshakes, int threads, bool resume) {
+    std::vector<Result> results(static_cast<std::size_t>(threads));
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back(run, ctx, handshakes / threads, resume, std::ref(results[static_cast<std::size_t>(t)]));
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Result all;
+    for (auto& r : results) {
+        all.latency_us.insert(all.latency_us.end(), r.latency_us.begin(), r.latency_us.end());
+        all.resumed += r.resumed;
+        all.failed += r.failed;
+    }
+    auto done = all.latency_us.size();
+    std::printf("%-8s %8.0f handshakes/s  p50 %6.0f us  p99 %6.0f us  resumed %5.1f%%  failed %llu\n",
+                name, static_cast<double>(done) / secs, percentile(all.latency_us, 0.5),
+                percentile(all.latency_us, 0.99), done ? 100.0 * static_cast<double>(all.resumed) / static_cast<double>(done) : 0.0,
+                static_cast<unsigned long long>(all.failed));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: tls_bench <host> <port> <handshakes> [threads] [--tls12]\n";
+        return 2;
+    }
+    g_host = argv[1];
+    std::string port = argv[2];
+    int handshakes = std::stoi(argv[3]);
+    int threads = argc > 4 ? std::max(1, std::stoi(argv[4])) : 4;
+    bool tls12 = argc > 5 && std::string_view(argv[5]) == "--tls12";
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(g_host.c_str(), port.c_str(), &hints, &g_addr) != 0 || !g_addr) {
+        std::cerr << "tls_bench: cannot resolve " << g_host << "\n";
+        return 1;
+    }
+
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+    if (tls12) SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+
+    std::printf("%d handshakes per phase on %d threads, %s\n", handshakes, threads, tls12 ? "TLS 1.2" : "TLS 1.3");
+    phase(ctx, "full", handshakes, threads, false);
+    phase(ctx, "resumed", handshakes, threads, true);
+
+    SSL_CTX_free(ctx);
+    freeaddrinfo(g_addr);
+    return 0;
+}
@@ -0,0 +1,356 @@
+// udp_bench — plays a room over the UDP snapshot channel with injected
+// packet loss and reports what reached the clients
+//
+//   udp_bench <host> <port> <players> [seconds] [loss_pct] [--quiet-half]
+//
+// Joins `players` (default 2, the minimum to start a round) to a fresh room
+// with ?udp=1, binds each to the channel from its udp_offer, readies up and
+// sends an INPUT datagram every 50 ms for `seconds` (default 10). Each
+// datagram in either direction is dropped with probability loss_pct
+// (default 0). Prints per-client snapshot arrival: delivered, lost or
+// superseded (seq gaps), out of order, and the longest gap between two
+// snapshots, next to the game_state frames that arrived on the WebSocket.
+//
+// --quiet-half stops the first client's HELLO keepalives and inputs halfway
+// through, to watch its snapshots fall back to the WebSocket after
+// UDP_TIMEOUT_MS. Needs a node with UDP_PORT set and without JWT (dev mode).
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Wire constants of network/datagrams.h, repeated so the tool builds alone
+constexpr uint8_t HELLO = 0x10, HELLO_ACK = 0x11, SNAPSHOT = 0x20, INPUT = 0x21;
+constexpr uint8_t LEFT = 1, RIGHT = 2;
+
+struct Client {
+    int ws = -1;
+    int udp = -1;
+    std::string in;
+    std::string token;          // 16 raw bytes
+    bool offered = false;
+    bool active = false;        // udp_state
+    bool quiet = false;         // --quiet-half: stopped talking
+    int tick = 0;               // newest snapshot tick seen
+    uint32_t input_seq = 0;
+
+    bool any_snapshot = false;
+    uint32_t last_seq = 0;
+    Clock::time_point last_at{};
+    uint64_t delivered = 0, lost = 0, out_of_order = 0;
+    uint64_t ws_snapshots = 0, ws_after_quiet = 0;
+    double max_gap_ms = 0;
+};
+
+std::mt19937 g_rng{std::random_device{}()};
+double g_loss = 0.0;
+
+bool lose() { return g_loss > 0 && std::uniform_real_distribution<double>(0, 1)(g_rng) < g_loss; }
+
+void send_all(int fd, const std::string& s) {
+    std::size_t off = 0;
+    while (off < s.size()) {
+        ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        off += static_cast<std::size_t>(n);
+    }
+}
+
+std::string read_headers(int fd, std::string& in) {
+    char buf[4096];
+    std::size_t end;
+    while ((end = in.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return "";
+        in.append(buf, static_cast<std::size_t>(n));
+    }
+    std::string status = in.substr(0, in.find("\r\n"));
+    in.erase(0, end + 4);
+    return status;
+}
+
+// Client frames must be masked; an all-zero mask leaves the payload as is
+void send_frame(int fd, uint8_t opcode, std::string_view payload) {
+    std::string f;
+    f.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+        f.push_back(static_cast<char>(0x80 | payload.size()));
+    } else {
+        f.push_back(static_cast<char>(0x80 | 126));
+        f.push_back(static_cast<char>(payload.size() >> 8));
+        f.push_back(static_cast<char>(payload.size() & 0xFF));
+    }
+    f.append(4, '\0');
+    f.append(payload);
+    send_all(fd, f);
+}
+
+int hex_digit(char c) { return c <= '9' ? c - '0' : c - 'a' + 10; }
+
+int open_udp(const std::string& host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* a = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &a) != 0 || !a) return -1;
+    int fd = ::socket(a->ai_family, SOCK_DGRAM, 0);
+    if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(a);
+    if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+void send_datagram(Client& c, const std::string& d) {
+    if (c.udp < 0 || lose()) return;
+    ::send(c.udp, d.data(), d.size(), 0);
+}
+
+void send_hello(Client& c) {
+    std::string d(1, static_cast<char>(HELLO));
+    d += c.token;
+    send_datagram(c, d);
+}
+
+void send_input(Client& c, uint8_t actions) {
+    std::string d(1, static_cast<char>(INPUT));
+    auto put = [&](uint32_t v) {
+        for (int i = 0; i < 4; ++i) d.push_back(static_cast<char>(v >> (8 * i)));
+    };
+    put(++c.input_seq);
+    put(static_cast<uint32_t>(c.tick));
+    d.push_back(static_cast<char>(actions));
+    send_datagram(c, d);
+}
+
+void on_text(Client& c, std::string_view text, const std::string& host) {
+    auto j = nlohmann::json::parse(text, nullptr, false);
+    if (j.is_discarded() || !j.contains("type")) return;
+    const auto& type = j["type"].get_ref<const std::string&>();
+    if (type == "udp_offer") {
+        auto hex = j["token"].get<std::string>();
+        c.token.clear();
+        for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+            c.token.push_back(static_cast<char>(hex_digit(hex[i]) << 4 | hex_digit(hex[i + 1])));
+        }
+        c.udp = open_udp(host, j["port"].get<int>());
+        c.offered = c.udp >= 0;
+    } else if (type == "udp_state") {
+        c.active = j["active"].get<bool>();
+    } else if (type == "game_state") {
+        c.ws_snapshots++;
+        if (c.quiet) c.ws_after_quiet++;
+        c.tick = j.value("tick", c.tick);
+    }
+}
+
+// Consumes complete server frames: JSON text, pings
+void read_ws(Client& c, const std::string& host) {
+    char buf[16 * 1024];
+    for (;;) {
+        ssize_t r = ::recv(c.ws, buf, sizeof(buf), 0);
+        if (r <= 0) break;
+        c.in.append(buf, static_cast<std::size_t>(r));
+    }
+    std::size_t pos = 0;
+    for (;;) {
+        if (c.in.size() - pos < 2) break;
+        auto b0 = static_cast<uint8_t>(c.in[pos]);
+        auto b1 = static_cast<uint8_t>(c.in[pos + 1]);
+        uint64_t len = b1 & 0x7F;
+        std::size_t header = 2;
+        if (len == 126) {
+            if (c.in.size() - pos < 4) break;
+            len = (uint64_t(uint8_t(c.in[pos + 2])) << 8) | uint8_t(c.in[pos + 3]);
+            header = 4;
+        } else if (len == 127) {
+            if (c.in.size() - pos < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; ++i) len = (len << 8) | uint8_t(c.in[pos + 2 + i]);
+            header = 10;
+        }
+        if (c.in.size() - pos < header + len) break;
+        std::string_view payload = std::string_view(c.in).substr(pos + header, len);
+        if ((b0 & 0x0F) == 0x9) send_frame(c.ws, 0xA, payload);
+        if ((b0 & 0x0F) == 0x1) on_text(c, payload, host);
+        pos += header + len;
+    }
+    c.in.erase(0, pos);
+}
+
+void read_udp(Client& c, Clock::time_point now) {
+    if (c.udp < 0) return;
+    char buf[2048];
+    for (;;) {
+        ssize_t n = ::recv(c.udp, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        if (lose()) continue;
+        auto kind = static_cast<uint8_t>(buf[0]);
+        if (kind == HELLO_ACK) continue;
+        if (kind != SNAPSHOT || n < 5) continue;
+        uint32_t seq = 0;
+        for (int i = 0; i < 4; ++i) seq |= uint32_t(uint8_t(buf[1 + i])) << (8 * i);
+        if (c.any_snapshot && static_cast<int32_t>(seq - c.last_seq) <= 0) {
+            c.out_of_order++;
+            continue;
+        }
+        if (c.any_snapshot) {
+            c.lost += seq - c.last_seq - 1;
+            c.max_gap_ms = std::max(c.max_gap_ms,
+                std::chrono::duration<double, std::milli>(now - c.last_at).count());
+        }
+        c.any_snapshot = true;
+        c.last_seq = seq;
+        c.last_at = now;
+        c.delivered++;
+
+        auto j = nlohmann::json::parse(std::string_view(buf + 5, static_cast<std::size_t>(n - 5)), nullptr, false);
+        if (!j.is_discarded()) c.tick = j.value("tick", c.tick);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: udp_bench <host> <port> <players> [seconds] [loss_pct] [--quiet-half]\n";
+        return 2;
+    }
+    std::string host = argv[1], port = argv[2];
+    int players = std::max(2, std::stoi(argv[3]));
+    int seconds = argc > 4 ? std::stoi(argv[4]) : 10;
+    g_loss = argc > 5 ? std::stod(argv[5]) / 100.0 : 0.0;
+    bool quiet_half = argc > 6 && std::string_view(argv[6]) == "--quiet-half";
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addr = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addr) != 0 || !addr) {
+        std::cerr << "udp_bench: cannot resolve " << host << "\n";
+        return 1;
+    }
+
+    std::string room = "udp" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count() % 1000000);
+    std::vector<Client> clients(static_cast<std::size_t>(players));
+    for (auto& c : clients) {
+        c.ws = ::socket(addr->ai_family, SOCK_STREAM, 0);
+        if (c.ws < 0 || ::connect(c.ws, addr->ai_addr, addr->ai_addrlen) != 0) {
+            std::cerr << "udp_bench: connect failed: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        send_all(c.ws, "GET /ws/" + room + "?udp=1 HTTP/1.1\r\n"
+                       "Host: " + host + ":" + port + "\r\n"
+                       "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                       "Sec-WebSocket-Version: 13\r\n\r\n");
+        std::string status = read_headers(c.ws, c.in);
+        if (status.compare(0, 12, "HTTP/1.1 101") != 0) {
+            std::cerr << "udp_bench: handshake refused: " << status << "\n";
+            return 1;
+        }
+        fcntl(c.ws, F_SETFL, fcntl(c.ws, F_GETFL) | O_NONBLOCK);
+    }
+    freeaddrinfo(addr);
+
+    // Bind every client before the round starts
+    auto deadline = Clock::now() + std::chrono::seconds(3);
+    auto next_hello = Clock::now();
+    while (Clock::now() < deadline) {
+        bool all = true;
+        for (auto& c : clients) {
+            read_ws(c, host);
+            read_udp(c, Clock::now());
+            all = all && c.active;
+        }
+        if (all) break;
+        if (Clock::now() >= next_hello) {
+            for (auto& c : clients) {
+                if (c.offered && !c.active) send_hello(c);
+            }
+            next_hello = Clock::now() + std::chrono::milliseconds(100);
+        }
+        ::poll(nullptr, 0, 5);
+    }
+    for (auto& c : clients) {
+        if (!c.offered) {
+            std::cerr << "udp_bench: no udp_offer — is UDP_PORT set on the server?\n";
+            return 1;
+        }
+        if (!c.active) std::cerr << "udp_bench: a client never bound, continuing on the WebSocket\n";
+        send_frame(c.ws, 0x1, R"({"type":"player_ready","ready":true})");
+    }
+
+    auto started = Clock::now();
+    auto until = started + std::chrono::seconds(seconds);
+    auto quiet_at = started + std::chrono::milliseconds(seconds * 500);
+    auto next_input = started;
+    next_hello = started;
+    uint8_t actions = RIGHT;
+    while (Clock::now() < until) {
+        auto now = Clock::now();
+        if (quiet_half && !clients[0].quiet && now >= quiet_at) clients[0].quiet = true;
+        if (now >= next_input) {
+            // Walk back and forth so snapshots keep changing
+            if ((now - started) / std::chrono::seconds(1) % 2) actions = LEFT;
+            else actions = RIGHT;
+            for (auto& c : clients) {
+                if (!c.quiet) send_input(c, actions);
+            }
+            next_input += std::chrono::milliseconds(50);
+        }
+        if (now >= next_hello) {
+            for (auto& c : clients) {
+                if (!c.quiet) send_hello(c);
+            }
+            next_hello += std::chrono::milliseconds(500);
+        }
+        for (auto& c : clients) {
+            read_ws(c, host);
+            read_udp(c, now);
+        }
+        ::poll(nullptr, 0, 1);
+    }
+
+    std::printf("%d clients, %d s, %.1f%% loss each way%s\n", players, seconds, g_loss * 100,
+                quiet_half ? ", client 0 quiet from halfway" : "");
+    std::printf("client  udp_snapshots  lost/superseded  out_of_order  max_gap_ms  ws_snapshots  udp_active\n");
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        const auto& c = clients[i];
+        std::printf("%6zu  %13llu  %15llu  %12llu  %10.1f  %12llu  %10s\n", i,
+                    static_cast<unsigned long long>(c.delivered),
+                    static_cast<unsigned long long>(c.lost),
+                    static_cast<unsigned long long>(c.out_of_order), c.max_gap_ms,
+                    static_cast<unsigned long long>(c.ws_snapshots), c.active ? "yes" : "no");
+    }
+    if (quiet_half) {
+        std::printf("client 0: %llu snapshots on the WebSocket after going quiet\n",
+                    static_cast<unsigned long long>(clients[0].ws_after_quiet));
+    }
+
+    for (auto& c : clients) {
+        if (c.udp >= 0) ::close(c.udp);
+        ::close(c.ws);
+    }
+    return 0;
+}